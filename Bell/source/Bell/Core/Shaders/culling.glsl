@@ -0,0 +1,90 @@
+//Shared by the culling shaders, see Render/culling.h
+
+//vkMesh::InstanceData
+struct InstanceData
+{
+	mat4 transform;
+	vec4 color;
+	vec4 boundsMin;
+	vec4 boundsExtent;
+	uint materialIndex;
+	uint drawIndex;
+	uint padding0;
+	uint padding1;
+};
+
+//VkDrawIndexedIndirectCommand
+struct DrawCommand
+{
+	uint indexCount;
+	uint instanceCount;
+	uint firstIndex;
+	int vertexOffset;
+	uint firstInstance;
+};
+
+//Scales a bounding sphere by the transform's largest axis
+float max_scale(mat4 transform)
+{
+	return max(max(length(transform[0].xyz), length(transform[1].xyz)), length(transform[2].xyz));
+}
+
+//Gribb-Hartmann planes for Vulkan's 0 to 1 clip depth, normals point inwards
+bool in_frustum(mat4 viewProjection, vec3 center, float radius)
+{
+	mat4 rows = transpose(viewProjection);
+	vec4 planes[6] = vec4[6](rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1], rows[2], rows[3] - rows[2]);
+	for (int i = 0; i < 6; i++)
+	{
+		if (dot(planes[i].xyz, center) + planes[i].w < -radius * length(planes[i].xyz))
+			return false;
+	}
+	return true;
+}
+
+//Hidden when the nearest point of the sphere's box is behind the farthest depth under its screen rectangle
+bool occluded(sampler2D depthPyramid, mat4 viewProjection, vec3 center, float radius)
+{
+	vec2 rectangleMin = vec2(1.0);
+	vec2 rectangleMax = vec2(0.0);
+	float nearest = 1.0;
+	for (int i = 0; i < 8; i++)
+	{
+		vec3 corner = center + radius * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+		vec4 clip = viewProjection * vec4(corner, 1.0);
+
+		//Reaching past the near plane, nothing can be said
+		if (clip.w <= 0.0 || clip.z < 0.0)
+			return false;
+
+		vec3 ndc = clip.xyz / clip.w;
+		vec2 uv = ndc.xy * 0.5 + 0.5;
+		rectangleMin = min(rectangleMin, uv);
+		rectangleMax = max(rectangleMax, uv);
+		nearest = min(nearest, ndc.z);
+	}
+	rectangleMin = clamp(rectangleMin, 0.0, 1.0);
+	rectangleMax = clamp(rectangleMax, 0.0, 1.0);
+
+	//The finest level where the rectangle touches at most two texels each way
+	int levels = textureQueryLevels(depthPyramid);
+	vec2 extent = (rectangleMax - rectangleMin) * vec2(textureSize(depthPyramid, 0));
+	int level = clamp(int(ceil(log2(max(max(extent.x, extent.y), 1.0)))), 0, levels - 1);
+	ivec2 first, last;
+	for (;; level++)
+	{
+		ivec2 size = textureSize(depthPyramid, level);
+		first = min(ivec2(rectangleMin * vec2(size)), size - 1);
+		last = min(ivec2(rectangleMax * vec2(size)), size - 1);
+		if (all(lessThanEqual(last - first, ivec2(1))) || level == levels - 1)
+			break;
+	}
+
+	float farthest = 0.0;
+	for (int y = first.y; y <= last.y; y++)
+	{
+		for (int x = first.x; x <= last.x; x++)
+			farthest = max(farthest, texelFetch(depthPyramid, ivec2(x, y), level).r);
+	}
+	return nearest > farthest;
+}
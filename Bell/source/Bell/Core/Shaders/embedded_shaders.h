@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <atomic>
+#include <algorithm>
+
+namespace vkUtil
+{
+	/*
+	* SPIR-V compiled into the executable. shader_embed.py runs before every build, compiles every
+	* shader under this directory to Embedded/<path>.inc and writes the table of them, keyed by the
+	* path relative to this directory. A checkout that hasn't been built yet has no table, the
+	* shaders are then loaded from disk like before.
+	*/
+	struct EmbeddedShader
+	{
+		const char* name;
+		const uint32_t* code;
+		size_t wordCount;
+	};
+
+#if __has_include("Embedded/embedded_shaders.inc")
+#include "Embedded/embedded_shaders.inc"
+#else
+	constexpr EmbeddedShader embeddedShaders[] = { { nullptr, nullptr, 0 } };
+#endif
+
+	//Where the table's paths are relative to, shaders are loaded from somewhere under the working directory
+	constexpr const char* embeddedShaderRoot = "Core/Shaders/";
+
+	//Switched off for hot reload, the files on disk are then the ones being edited
+	std::atomic<bool>& embedded_shaders_enabled()
+	{
+		static std::atomic<bool> enabled{ true };
+		return enabled;
+	}
+
+	//The embedded build of a shader file, null when it has none or embedded shaders are off
+	const EmbeddedShader* find_embedded_shader(const std::string& filename)
+	{
+		if (!embedded_shaders_enabled())
+			return nullptr;
+
+		std::string name = filename;
+		std::replace(name.begin(), name.end(), '\\', '/');
+		size_t root = name.rfind(embeddedShaderRoot);
+		if (root == std::string::npos)
+			return nullptr;
+		name.erase(0, root + std::char_traits<char>::length(embeddedShaderRoot));
+
+		for (const EmbeddedShader& shader : embeddedShaders)
+		{
+			if (shader.name && name == shader.name)
+				return &shader;
+		}
+		return nullptr;
+	}
+}
@@ -0,0 +1,37 @@
+#version 450
+
+layout(location = 0) in vec3 vertexPosition;
+layout(location = 1) in vec3 vertexNormal;
+layout(location = 2) in vec2 vertexTexCoord;
+layout(location = 3) in vec4 vertexTangent;
+
+//vkMesh::InstanceData, binding 1 at instance rate
+layout(location = 4) in vec4 instanceTransform0;
+layout(location = 5) in vec4 instanceTransform1;
+layout(location = 6) in vec4 instanceTransform2;
+layout(location = 7) in vec4 instanceTransform3;
+layout(location = 8) in vec4 instanceColor;
+
+layout(push_constant) uniform constants
+{
+	mat4 viewProjection;
+} ObjectData;
+
+//Material features, vkMesh::MaterialFeatures bit i is constant_id i
+layout(constant_id = 0) const bool featureLighting = true;
+
+layout(location = 0) out vec3 fragColor;
+
+const vec3 sunDirection = normalize(vec3(0.4, 1.0, 0.6));
+
+void main()
+{
+	//Instances are placed with rotation and uniform scale, so the transform's upper 3x3 works for normals
+	mat4 instanceTransform = mat4(instanceTransform0, instanceTransform1, instanceTransform2, instanceTransform3);
+	vec3 normal = normalize(mat3(instanceTransform) * vertexNormal);
+
+	gl_Position = ObjectData.viewProjection * instanceTransform * vec4(vertexPosition, 1.0);
+
+	float light = featureLighting ? 0.25 + 0.75 * max(dot(normal, sunDirection), 0.0) : 1.0;
+	fragColor = (0.5 + 0.5 * normal) * light * instanceColor.rgb;
+}
@@ -0,0 +1,51 @@
+#version 450
+
+//QuantizedVertex, see Model/mesh_quantize.h
+layout(location = 0) in vec4 vertexPosition;
+layout(location = 1) in vec2 vertexNormal;
+layout(location = 2) in vec2 vertexTexCoord;
+layout(location = 3) in vec2 vertexTangent;
+
+//vkMesh::InstanceData, binding 1 at instance rate
+layout(location = 4) in vec4 instanceTransform0;
+layout(location = 5) in vec4 instanceTransform1;
+layout(location = 6) in vec4 instanceTransform2;
+layout(location = 7) in vec4 instanceTransform3;
+layout(location = 8) in vec4 instanceColor;
+layout(location = 9) in vec4 instanceBoundsMin;
+layout(location = 10) in vec4 instanceBoundsExtent;
+
+layout(push_constant) uniform constants
+{
+	mat4 viewProjection;
+} ObjectData;
+
+//Material features, vkMesh::MaterialFeatures bit i is constant_id i
+layout(constant_id = 0) const bool featureLighting = true;
+
+layout(location = 0) out vec3 fragColor;
+
+const vec3 sunDirection = normalize(vec3(0.4, 1.0, 0.6));
+
+vec3 octahedral_decode(vec2 encoded)
+{
+	vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float fold = max(-direction.z, 0.0);
+	direction.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(direction.xy, vec2(0.0)));
+	return normalize(direction);
+}
+
+void main()
+{
+	vec3 position = instanceBoundsMin.xyz + vertexPosition.xyz * instanceBoundsExtent.xyz;
+	vec4 tangent = vec4(octahedral_decode(vertexTangent), vertexPosition.w * 2.0 - 1.0);
+
+	//Instances are placed with rotation and uniform scale, so the transform's upper 3x3 works for normals
+	mat4 instanceTransform = mat4(instanceTransform0, instanceTransform1, instanceTransform2, instanceTransform3);
+	vec3 normal = normalize(mat3(instanceTransform) * octahedral_decode(vertexNormal));
+
+	gl_Position = ObjectData.viewProjection * instanceTransform * vec4(position, 1.0);
+
+	float light = featureLighting ? 0.25 + 0.75 * max(dot(normal, sunDirection), 0.0) : 1.0;
+	fragColor = (0.5 + 0.5 * normal) * light * instanceColor.rgb;
+}
@@ -1,2 +1,7 @@
-C:\VulkanSDK\1.3.243.0\Bin\glslc.exe shader.vert -o vertex.spv
-C:\VulkanSDK\1.3.243.0\Bin\glslc.exe shader.frag -o fragment.spv
\ No newline at end of file
+"%VULKAN_SDK%\Bin\glslc.exe" shader.vert -O -o vertex.spv
+"%VULKAN_SDK%\Bin\glslc.exe" shader.frag -O -o fragment.spv
+"%VULKAN_SDK%\Bin\glslc.exe" mesh.vert -O -o mesh_vertex.spv
+"%VULKAN_SDK%\Bin\glslc.exe" mesh_quantized.vert -O -o mesh_quantized_vertex.spv
+"%VULKAN_SDK%\Bin\glslc.exe" cull_instances.comp -O -o cull_instances.spv
+"%VULKAN_SDK%\Bin\glslc.exe" depth_pyramid.comp -O -o depth_pyramid.spv
+"%VULKAN_SDK%\Bin\glslc.exe" cull_clusters.comp -O -o cull_clusters.spv
\ No newline at end of file
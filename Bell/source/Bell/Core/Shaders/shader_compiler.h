@@ -0,0 +1,260 @@
+#pragma once
+#include <Engine/config.h>
+#include <Core/hash.h>
+#include <Core/mapped_file.h>
+#include "shader_optimizer.h"
+#include <shaderc/shaderc.hpp>
+#include <filesystem>
+#include <thread>
+#include <memory>
+#include <cstring>
+
+namespace vkUtil
+{
+	/*
+	* Runtime GLSL to SPIR-V through shaderc. Results are cached on disk under a hash of
+	* everything that affects the output: the source, every file it includes, the defines
+	* and the compiler settings, so an unchanged shader is never compiled twice. What's cached
+	* is the module after optimize_spirv.
+	*/
+	constexpr const char* shaderCacheDirectory = "./shader_cache/";
+
+	//Bump when the compile options below change, it invalidates every cached binary
+	constexpr uint32_t shaderCompilerVersion = 2;
+
+	//False only when the file can't be read, an empty file reads as an empty string
+	bool read_text_file(const std::string& filename, std::string& text)
+	{
+		text.clear();
+		std::error_code error;
+		if (!std::filesystem::is_regular_file(filename, error))
+			return false;
+		if (std::filesystem::file_size(filename, error) == 0 && !error)
+			return true;
+
+		MappedFile file(filename);
+		if (!file.is_open())
+			return false;
+		text.assign(file.data(), file.size());
+		return true;
+	}
+
+	std::string read_text_file(const std::string& filename)
+	{
+		std::string text;
+		read_text_file(filename, text);
+		return text;
+	}
+
+	constexpr uint32_t spirvMagic = 0x07230203;
+
+	//Whole words, a full five word header and the magic number, anything else isn't worth handing to Vulkan
+	bool is_spirv_binary(const void* data, size_t size)
+	{
+		if (size < 5 * sizeof(uint32_t) || size % sizeof(uint32_t) != 0)
+			return false;
+		uint32_t magic;
+		memcpy(&magic, data, sizeof(magic));
+		return magic == spirvMagic;
+	}
+
+	std::string shader_directory(const std::string& filename)
+	{
+		size_t slash = filename.find_last_of("/\\");
+		return slash == std::string::npos ? std::string() : filename.substr(0, slash + 1);
+	}
+
+	//Include paths are resolved next to the including file, then relative to the working directory
+	std::string resolve_shader_include(const std::string& requested, const std::string& includingFile)
+	{
+		std::string sibling = shader_directory(includingFile) + requested;
+		if (std::filesystem::exists(sibling))
+			return sibling;
+		return requested;
+	}
+
+	shaderc_shader_kind shader_kind(const std::string& filename)
+	{
+		std::string extension = std::filesystem::path(filename).extension().string();
+		if (extension == ".vert") return shaderc_vertex_shader;
+		if (extension == ".frag") return shaderc_fragment_shader;
+		if (extension == ".comp") return shaderc_compute_shader;
+		if (extension == ".geom") return shaderc_geometry_shader;
+		if (extension == ".tesc") return shaderc_tess_control_shader;
+		if (extension == ".tese") return shaderc_tess_evaluation_shader;
+		return shaderc_glsl_infer_from_source;
+	}
+
+	//Fold a file and everything it #includes into the hash, each file once
+	uint64_t hash_shader_source(const std::string& filename, uint64_t seed, std::vector<std::string>& visited)
+	{
+		std::error_code error;
+		std::string canonical = std::filesystem::weakly_canonical(filename, error).string();
+		for (const std::string& seen : visited)
+		{
+			if (seen == canonical)
+				return seed;
+		}
+		visited.push_back(canonical);
+
+		std::string source = read_text_file(filename);
+		uint64_t hash = hash_string(source, hash_string(filename, seed));
+
+		std::istringstream lines(source);
+		std::string line;
+		while (std::getline(lines, line))
+		{
+			size_t directive = line.find_first_not_of(" \t");
+			if (directive == std::string::npos || line.compare(directive, 8, "#include") != 0)
+				continue;
+
+			size_t open = line.find_first_of("\"<", directive + 8);
+			size_t close = open == std::string::npos ? std::string::npos : line.find_first_of("\">", open + 1);
+			if (close == std::string::npos)
+				continue;
+
+			std::string included = resolve_shader_include(line.substr(open + 1, close - open - 1), filename);
+			hash = hash_shader_source(included, hash, visited);
+		}
+		return hash;
+	}
+
+	//Canonical paths of a shader and everything it includes, for watching them
+	std::vector<std::string> shader_source_files(const std::string& filename)
+	{
+		std::vector<std::string> visited;
+		hash_shader_source(filename, fnvOffsetBasis, visited);
+		return visited;
+	}
+
+	//Key of the cached binary, defines are "NAME" or "NAME=VALUE"
+	uint64_t shader_cache_key(const std::string& filename, const std::vector<std::string>& defines)
+	{
+		std::vector<std::string> visited;
+		uint64_t hash = hash_value(shaderCompilerVersion);
+		hash = hash_shader_source(filename, hash, visited);
+		for (const std::string& define : defines)
+			hash = hash_string(define, hash_string("\n", hash));
+		return hash;
+	}
+
+	std::string shader_cache_path(uint64_t key)
+	{
+		std::ostringstream path;
+		path << shaderCacheDirectory << std::hex << key << ".spv";
+		return path.str();
+	}
+
+	class ShaderIncluder : public shaderc::CompileOptions::IncluderInterface
+	{
+	public:
+
+		shaderc_include_result* GetInclude(const char* requestedSource, shaderc_include_type /*type*/, const char* requestingSource, size_t /*includeDepth*/) override
+		{
+			IncludeData* data = new IncludeData;
+			data->name = resolve_shader_include(requestedSource, requestingSource);
+			if (!read_text_file(data->name, data->content))
+			{
+				//An empty name tells shaderc the include failed, the content is the error message
+				data->content = "Unable to open include \"" + std::string(requestedSource) + "\"";
+				data->name.clear();
+			}
+
+			data->result.source_name = data->name.c_str();
+			data->result.source_name_length = data->name.size();
+			data->result.content = data->content.c_str();
+			data->result.content_length = data->content.size();
+			data->result.user_data = data;
+			return &data->result;
+		}
+
+		void ReleaseInclude(shaderc_include_result* result) override
+		{
+			delete static_cast<IncludeData*>(result->user_data);
+		}
+
+	private:
+
+		//Owns the strings the result points at until ReleaseInclude
+		struct IncludeData
+		{
+			shaderc_include_result result;
+			std::string name;
+			std::string content;
+		};
+	};
+
+	//Compile a GLSL file, or fetch it from the shader cache, returns no words on failure
+	std::vector<uint32_t> compile_glsl(const std::string& filename, const std::vector<std::string>& defines, bool debug)
+	{
+		uint64_t key = shader_cache_key(filename, defines);
+		std::string cachePath = shader_cache_path(key);
+
+		//A damaged entry is compiled again and overwritten
+		MappedFile cached(cachePath);
+		if (cached.is_open() && is_spirv_binary(cached.data(), cached.size()))
+		{
+			std::vector<uint32_t> code(cached.size() / sizeof(uint32_t));
+			memcpy(code.data(), cached.data(), cached.size());
+			return code;
+		}
+		//Unmapped before the entry is replaced below, Windows won't rename over a mapped file
+		cached.close();
+
+		std::string source;
+		if (!read_text_file(filename, source))
+		{
+			if (debug)
+				std::cout << "Failed to load \"" << filename << "\"" << std::endl;
+			return {};
+		}
+
+		shaderc::CompileOptions options;
+		options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_1);
+		options.SetSourceLanguage(shaderc_source_language_glsl);
+		options.SetIncluder(std::make_unique<ShaderIncluder>());
+		for (const std::string& define : defines)
+		{
+			size_t equals = define.find('=');
+			if (equals == std::string::npos)
+				options.AddMacroDefinition(define);
+			else
+				options.AddMacroDefinition(define.substr(0, equals), define.substr(equals + 1));
+		}
+
+		shaderc::Compiler compiler;
+		shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(source, shader_kind(filename), filename.c_str(), options);
+		if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+		{
+			if (debug)
+				std::cout << "Failed to compile \"" << filename << "\":\n" << result.GetErrorMessage() << std::endl;
+			return {};
+		}
+
+		std::vector<uint32_t> code = optimize_spirv(std::vector<uint32_t>(result.cbegin(), result.cend()), filename, debug);
+
+		//Pipelines compile on several threads, so each writer gets its own temporary file before the rename.
+		//Only a complete write replaces the cache entry
+		std::error_code error;
+		std::filesystem::create_directories(shaderCacheDirectory, error);
+		std::ostringstream temporaryPath;
+		temporaryPath << cachePath << "." << std::this_thread::get_id() << ".tmp";
+		bool written = false;
+		{
+			std::ofstream file(temporaryPath.str(), std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(code.data()), code.size() * sizeof(uint32_t));
+			file.flush();
+			written = file.good();
+		}
+		if (written)
+			std::filesystem::rename(temporaryPath.str(), cachePath, error);
+		if (!written || error)
+		{
+			if (debug)
+				std::cout << "Failed to write shader cache \"" << cachePath << "\"" << std::endl;
+			std::filesystem::remove(temporaryPath.str(), error);
+		}
+
+		return code;
+	}
+}
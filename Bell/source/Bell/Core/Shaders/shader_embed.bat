@@ -0,0 +1,17 @@
+@echo off
+rem Compiles every shader into Embedded\, shader_embed.py does the work so other platforms can run it directly.
+rem Runs as a pre-build step, so the shipped binary carries the shaders that were current when it was built.
+rem -O runs the same spirv-opt performance passes the runtime compiler does, see shader_optimizer.h.
+rem Without Python nothing is embedded and the shaders load from disk, so the build goes on.
+where py >nul 2>nul
+if %errorlevel% == 0 (
+	py -3 "%~dp0shader_embed.py"
+	exit /b
+)
+where python >nul 2>nul
+if %errorlevel% == 0 (
+	python "%~dp0shader_embed.py"
+	exit /b
+)
+echo shader_embed: warning: Python not found, shaders will load from disk
+exit /b 0
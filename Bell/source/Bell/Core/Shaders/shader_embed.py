@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+# Compiles every shader under this directory into a C initializer list of SPIR-V words and writes
+# Embedded/embedded_shaders.inc, the table embedded_shaders.h includes. Entries are keyed by the
+# path relative to this directory, so shaders in subdirectories can share a file name.
+# Runs as a pre-build step through shader_embed.bat, or by hand on any platform.
+# glslc comes from $VULKAN_SDK when it's set, otherwise from PATH.
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+stages = (".vert", ".frag", ".comp")
+
+
+def find_glslc():
+	sdk = os.environ.get("VULKAN_SDK")
+	if sdk:
+		for folder in ("Bin", "bin"):
+			for name in ("glslc.exe", "glslc"):
+				path = os.path.join(sdk, folder, name)
+				if os.path.isfile(path):
+					return path
+	return shutil.which("glslc")
+
+
+def find_shaders(root):
+	shaders = []
+	for folder, folders, files in os.walk(root):
+		folders[:] = sorted(f for f in folders if f != "Embedded")
+		for name in sorted(files):
+			if name.endswith(stages):
+				shaders.append(os.path.relpath(os.path.join(folder, name), root).replace(os.sep, "/"))
+	return shaders
+
+
+#Only touch files whose contents changed, so an unchanged shader doesn't rebuild everything
+def write_if_changed(path, text):
+	if os.path.isfile(path):
+		with open(path, "r", newline="") as file:
+			if file.read() == text:
+				return
+	with open(path, "w", newline="\n") as file:
+		file.write(text)
+
+
+def main():
+	root = os.path.dirname(os.path.abspath(__file__))
+	output = os.path.join(root, "Embedded")
+
+	#Without glslc nothing is embedded and every shader loads from disk, which isn't worth failing the build over
+	glslc = find_glslc()
+	if glslc is None:
+		print("shader_embed: warning: glslc not found, set VULKAN_SDK or put it on PATH. Shaders will load from disk", file=sys.stderr)
+	shaders = find_shaders(root) if glslc else []
+
+	table = ["//Generated by shader_embed.py, do not edit\n"]
+	entries = []
+	os.makedirs(output, exist_ok=True)
+	for shader in shaders:
+		include = shader + ".inc"
+		target = os.path.join(output, include)
+		os.makedirs(os.path.dirname(target), exist_ok=True)
+		compiled = subprocess.run([glslc, os.path.join(root, shader), "--target-env=vulkan1.1", "-O", "-mfmt=c", "-o", "-"],
+			stdout=subprocess.PIPE, universal_newlines=True)
+		if compiled.returncode != 0:
+			return compiled.returncode
+		write_if_changed(target, compiled.stdout)
+
+		symbol = "embeddedShader_" + re.sub(r"\W", "_", shader)
+		table.append("constexpr uint32_t %s[] =\n#include \"%s\"\n;\n" % (symbol, include))
+		entries.append("\t{ \"%s\", %s, sizeof(%s) / sizeof(uint32_t) },\n" % (shader, symbol, symbol))
+
+	table.append("\nconstexpr EmbeddedShader embeddedShaders[] =\n{\n")
+	table.extend(entries)
+	table.append("\t{ nullptr, nullptr, 0 }\n};\n")
+	write_if_changed(os.path.join(output, "embedded_shaders.inc"), "".join(table))
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
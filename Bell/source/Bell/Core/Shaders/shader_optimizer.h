@@ -0,0 +1,124 @@
+#pragma once
+#include <Engine/config.h>
+#include <spirv-tools/libspirv.h>
+#include <mutex>
+
+namespace vkUtil
+{
+	/*
+	* spirv-opt's performance pass set (the same one as spirv-opt -O and glslc -O): inlining,
+	* dead code and dead branch elimination, constant folding, strength reduction and so on.
+	* Smaller modules are quicker for the driver to compile and the code it gets is already
+	* simplified, which its own compiler doesn't always manage. Only SPIRV-Tools-shared is
+	* linked, so this goes through its C API rather than spvtools::Optimizer.
+	*/
+	struct ShaderOptimizationStatistics
+	{
+		uint32_t moduleCount{ 0 };
+		uint64_t bytesBefore{ 0 };
+		uint64_t bytesAfter{ 0 };
+		uint64_t instructionsBefore{ 0 };
+		uint64_t instructionsAfter{ 0 };
+
+		void add(const ShaderOptimizationStatistics& other)
+		{
+			moduleCount += other.moduleCount;
+			bytesBefore += other.bytesBefore;
+			bytesAfter += other.bytesAfter;
+			instructionsBefore += other.instructionsBefore;
+			instructionsAfter += other.instructionsAfter;
+		}
+
+		//Fraction of the SPIR-V the optimizer removed
+		double size_reduction() const
+		{
+			if (bytesBefore == 0)
+				return 0.0;
+			return 1.0 - double(bytesAfter) / double(bytesBefore);
+		}
+	};
+
+	//Each instruction's first word holds its length in words in the high half, after a five word header
+	uint64_t count_spirv_instructions(const std::vector<uint32_t>& code)
+	{
+		uint64_t count = 0;
+		for (size_t word = 5; word < code.size(); count++)
+		{
+			uint32_t length = code[word] >> 16;
+			if (length == 0)
+				break;
+			word += length;
+		}
+		return count;
+	}
+
+	//Every module optimized by this process so far, shaders compile on several threads
+	inline std::mutex& shader_optimization_mutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	inline ShaderOptimizationStatistics& shader_optimization_totals()
+	{
+		static ShaderOptimizationStatistics totals;
+		return totals;
+	}
+
+	ShaderOptimizationStatistics shader_optimization_statistics()
+	{
+		std::lock_guard<std::mutex> lock(shader_optimization_mutex());
+		return shader_optimization_totals();
+	}
+
+	//The C API takes a plain function pointer, so messages can't name the module. The failure message after them does
+	void print_spirv_optimizer_message(spv_message_level_t level, const char*, const spv_position_t* position, const char* message)
+	{
+		if (level <= SPV_MSG_ERROR)
+			std::cout << "spirv-opt, word " << position->index << ": " << message << std::endl;
+	}
+
+	//The optimized module, or the one passed in when the optimizer rejects it
+	std::vector<uint32_t> optimize_spirv(const std::vector<uint32_t>& code, const std::string& name, bool debug)
+	{
+		spv_optimizer_t* optimizer = spvOptimizerCreate(SPV_ENV_VULKAN_1_1);
+		if (debug)
+			spvOptimizerSetMessageConsumer(optimizer, print_spirv_optimizer_message);
+		spvOptimizerRegisterPerformancePasses(optimizer);
+
+		spv_optimizer_options options = spvOptimizerOptionsCreate();
+		spv_binary binary = nullptr;
+		spv_result_t result = spvOptimizerRun(optimizer, code.data(), code.size(), &binary, options);
+		spvOptimizerOptionsDestroy(options);
+		spvOptimizerDestroy(optimizer);
+
+		std::vector<uint32_t> optimized;
+		if (result == SPV_SUCCESS && binary)
+			optimized.assign(binary->code, binary->code + binary->wordCount);
+		spvBinaryDestroy(binary);
+		if (optimized.empty())
+		{
+			if (debug)
+				std::cout << "Failed to optimize \"" << name << "\", keeping it as compiled" << std::endl;
+			return code;
+		}
+
+		ShaderOptimizationStatistics statistics;
+		statistics.moduleCount = 1;
+		statistics.bytesBefore = code.size() * sizeof(uint32_t);
+		statistics.bytesAfter = optimized.size() * sizeof(uint32_t);
+		statistics.instructionsBefore = count_spirv_instructions(code);
+		statistics.instructionsAfter = count_spirv_instructions(optimized);
+		{
+			std::lock_guard<std::mutex> lock(shader_optimization_mutex());
+			shader_optimization_totals().add(statistics);
+		}
+
+		if (debug)
+		{
+			std::cout << "Optimized \"" << name << "\": " << statistics.bytesBefore << " -> " << statistics.bytesAfter << " bytes, "
+				<< statistics.instructionsBefore << " -> " << statistics.instructionsAfter << " instructions" << std::endl;
+		}
+		return optimized;
+	}
+}
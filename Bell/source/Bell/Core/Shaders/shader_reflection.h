@@ -0,0 +1,206 @@
+#pragma once
+#include <Engine/config.h>
+#include <spirv_cross/spirv_cross.hpp>
+#include <unordered_set>
+#include <algorithm>
+
+namespace vkUtil
+{
+	/*
+	* What a pipeline layout needs to know about a shader, read from its SPIR-V with SPIRV-Cross
+	* so layouts and vertex input are derived from the shaders instead of written out by hand.
+	*/
+	struct ShaderBinding
+	{
+		uint32_t set;
+		uint32_t binding;
+		vk::DescriptorType type;
+		uint32_t count;
+		vk::ShaderStageFlags stages;
+		std::string name;
+
+		//Statically accessed by at least one stage, bindings that aren't can be left out of the layout
+		bool used;
+	};
+
+	struct ShaderInput
+	{
+		uint32_t location;
+		vk::Format format;
+		uint32_t size;
+		std::string name;
+	};
+
+	struct ShaderReflection
+	{
+		vk::ShaderStageFlags stages;
+		std::vector<ShaderBinding> bindings;
+		std::vector<vk::PushConstantRange> pushConstantRanges;
+
+		//Vertex stage inputs, ordered by location
+		std::vector<ShaderInput> vertexInputs;
+
+		//Compute local_size, the default value when it's a specialization constant
+		glm::uvec3 workgroupSize{ 1, 1, 1 };
+	};
+
+	//32 bit scalars and vectors, which is all our vertex shaders take in
+	vk::Format reflected_format(const spirv_cross::SPIRType& type)
+	{
+		static const vk::Format floats[] = { vk::Format::eR32Sfloat, vk::Format::eR32G32Sfloat, vk::Format::eR32G32B32Sfloat, vk::Format::eR32G32B32A32Sfloat };
+		static const vk::Format ints[] = { vk::Format::eR32Sint, vk::Format::eR32G32Sint, vk::Format::eR32G32B32Sint, vk::Format::eR32G32B32A32Sint };
+		static const vk::Format uints[] = { vk::Format::eR32Uint, vk::Format::eR32G32Uint, vk::Format::eR32G32B32Uint, vk::Format::eR32G32B32A32Uint };
+
+		if (type.vecsize < 1 || type.vecsize > 4 || type.columns != 1 || type.width != 32)
+			return vk::Format::eUndefined;
+		switch (type.basetype)
+		{
+		case spirv_cross::SPIRType::Float: return floats[type.vecsize - 1];
+		case spirv_cross::SPIRType::Int: return ints[type.vecsize - 1];
+		case spirv_cross::SPIRType::UInt: return uints[type.vecsize - 1];
+		default: return vk::Format::eUndefined;
+		}
+	}
+
+	ShaderReflection reflect_shader(const std::vector<uint32_t>& code, vk::ShaderStageFlagBits stage, bool debug)
+	{
+		ShaderReflection reflection;
+		reflection.stages = stage;
+		if (code.empty())
+			return reflection;
+
+		try
+		{
+			spirv_cross::Compiler compiler(code);
+			spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+			std::unordered_set<spirv_cross::VariableID> active = compiler.get_active_interface_variables();
+
+			auto add_bindings = [&](const spirv_cross::SmallVector<spirv_cross::Resource>& list, vk::DescriptorType type, vk::DescriptorType bufferType)
+			{
+				for (const spirv_cross::Resource& resource : list)
+				{
+					const spirv_cross::SPIRType& resourceType = compiler.get_type(resource.type_id);
+
+					ShaderBinding binding = {};
+					binding.set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+					binding.binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
+					binding.type = resourceType.image.dim == spv::DimBuffer ? bufferType : type;
+					binding.count = 1;
+					for (size_t i = 0; i < resourceType.array.size(); i++)
+					{
+						//Sized by a specialization constant or unsized, one descriptor is all we can promise
+						if (resourceType.array_size_literal[i] && resourceType.array[i] > 0)
+							binding.count *= resourceType.array[i];
+					}
+					binding.stages = stage;
+					binding.name = resource.name;
+					binding.used = active.count(resource.id) > 0;
+					reflection.bindings.push_back(binding);
+				}
+			};
+			add_bindings(resources.uniform_buffers, vk::DescriptorType::eUniformBuffer, vk::DescriptorType::eUniformBuffer);
+			add_bindings(resources.storage_buffers, vk::DescriptorType::eStorageBuffer, vk::DescriptorType::eStorageBuffer);
+			add_bindings(resources.sampled_images, vk::DescriptorType::eCombinedImageSampler, vk::DescriptorType::eUniformTexelBuffer);
+			add_bindings(resources.separate_images, vk::DescriptorType::eSampledImage, vk::DescriptorType::eUniformTexelBuffer);
+			add_bindings(resources.storage_images, vk::DescriptorType::eStorageImage, vk::DescriptorType::eStorageTexelBuffer);
+			add_bindings(resources.separate_samplers, vk::DescriptorType::eSampler, vk::DescriptorType::eSampler);
+			add_bindings(resources.subpass_inputs, vk::DescriptorType::eInputAttachment, vk::DescriptorType::eInputAttachment);
+
+			//The whole declared block, not just the members this stage reads, since it's pushed as one
+			for (const spirv_cross::Resource& resource : resources.push_constant_buffers)
+			{
+				const spirv_cross::SPIRType& blockType = compiler.get_type(resource.base_type_id);
+				uint32_t size = static_cast<uint32_t>(compiler.get_declared_struct_size(blockType));
+				uint32_t offset = blockType.member_types.empty() ? 0 : compiler.type_struct_member_offset(blockType, 0);
+				if (size > offset)
+					reflection.pushConstantRanges.push_back(vk::PushConstantRange(stage, offset, size - offset));
+			}
+
+			if (stage == vk::ShaderStageFlagBits::eVertex)
+			{
+				for (const spirv_cross::Resource& resource : resources.stage_inputs)
+				{
+					const spirv_cross::SPIRType& inputType = compiler.get_type(resource.type_id);
+
+					ShaderInput input = {};
+					input.location = compiler.get_decoration(resource.id, spv::DecorationLocation);
+					input.format = reflected_format(inputType);
+					input.size = inputType.vecsize * inputType.width / 8;
+					input.name = resource.name;
+					reflection.vertexInputs.push_back(input);
+				}
+				std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(),
+					[](const ShaderInput& a, const ShaderInput& b) { return a.location < b.location; });
+			}
+
+			if (stage == vk::ShaderStageFlagBits::eCompute)
+			{
+				for (uint32_t i = 0; i < 3; i++)
+					reflection.workgroupSize[i] = std::max(compiler.get_execution_mode_argument(spv::ExecutionModeLocalSize, i), 1u);
+			}
+		}
+		catch (const spirv_cross::CompilerError& err)
+		{
+			if (debug)
+				std::cout << "Failed to reflect shader: " << err.what() << std::endl;
+		}
+
+		return reflection;
+	}
+
+	//One view over every stage of a pipeline: bindings and push constants shared between stages are merged
+	ShaderReflection merge_reflections(const std::vector<ShaderReflection>& stages, bool debug)
+	{
+		ShaderReflection merged;
+		uint32_t pushBegin = UINT32_MAX;
+		uint32_t pushEnd = 0;
+		vk::ShaderStageFlags pushStages;
+
+		for (const ShaderReflection& stage : stages)
+		{
+			merged.stages |= stage.stages;
+			if (!stage.vertexInputs.empty())
+				merged.vertexInputs = stage.vertexInputs;
+			if (stage.stages & vk::ShaderStageFlagBits::eCompute)
+				merged.workgroupSize = stage.workgroupSize;
+
+			for (const ShaderBinding& binding : stage.bindings)
+			{
+				auto existing = std::find_if(merged.bindings.begin(), merged.bindings.end(),
+					[&](const ShaderBinding& other) { return other.set == binding.set && other.binding == binding.binding; });
+				if (existing == merged.bindings.end())
+				{
+					merged.bindings.push_back(binding);
+					continue;
+				}
+
+				if (existing->type != binding.type || existing->count != binding.count)
+				{
+					if (debug)
+						std::cout << "Stages disagree on set " << binding.set << " binding " << binding.binding
+							<< " (\"" << existing->name << "\", \"" << binding.name << "\"), keeping the first" << std::endl;
+					continue;
+				}
+				existing->stages |= binding.stages;
+				existing->used = existing->used || binding.used;
+			}
+
+			//A single range visible to every stage that declares the block keeps vkCmdPushConstants simple
+			for (const vk::PushConstantRange& range : stage.pushConstantRanges)
+			{
+				pushBegin = std::min(pushBegin, range.offset);
+				pushEnd = std::max(pushEnd, range.offset + range.size);
+				pushStages |= range.stageFlags;
+			}
+		}
+
+		if (pushEnd > 0)
+			merged.pushConstantRanges.push_back(vk::PushConstantRange(pushStages, pushBegin, pushEnd - pushBegin));
+
+		std::sort(merged.bindings.begin(), merged.bindings.end(), [](const ShaderBinding& a, const ShaderBinding& b)
+			{
+				return a.set < b.set || (a.set == b.set && a.binding < b.binding);
+			});
+		return merged;
+	}
+}
@@ -1,28 +1,104 @@
 #pragma once
 #include <Engine/config.h>
+#include <Core/mapped_file.h>
+#include "shader_compiler.h"
+#include "embedded_shaders.h"
 
 namespace vkUtil
 {
 	std::vector<char> readFile(std::string filename, bool debug)
 	{
-		std::ifstream file(filename, std::ios::ate | std::ios::binary);
+		MappedFile file(filename);
 
-		if (debug && !file.is_open())
-			std::cout << "Failed to load \"" << filename << "\"" << std::endl;
+		if (!file.is_open())
+		{
+			if (debug)
+				std::cout << "Failed to load \"" << filename << "\"" << std::endl;
+			return {};
+		}
 
-		size_t filesize{ static_cast<size_t>(file.tellg()) };
+		return std::vector<char>(file.data(), file.data() + file.size());
+	}
+
+	vk::ShaderModule createModule(const uint32_t* code, size_t wordCount, vk::Device device, bool debug)
+	{
+		vk::ShaderModuleCreateInfo moduleInfo = {};
+		moduleInfo.flags = vk::ShaderModuleCreateFlags();
+		moduleInfo.codeSize = wordCount * sizeof(uint32_t);
+		moduleInfo.pCode = code;
+
+		try {
+			return device.createShaderModule(moduleInfo);
+		}
+		catch (vk::SystemError err) {
+			if (debug)
+				std::cout << "Failed to create shader module" << std::endl;
+			return nullptr;
+		}
+	}
 
-		std::vector<char> buffer(filesize);
-		file.seekg(0);
-		file.read(buffer.data(), filesize);
+	vk::ShaderModule createModule(const std::vector<uint32_t>& code, vk::Device device, bool debug)
+	{
+		return createModule(code.data(), code.size(), device, debug);
+	}
 
-		file.close();
-		return buffer;
+	//Embedded shaders are built without defines, so a request with defines always goes to the file
+	const EmbeddedShader* find_embedded_shader(const std::string& filename, const std::vector<std::string>& defines)
+	{
+		return defines.empty() ? find_embedded_shader(filename) : nullptr;
 	}
 
-	vk::ShaderModule createModule(std::string filename, vk::Device device, bool debug)
+	bool is_spirv_file(const std::string& filename)
 	{
-		std::vector<char> sourceCode = readFile(filename, debug);
+		return filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".spv") == 0;
+	}
+
+	//SPIR-V words of a shader file, compiled first when it's GLSL, empty on failure
+	std::vector<uint32_t> load_spirv(const std::string& filename, const std::vector<std::string>& defines, bool debug)
+	{
+		if (const EmbeddedShader* embedded = find_embedded_shader(filename, defines))
+			return std::vector<uint32_t>(embedded->code, embedded->code + embedded->wordCount);
+
+		if (!is_spirv_file(filename))
+			return compile_glsl(filename, defines, debug);
+
+		MappedFile file(filename);
+		if (!file.is_open() || !is_spirv_binary(file.data(), file.size()))
+		{
+			if (debug)
+				std::cout << "Failed to load \"" << filename << "\"" << std::endl;
+			return {};
+		}
+
+		std::vector<uint32_t> code(file.size() / sizeof(uint32_t));
+		memcpy(code.data(), file.data(), file.size());
+		return code;
+	}
+
+	//Embedded SPIR-V is used first. Precompiled .spv files are used as they are, anything else is GLSL
+	//and goes through the shader compiler
+	vk::ShaderModule createModule(std::string filename, vk::Device device, bool debug, const std::vector<std::string>& defines = {})
+	{
+		if (const EmbeddedShader* embedded = find_embedded_shader(filename, defines))
+			return createModule(embedded->code, embedded->wordCount, device, debug);
+
+		if (!is_spirv_file(filename))
+		{
+			std::vector<uint32_t> code = compile_glsl(filename, defines, debug);
+			if (code.empty())
+				return nullptr;
+			return createModule(code, device, debug);
+		}
+
+		//Vulkan copies the code during module creation, so it can be read straight out of the mapping
+		MappedFile sourceCode(filename);
+		if (!sourceCode.is_open() || !is_spirv_binary(sourceCode.data(), sourceCode.size()))
+		{
+			if (debug)
+				std::cout << "Failed to load \"" << filename << "\"" << std::endl;
+			return nullptr;
+		}
+
 		vk::ShaderModuleCreateInfo moduleInfo = {};
 		moduleInfo.flags = vk::ShaderModuleCreateFlags();
 		moduleInfo.codeSize = sourceCode.size();
@@ -34,6 +110,7 @@ namespace vkUtil
 		catch (vk::SystemError err) {
 			if (debug)
 				std::cout << "Failed to create shader module for \"" << filename << "\"" << std::endl;
+			return nullptr;
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <filesystem>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace vkUtil
+{
+	/*
+	* Reports files that were written since the last poll. On Linux inotify watches the
+	* directories the files live in: editors usually save by writing a new file and renaming
+	* it over the old one, which a watch on the file itself would lose. Elsewhere the
+	* modification times are compared on each poll, which is fine for a handful of shaders.
+	*/
+	class FileWatcher
+	{
+	public:
+
+		FileWatcher()
+		{
+#ifdef __linux__
+			descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+		}
+
+		~FileWatcher()
+		{
+#ifdef __linux__
+			if (descriptor >= 0)
+				close(descriptor);
+#endif
+		}
+
+		FileWatcher(const FileWatcher&) = delete;
+		FileWatcher& operator=(const FileWatcher&) = delete;
+
+		//Paths are reported back as given here, so pass the canonical form the caller compares against
+		void watch(const std::string& path)
+		{
+			if (!files.insert(path).second)
+				return;
+
+#ifdef __linux__
+			std::string directory = std::filesystem::path(path).parent_path().string();
+			for (const auto& entry : directories)
+			{
+				if (entry.second == directory)
+					return;
+			}
+			int watch = inotify_add_watch(descriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+			if (watch >= 0)
+				directories[watch] = directory;
+#else
+			std::error_code error;
+			modified[path] = std::filesystem::last_write_time(path, error);
+#endif
+		}
+
+		//Watched files changed since the last call, each once
+		std::vector<std::string> poll()
+		{
+			std::set<std::string> changed;
+
+#ifdef __linux__
+			alignas(inotify_event) char buffer[4096];
+			while (true)
+			{
+				ssize_t length = read(descriptor, buffer, sizeof(buffer));
+				if (length <= 0)
+					break;
+
+				for (char* cursor = buffer; cursor < buffer + length;)
+				{
+					const inotify_event* event = reinterpret_cast<const inotify_event*>(cursor);
+					cursor += sizeof(inotify_event) + event->len;
+
+					auto directory = directories.find(event->wd);
+					if (directory == directories.end() || event->len == 0)
+						continue;
+
+					std::string path = (std::filesystem::path(directory->second) / event->name).string();
+					if (files.count(path))
+						changed.insert(path);
+				}
+			}
+#else
+			for (auto& entry : modified)
+			{
+				std::error_code error;
+				std::filesystem::file_time_type time = std::filesystem::last_write_time(entry.first, error);
+				if (!error && time != entry.second)
+				{
+					entry.second = time;
+					changed.insert(entry.first);
+				}
+			}
+#endif
+
+			return std::vector<std::string>(changed.begin(), changed.end());
+		}
+
+		size_t watched_count() const
+		{
+			return files.size();
+		}
+
+	private:
+
+		std::set<std::string> files;
+#ifdef __linux__
+		int descriptor{ -1 };
+		std::map<int, std::string> directories;
+#else
+		std::map<std::string, std::filesystem::file_time_type> modified;
+#endif
+	};
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace vkUtil
+{
+	constexpr uint64_t fnvOffsetBasis = 0xcbf29ce484222325ull;
+	constexpr uint64_t fnvPrime = 0x100000001b3ull;
+
+	//64 bit FNV-1a, pass a previous result as the seed to hash several blocks as one
+	inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = fnvOffsetBasis)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		uint64_t hash = seed;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= fnvPrime;
+		}
+		return hash;
+	}
+
+	inline uint64_t hash_string(const std::string& text, uint64_t seed = fnvOffsetBasis)
+	{
+		return hash_bytes(text.data(), text.size(), seed);
+	}
+
+	template<typename T>
+	inline uint64_t hash_value(const T& value, uint64_t seed = fnvOffsetBasis)
+	{
+		return hash_bytes(&value, sizeof(T), seed);
+	}
+}
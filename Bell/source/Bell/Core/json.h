@@ -0,0 +1,393 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdlib>
+#include <cstdint>
+#include <cctype>
+#include <stdexcept>
+
+namespace vkUtil
+{
+	//Minimal JSON document model, enough for asset formats like glTF
+	class JsonValue
+	{
+	public:
+
+		enum class Type
+		{
+			eNull,
+			eBool,
+			eNumber,
+			eString,
+			eArray,
+			eObject
+		};
+
+		Type type{ Type::eNull };
+		bool boolean{ false };
+		double number{ 0.0 };
+		std::string string;
+		std::vector<JsonValue> array;
+		std::vector<std::pair<std::string, JsonValue>> object;
+
+		bool is_null() const { return type == Type::eNull; }
+		bool is_number() const { return type == Type::eNumber; }
+		bool is_string() const { return type == Type::eString; }
+		bool is_array() const { return type == Type::eArray; }
+		bool is_object() const { return type == Type::eObject; }
+
+		//Returns nullptr if this isn't an object or the key is missing
+		const JsonValue* find(const std::string& key) const
+		{
+			for (const auto& member : object)
+			{
+				if (member.first == key)
+					return &member.second;
+			}
+			return nullptr;
+		}
+
+		//Shared instance returned for missing members, so lookups can be chained
+		static const JsonValue& null_value()
+		{
+			static const JsonValue value;
+			return value;
+		}
+
+		const JsonValue& operator[](const std::string& key) const
+		{
+			const JsonValue* value = find(key);
+			return value ? *value : null_value();
+		}
+
+		const JsonValue& operator[](size_t index) const
+		{
+			return index < array.size() ? array[index] : null_value();
+		}
+
+		size_t size() const
+		{
+			return is_array() ? array.size() : object.size();
+		}
+
+		double as_number(double fallback = 0.0) const
+		{
+			return is_number() ? number : fallback;
+		}
+
+		int64_t as_int(int64_t fallback = -1) const
+		{
+			return is_number() ? static_cast<int64_t>(number) : fallback;
+		}
+
+		const std::string& as_string() const
+		{
+			return string;
+		}
+	};
+
+	class JsonParser
+	{
+	public:
+
+		//Throws std::runtime_error on malformed input
+		static JsonValue parse(const char* begin, const char* end)
+		{
+			JsonParser parser(begin, end);
+			JsonValue value = parser.parse_value();
+			parser.skip_whitespace();
+			if (parser.cursor != parser.end)
+				parser.fail("Trailing characters after JSON document");
+			return value;
+		}
+
+		static JsonValue parse(const std::string& text)
+		{
+			return parse(text.data(), text.data() + text.size());
+		}
+
+	private:
+
+		const char* cursor;
+		const char* end;
+
+		JsonParser(const char* begin, const char* end) : cursor(begin), end(end) {}
+
+		[[noreturn]] void fail(const char* message)
+		{
+			throw std::runtime_error(message);
+		}
+
+		void skip_whitespace()
+		{
+			while (cursor != end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r'))
+				cursor++;
+		}
+
+		bool consume(const char* literal)
+		{
+			const char* probe = cursor;
+			for (; *literal; literal++, probe++)
+			{
+				if (probe == end || *probe != *literal)
+					return false;
+			}
+			cursor = probe;
+			return true;
+		}
+
+		JsonValue parse_value()
+		{
+			skip_whitespace();
+			if (cursor == end)
+				fail("Unexpected end of JSON document");
+
+			JsonValue value;
+			switch (*cursor)
+			{
+			case '{':
+				value.type = JsonValue::Type::eObject;
+				parse_object(value);
+				break;
+			case '[':
+				value.type = JsonValue::Type::eArray;
+				parse_array(value);
+				break;
+			case '"':
+				value.type = JsonValue::Type::eString;
+				value.string = parse_string();
+				break;
+			case 't':
+			case 'f':
+				value.type = JsonValue::Type::eBool;
+				if (consume("true"))
+					value.boolean = true;
+				else if (!consume("false"))
+					fail("Invalid JSON literal");
+				break;
+			case 'n':
+				if (!consume("null"))
+					fail("Invalid JSON literal");
+				break;
+			default:
+				value.type = JsonValue::Type::eNumber;
+				value.number = parse_number();
+			}
+			return value;
+		}
+
+		void parse_object(JsonValue& value)
+		{
+			cursor++;
+			skip_whitespace();
+			if (cursor != end && *cursor == '}')
+			{
+				cursor++;
+				return;
+			}
+
+			while (true)
+			{
+				skip_whitespace();
+				if (cursor == end || *cursor != '"')
+					fail("Expected a string key in JSON object");
+				std::string key = parse_string();
+
+				skip_whitespace();
+				if (cursor == end || *cursor != ':')
+					fail("Expected ':' in JSON object");
+				cursor++;
+
+				value.object.emplace_back(std::move(key), parse_value());
+
+				skip_whitespace();
+				if (cursor == end)
+					fail("Unterminated JSON object");
+				if (*cursor == ',')
+				{
+					cursor++;
+					continue;
+				}
+				if (*cursor == '}')
+				{
+					cursor++;
+					return;
+				}
+				fail("Expected ',' or '}' in JSON object");
+			}
+		}
+
+		void parse_array(JsonValue& value)
+		{
+			cursor++;
+			skip_whitespace();
+			if (cursor != end && *cursor == ']')
+			{
+				cursor++;
+				return;
+			}
+
+			while (true)
+			{
+				value.array.push_back(parse_value());
+
+				skip_whitespace();
+				if (cursor == end)
+					fail("Unterminated JSON array");
+				if (*cursor == ',')
+				{
+					cursor++;
+					continue;
+				}
+				if (*cursor == ']')
+				{
+					cursor++;
+					return;
+				}
+				fail("Expected ',' or ']' in JSON array");
+			}
+		}
+
+		static void append_utf8(std::string& out, uint32_t codepoint)
+		{
+			if (codepoint < 0x80)
+				out += static_cast<char>(codepoint);
+			else if (codepoint < 0x800)
+			{
+				out += static_cast<char>(0xC0 | (codepoint >> 6));
+				out += static_cast<char>(0x80 | (codepoint & 0x3F));
+			}
+			else if (codepoint < 0x10000)
+			{
+				out += static_cast<char>(0xE0 | (codepoint >> 12));
+				out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+				out += static_cast<char>(0x80 | (codepoint & 0x3F));
+			}
+			else
+			{
+				out += static_cast<char>(0xF0 | (codepoint >> 18));
+				out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+				out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+				out += static_cast<char>(0x80 | (codepoint & 0x3F));
+			}
+		}
+
+		uint32_t parse_hex4()
+		{
+			if (end - cursor < 4)
+				fail("Truncated unicode escape in JSON string");
+
+			uint32_t value = 0;
+			for (int i = 0; i < 4; i++, cursor++)
+			{
+				char c = *cursor;
+				value <<= 4;
+				if (c >= '0' && c <= '9')
+					value |= c - '0';
+				else if (c >= 'a' && c <= 'f')
+					value |= c - 'a' + 10;
+				else if (c >= 'A' && c <= 'F')
+					value |= c - 'A' + 10;
+				else
+					fail("Invalid unicode escape in JSON string");
+			}
+			return value;
+		}
+
+		std::string parse_string()
+		{
+			cursor++;
+			std::string result;
+			while (cursor != end && *cursor != '"')
+			{
+				if (*cursor != '\\')
+				{
+					result += *cursor++;
+					continue;
+				}
+
+				cursor++;
+				if (cursor == end)
+					break;
+
+				char escape = *cursor++;
+				switch (escape)
+				{
+				case '"': result += '"'; break;
+				case '\\': result += '\\'; break;
+				case '/': result += '/'; break;
+				case 'b': result += '\b'; break;
+				case 'f': result += '\f'; break;
+				case 'n': result += '\n'; break;
+				case 'r': result += '\r'; break;
+				case 't': result += '\t'; break;
+				case 'u':
+				{
+					uint32_t codepoint = parse_hex4();
+					//Surrogate pair
+					if (codepoint >= 0xD800 && codepoint < 0xDC00 && consume("\\u"))
+						codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (parse_hex4() - 0xDC00);
+					append_utf8(result, codepoint);
+					break;
+				}
+				default:
+					fail("Invalid escape in JSON string");
+				}
+			}
+
+			if (cursor == end)
+				fail("Unterminated JSON string");
+			cursor++;
+			return result;
+		}
+
+		double parse_number()
+		{
+			const char* start = cursor;
+			while (cursor != end && (isdigit(static_cast<unsigned char>(*cursor)) || *cursor == '-' || *cursor == '+'
+				|| *cursor == '.' || *cursor == 'e' || *cursor == 'E'))
+				cursor++;
+
+			if (cursor == start)
+				fail("Unexpected character in JSON document");
+
+			//strtod needs a terminated string, numbers are short so copying is cheap
+			std::string text(start, cursor);
+			char* parsedEnd = nullptr;
+			double value = std::strtod(text.c_str(), &parsedEnd);
+			if (parsedEnd != text.c_str() + text.size())
+				fail("Invalid number in JSON document");
+			return value;
+		}
+	};
+
+	//Quotes text for writing inside a JSON string, the inverse of JsonParser::parse_string
+	std::string json_escape(const std::string& text)
+	{
+		static const char digits[] = "0123456789abcdef";
+		std::string escaped;
+		for (char c : text)
+		{
+			switch (c)
+			{
+			case '"': escaped += "\\\""; break;
+			case '\\': escaped += "\\\\"; break;
+			case '\n': escaped += "\\n"; break;
+			case '\r': escaped += "\\r"; break;
+			case '\t': escaped += "\\t"; break;
+			default:
+				//Other control characters aren't allowed raw in a JSON string
+				if (static_cast<unsigned char>(c) < 0x20)
+				{
+					escaped += "\\u00";
+					escaped += digits[c >> 4];
+					escaped += digits[c & 0xF];
+				}
+				else
+					escaped += c;
+			}
+		}
+		return escaped;
+	}
+}
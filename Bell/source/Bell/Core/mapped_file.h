@@ -0,0 +1,160 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vkUtil
+{
+	//Read-only memory mapping of a whole file, the contents are paged in by the OS on first touch
+	class MappedFile
+	{
+	public:
+
+		MappedFile() = default;
+
+		explicit MappedFile(const std::string& filename)
+		{
+			open(filename);
+		}
+
+		~MappedFile()
+		{
+			close();
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		MappedFile(MappedFile&& other) noexcept
+		{
+			*this = std::move(other);
+		}
+
+		MappedFile& operator=(MappedFile&& other) noexcept
+		{
+			if (this != &other)
+			{
+				close();
+				std::swap(bytes, other.bytes);
+				std::swap(byteCount, other.byteCount);
+#ifdef _WIN32
+				std::swap(fileHandle, other.fileHandle);
+				std::swap(mappingHandle, other.mappingHandle);
+#endif
+			}
+			return *this;
+		}
+
+		//Returns false if the file is missing, empty or can't be mapped
+		bool open(const std::string& filename)
+		{
+			close();
+#ifdef _WIN32
+			fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (fileHandle == INVALID_HANDLE_VALUE)
+				return false;
+
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+			{
+				close();
+				return false;
+			}
+
+			mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!mappingHandle)
+			{
+				close();
+				return false;
+			}
+
+			bytes = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+			if (!bytes)
+			{
+				close();
+				return false;
+			}
+			byteCount = static_cast<size_t>(fileSize.QuadPart);
+#else
+			int descriptor = ::open(filename.c_str(), O_RDONLY);
+			if (descriptor < 0)
+				return false;
+
+			struct stat fileInfo;
+			if (fstat(descriptor, &fileInfo) != 0 || fileInfo.st_size == 0)
+			{
+				::close(descriptor);
+				return false;
+			}
+
+			//The mapping stays valid after the descriptor is closed
+			void* mapping = mmap(nullptr, static_cast<size_t>(fileInfo.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+			::close(descriptor);
+			if (mapping == MAP_FAILED)
+				return false;
+
+			bytes = static_cast<const char*>(mapping);
+			byteCount = static_cast<size_t>(fileInfo.st_size);
+#endif
+			return true;
+		}
+
+		void close()
+		{
+#ifdef _WIN32
+			if (bytes)
+				UnmapViewOfFile(bytes);
+			if (mappingHandle)
+				CloseHandle(mappingHandle);
+			if (fileHandle != INVALID_HANDLE_VALUE)
+				CloseHandle(fileHandle);
+			mappingHandle = nullptr;
+			fileHandle = INVALID_HANDLE_VALUE;
+#else
+			if (bytes)
+				munmap(const_cast<char*>(bytes), byteCount);
+#endif
+			bytes = nullptr;
+			byteCount = 0;
+		}
+
+		bool is_open() const
+		{
+			return bytes != nullptr;
+		}
+
+		const char* data() const
+		{
+			return bytes;
+		}
+
+		size_t size() const
+		{
+			return byteCount;
+		}
+
+	private:
+
+		const char* bytes{ nullptr };
+		size_t byteCount{ 0 };
+#ifdef _WIN32
+		HANDLE fileHandle{ INVALID_HANDLE_VALUE };
+		HANDLE mappingHandle{ nullptr };
+#endif
+	};
+}
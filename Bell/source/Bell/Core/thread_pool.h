@@ -0,0 +1,85 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <algorithm>
+
+namespace vkUtil
+{
+	//Fixed set of worker threads draining a FIFO of jobs, used for work that mustn't block the frame
+	class ThreadPool
+	{
+	public:
+
+		//Leaves one core for the render thread
+		explicit ThreadPool(size_t threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1)
+		{
+			for (size_t i = 0; i < threadCount; i++)
+				workers.emplace_back([this]() { work(); });
+		}
+
+		//Finishes the jobs already queued before joining
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (std::thread& worker : workers)
+				worker.join();
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		template<typename Function>
+		auto submit(Function&& function) -> std::future<decltype(function())>
+		{
+			using Result = decltype(function());
+			auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+			std::future<Result> result = task->get_future();
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				jobs.emplace_back([task]() { (*task)(); });
+			}
+			wake.notify_one();
+			return result;
+		}
+
+		size_t thread_count() const
+		{
+			return workers.size();
+		}
+
+	private:
+
+		void work()
+		{
+			while (true)
+			{
+				std::function<void()> job;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+					if (jobs.empty())
+						return;
+					job = std::move(jobs.front());
+					jobs.pop_front();
+				}
+				job();
+			}
+		}
+
+		std::vector<std::thread> workers;
+		std::deque<std::function<void()>> jobs;
+		std::mutex mutex;
+		std::condition_variable wake;
+		bool stopping{ false };
+	};
+}
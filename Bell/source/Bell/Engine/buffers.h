@@ -0,0 +1,23 @@
+#pragma once
+#include "config.h"
+
+namespace vkUtil
+{
+	//A buffer and the memory bound to it, made by createBuffer in memory.h
+	struct Buffer
+	{
+		vk::Buffer buffer;
+		vk::DeviceMemory bufferMemory;
+		vk::DeviceSize size;
+	};
+
+	//A host visible and coherent buffer, mapped for its whole life. Written by the CPU every frame,
+	//one frame in flight means it's never read while being written
+	struct HostBuffer
+	{
+		vk::Buffer buffer{ nullptr };
+		vk::DeviceMemory memory{ nullptr };
+		void* data{ nullptr };
+		vk::DeviceSize size{ 0 };
+	};
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "config.h"
+#include <Core/Shaders/shaders.h>
+#include "pipeline_stats.h"
+
+namespace vkInit
+{
+	//The compute counterpart of GraphicsPipelineInBundle
+	struct ComputePipelineInBundle
+	{
+		vk::Device device;
+		std::string computeFilepath;
+		std::vector<vk::PushConstantRange> pushConstantRanges;
+		vk::PipelineCache pipelineCache = nullptr;
+
+		//Where creation times go, nothing is recorded without one
+		vkUtil::PipelineCreationLog* creationLog = nullptr;
+
+		//Preprocessor defines for GLSL shaders, "NAME" or "NAME=VALUE"
+		std::vector<std::string> shaderDefines;
+
+		//Specialization constants, eg. the workgroup size through local_size_x_id
+		std::vector<vk::SpecializationMapEntry> specializationEntries;
+		std::vector<uint8_t> specializationData;
+	};
+
+	//Build a compute pipeline against a layout made elsewhere, eg. shared through the pipeline registry
+	vk::Pipeline make_compute_pipeline(const ComputePipelineInBundle& specification, vk::PipelineLayout layout, bool debug)
+	{
+		if (debug)
+			std::cout << "Create compute shader module" << std::endl;
+
+		vk::ShaderModule computeShader = vkUtil::createModule(specification.computeFilepath, specification.device, debug, specification.shaderDefines);
+		if (!computeShader)
+			return nullptr;
+
+		vk::SpecializationInfo specializationInfo = {};
+		specializationInfo.mapEntryCount = static_cast<uint32_t>(specification.specializationEntries.size());
+		specializationInfo.pMapEntries = specification.specializationEntries.data();
+		specializationInfo.dataSize = specification.specializationData.size();
+		specializationInfo.pData = specification.specializationData.data();
+
+		vk::PipelineShaderStageCreateInfo computeShaderInfo = {};
+		computeShaderInfo.flags = vk::PipelineShaderStageCreateFlags();
+		computeShaderInfo.stage = vk::ShaderStageFlagBits::eCompute;
+		computeShaderInfo.module = computeShader;
+		computeShaderInfo.pName = "main";
+		computeShaderInfo.pSpecializationInfo = specification.specializationEntries.empty() ? nullptr : &specializationInfo;
+
+		vk::ComputePipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.flags = vk::PipelineCreateFlags();
+		pipelineInfo.stage = computeShaderInfo;
+		pipelineInfo.layout = layout;
+		pipelineInfo.basePipelineHandle = nullptr;
+
+		if (debug)
+			std::cout << "Create Compute Pipeline" << std::endl;
+
+		std::string name = specification.computeFilepath.substr(specification.computeFilepath.find_last_of("/\\") + 1);
+		for (const std::string& define : specification.shaderDefines)
+			name += " " + define;
+		vkUtil::PipelineCreationTimer timer(specification.creationLog, name);
+		pipelineInfo.pNext = timer.chain(nullptr, { vk::ShaderStageFlagBits::eCompute });
+
+		vk::Pipeline computePipeline;
+		try {
+			computePipeline = (specification.device.createComputePipeline(specification.pipelineCache, pipelineInfo)).value;
+		}
+		catch (vk::SystemError err)
+		{
+			if (debug)
+				std::cout << "Failed to create Compute Pipeline" << std::endl;
+		}
+		timer.finish(bool(computePipeline));
+
+		specification.device.destroyShaderModule(computeShader);
+		return computePipeline;
+	}
+}
@@ -8,4 +8,10 @@
 #include <string>
 #include <optional>
 #include <fstream>
-#include <sstream>
\ No newline at end of file
+#include <sstream>
+
+//Vulkan clip space has depth in [0, 1]
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm.hpp>
+#include <gtc/matrix_transform.hpp>
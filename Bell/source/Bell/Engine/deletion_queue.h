@@ -0,0 +1,58 @@
+#pragma once
+#include "config.h"
+#include <deque>
+#include <functional>
+
+namespace vkUtil
+{
+	//Holds destruction callbacks until the GPU has finished every submission that could still reference them
+	class DeletionQueue
+	{
+	public:
+
+		//Queue a destroyer that may run once the GPU has completed "retireValue" submissions
+		void push(uint64_t retireValue, std::function<void()>&& destroyer)
+		{
+			//Retire values only ever grow, so the queue stays sorted and flush can stop at the first pending entry
+			entries.push_back({ retireValue, std::move(destroyer) });
+		}
+
+		//Run every destroyer whose retire value the GPU has passed, returns how many were run
+		size_t flush(uint64_t completedValue)
+		{
+			size_t count = 0;
+			while (!entries.empty() && entries.front().retireValue <= completedValue)
+			{
+				entries.front().destroyer();
+				entries.pop_front();
+				count++;
+			}
+			return count;
+		}
+
+		//Only safe after the device has gone idle, eg. at shutdown
+		size_t flush_all()
+		{
+			size_t count = entries.size();
+			for (Entry& entry : entries)
+				entry.destroyer();
+			entries.clear();
+			return count;
+		}
+
+		size_t size() const
+		{
+			return entries.size();
+		}
+
+	private:
+
+		struct Entry
+		{
+			uint64_t retireValue;
+			std::function<void()> destroyer;
+		};
+
+		std::deque<Entry> entries;
+	};
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "config.h"
+
+namespace vkInit
+{
+	vk::DescriptorSetLayout make_descriptor_set_layout(vk::Device device, const std::vector<vk::DescriptorSetLayoutBinding>& bindings, bool debug)
+	{
+		vk::DescriptorSetLayoutCreateInfo layoutInfo = {};
+		layoutInfo.flags = vk::DescriptorSetLayoutCreateFlags();
+		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		layoutInfo.pBindings = bindings.data();
+
+		try
+		{
+			return device.createDescriptorSetLayout(layoutInfo);
+		}
+		catch (vk::SystemError err)
+		{
+			if (debug)
+				std::cout << "Failed to create descriptor set layout" << std::endl;
+
+			return nullptr;
+		}
+	}
+
+	vk::DescriptorPool make_descriptor_pool(vk::Device device, const std::vector<vk::DescriptorPoolSize>& poolSizes, uint32_t maxSets, bool debug)
+	{
+		vk::DescriptorPoolCreateInfo poolInfo = {};
+		poolInfo.flags = vk::DescriptorPoolCreateFlags();
+		poolInfo.maxSets = maxSets;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+
+		try
+		{
+			return device.createDescriptorPool(poolInfo);
+		}
+		catch (vk::SystemError err)
+		{
+			if (debug)
+				std::cout << "Failed to create descriptor pool" << std::endl;
+
+			return nullptr;
+		}
+	}
+
+	vk::DescriptorSet allocate_descriptor_set(vk::Device device, vk::DescriptorPool pool, vk::DescriptorSetLayout layout, bool debug)
+	{
+		vk::DescriptorSetAllocateInfo allocationInfo = {};
+		allocationInfo.descriptorPool = pool;
+		allocationInfo.descriptorSetCount = 1;
+		allocationInfo.pSetLayouts = &layout;
+
+		try
+		{
+			return device.allocateDescriptorSets(allocationInfo)[0];
+		}
+		catch (vk::SystemError err)
+		{
+			if (debug)
+				std::cout << "Failed to allocate descriptor set" << std::endl;
+
+			return nullptr;
+		}
+	}
+
+	//Whole buffer unless a range is given
+	void write_buffer_descriptor(vk::Device device, vk::DescriptorSet set, uint32_t binding, vk::DescriptorType type,
+		vk::Buffer buffer, vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE)
+	{
+		vk::DescriptorBufferInfo bufferInfo = {};
+		bufferInfo.buffer = buffer;
+		bufferInfo.offset = offset;
+		bufferInfo.range = range;
+
+		vk::WriteDescriptorSet write = {};
+		write.dstSet = set;
+		write.dstBinding = binding;
+		write.dstArrayElement = 0;
+		write.descriptorCount = 1;
+		write.descriptorType = type;
+		write.pBufferInfo = &bufferInfo;
+		device.updateDescriptorSets(1, &write, 0, nullptr);
+	}
+
+	void write_image_descriptor(vk::Device device, vk::DescriptorSet set, uint32_t binding, vk::DescriptorType type,
+		vk::ImageView view, vk::ImageLayout layout, vk::Sampler sampler = nullptr)
+	{
+		vk::DescriptorImageInfo imageInfo = {};
+		imageInfo.sampler = sampler;
+		imageInfo.imageView = view;
+		imageInfo.imageLayout = layout;
+
+		vk::WriteDescriptorSet write = {};
+		write.dstSet = set;
+		write.dstBinding = binding;
+		write.dstArrayElement = 0;
+		write.descriptorCount = 1;
+		write.descriptorType = type;
+		write.pImageInfo = &imageInfo;
+		device.updateDescriptorSets(1, &write, 0, nullptr);
+	}
+}
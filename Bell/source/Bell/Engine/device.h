@@ -58,6 +58,60 @@ namespace vkInit
 		return true;
 	}
 
+	//VK_EXT_memory_budget needs vkGetPhysicalDeviceMemoryProperties2, which is core from Vulkan 1.1
+	bool supports_memory_budget(const vk::PhysicalDevice& device)
+	{
+		if (device.getProperties().apiVersion < VK_API_VERSION_1_1 || vk::enumerateInstanceVersion() < VK_API_VERSION_1_1)
+			return false;
+
+		return checkDeviceExtensionSupport(device, { VK_EXT_MEMORY_BUDGET_EXTENSION_NAME }, false);
+	}
+
+	//VK_EXT_pipeline_creation_feedback has no feature to enable, the extension is enough
+	bool supports_pipeline_creation_feedback(const vk::PhysicalDevice& device)
+	{
+		return checkDeviceExtensionSupport(device, { VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME }, false);
+	}
+
+	//VK_EXT_extended_dynamic_state, queried through vkGetPhysicalDeviceFeatures2 which is also core from Vulkan 1.1
+	bool supports_extended_dynamic_state(const vk::PhysicalDevice& device)
+	{
+		if (device.getProperties().apiVersion < VK_API_VERSION_1_1 || vk::enumerateInstanceVersion() < VK_API_VERSION_1_1)
+			return false;
+		if (!checkDeviceExtensionSupport(device, { VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME }, false))
+			return false;
+
+		auto chain = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>();
+		return chain.get<vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>().extendedDynamicState;
+	}
+
+	//VK_EXT_graphics_pipeline_library and the VK_KHR_pipeline_library it builds on
+	bool supports_graphics_pipeline_library(const vk::PhysicalDevice& device)
+	{
+		if (device.getProperties().apiVersion < VK_API_VERSION_1_1 || vk::enumerateInstanceVersion() < VK_API_VERSION_1_1)
+			return false;
+		if (!checkDeviceExtensionSupport(device, { VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME }, false))
+			return false;
+
+		auto chain = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT>();
+		return chain.get<vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT>().graphicsPipelineLibrary;
+	}
+
+	//An indirect command with a nonzero firstInstance needs drawIndirectFirstInstance, and every
+	//instance batch but the first has one
+	bool supports_indirect_draws(const vk::PhysicalDevice& device)
+	{
+		return device.getFeatures().drawIndirectFirstInstance;
+	}
+
+	//Commands one indirect draw call may read, 1 without the multiDrawIndirect feature
+	uint32_t max_indirect_draw_count(const vk::PhysicalDevice& device)
+	{
+		if (!device.getFeatures().multiDrawIndirect)
+			return 1;
+		return device.getProperties().limits.maxDrawIndirectCount;
+	}
+
 	vk::PhysicalDevice choose_physical_device(vk::Instance& instance, bool debug)
 	{
 		if (debug)
@@ -105,7 +159,32 @@ namespace vkInit
 			VK_KHR_SWAPCHAIN_EXTENSION_NAME
 		};
 
+		//Optional extensions, only enabled when present
+		if (supports_memory_budget(physicalDevice))
+			deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		if (supports_pipeline_creation_feedback(physicalDevice))
+			deviceExtensions.push_back(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+
+		vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicState = {};
+		if (supports_extended_dynamic_state(physicalDevice))
+		{
+			deviceExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+			extendedDynamicState.extendedDynamicState = VK_TRUE;
+		}
+
+		vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibrary = {};
+		if (supports_graphics_pipeline_library(physicalDevice))
+		{
+			deviceExtensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+			deviceExtensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+			graphicsPipelineLibrary.graphicsPipelineLibrary = VK_TRUE;
+		}
+
+		//Indirect drawing features, the draw path falls back when they're missing
+		vk::PhysicalDeviceFeatures supportedFeatures = physicalDevice.getFeatures();
 		vk::PhysicalDeviceFeatures deviceFeatures = vk::PhysicalDeviceFeatures();
+		deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+		deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
 
 		std::vector<const char*> enabledLayers;
 		if (debug)
@@ -118,6 +197,20 @@ namespace vkInit
 			&deviceFeatures
 		);
 
+		//Feature structs of the optional extensions that were found, chained in front of each other
+		void* features = nullptr;
+		if (extendedDynamicState.extendedDynamicState)
+		{
+			extendedDynamicState.pNext = features;
+			features = &extendedDynamicState;
+		}
+		if (graphicsPipelineLibrary.graphicsPipelineLibrary)
+		{
+			graphicsPipelineLibrary.pNext = features;
+			features = &graphicsPipelineLibrary;
+		}
+		deviceInfo.pNext = features;
+
 		try {
 			vk::Device device = physicalDevice.createDevice(deviceInfo);
 			if (debug)
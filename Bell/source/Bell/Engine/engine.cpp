@@ -4,9 +4,32 @@
 #include "device.h"
 #include "swapchain.h"
 #include "pipeline.h"
+#include "pipeline_cache.h"
+#include "pipeline_registry.h"
+#include "pipeline_variants.h"
+#include <Core/file_watcher.h>
+#include "memory.h"
+#include "image.h"
+#include <Model/gltf.h>
+#include <Model/mesh_upload.h>
+#include <Model/mesh_cache.h>
+#include <Model/static_batch.h>
+#include <Model/meshlet.h>
+#include <chrono>
 #include <Render/framebuffer.h>
 #include <Render/commands.h>
 #include <Render/sync.h>
+#include <Render/dynamic_state.h>
+#include <Render/indirect.h>
+#include <Render/compute.h>
+#include <Render/culling.h>
+#include <Render/depth_pyramid.h>
+#include <Render/clusters.h>
+
+//Pipeline cache file, relative to the working directory like the shaders
+static const char* pipelineCacheFilename = "./bell_pipeline_cache.bin";
+static const std::chrono::seconds pipelineCacheSaveInterval(30);
+static const char* pipelineManifestFilename = "./bell_pipeline_manifest.json";
  
 Engine::Engine(int width, int height, GLFWwindow* window, bool debugMode)
 {
@@ -23,8 +46,14 @@ Engine::Engine(int width, int height, GLFWwindow* window, bool debugMode)
 
 	make_device();
 
+	make_swapchain();
+
+	prewarm_pipelines();
+
 	make_pipeline();
 
+	make_culling_pipelines();
+
 	finalize_setup();
 }
 
@@ -51,49 +80,650 @@ void Engine::make_device()
 {
 	physicalDevice = vkInit::choose_physical_device(instance, debugMode);
 	device = vkInit::create_logical_device(physicalDevice, surface, debugMode);
+	dldi.init(device);
+	extendedDynamicStateSupported = vkInit::supports_extended_dynamic_state(physicalDevice);
+	memoryBudgetSupported = vkInit::supports_memory_budget(physicalDevice);
+	memoryStatistics.set_memory_properties(physicalDevice.getMemoryProperties());
+	indirectDrawSupported = vkInit::supports_indirect_draws(physicalDevice);
+	maxIndirectDrawCount = vkInit::max_indirect_draw_count(physicalDevice);
+	pipelineCreationLog.set_feedback_supported(vkInit::supports_pipeline_creation_feedback(physicalDevice));
 	std::array<vk::Queue, 2> queues = vkInit::get_queue(physicalDevice, device, surface, debugMode);
 	graphicsQueue = queues[0];
 	presentQueue = queues[1];
-	vkInit::SwapChainBundle bundle = vkInit::create_swapchain(device, physicalDevice, surface, width, height, debugMode);
+	pipelineCache = vkInit::make_pipeline_cache(device, physicalDevice, pipelineCacheFilename, debugMode);
+	lastPipelineCacheSave = std::chrono::steady_clock::now();
+	pipelineRegistry = new vkInit::PipelineRegistry(device,
+		[this](std::function<void()>&& destroyer) { defer_destroy(std::move(destroyer)); }, debugMode);
+	if (vkInit::supports_graphics_pipeline_library(physicalDevice))
+	{
+		pipelineRegistry->enable_pipeline_libraries();
+		if (debugMode)
+			std::cout << "Linking pipelines from graphics pipeline libraries" << std::endl;
+	}
+
+	depthFormat = vkImage::find_supported_format(
+		physicalDevice,
+		{ vk::Format::eD32Sfloat, vk::Format::eD24UnormS8Uint },
+		vk::ImageTiling::eOptimal,
+		vk::FormatFeatureFlagBits::eDepthStencilAttachment
+	);
+	depthSampleable = static_cast<bool>(physicalDevice.getFormatProperties(depthFormat).optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage);
+}
+
+void Engine::make_swapchain()
+{
+	vk::SwapchainKHR oldSwapchain = swapchain;
+	vkInit::SwapChainBundle bundle = vkInit::create_swapchain(device, physicalDevice, surface, width, height, debugMode, oldSwapchain);
+	if (oldSwapchain)
+		device.destroySwapchainKHR(oldSwapchain);
 	swapchain = bundle.swapchain;
 	swapchainFrames = bundle.frames;
 	swapchainFormat = bundle.format;
 	swapchainExtent = bundle.extent;
 }
 
+//Depth buffers, framebuffers and command buffers, one of each per swapchain image
+void Engine::make_frame_resources()
+{
+	vkInit::depthResourcesInput depthInput = { device, physicalDevice, depthFormat, swapchainExtent, &memoryStatistics };
+	depthInput.sampled = depthSampleable;
+	vkInit::make_depth_resources(depthInput, swapchainFrames, debugMode);
+
+	vkInit::framebufferInput frameBufferInput;
+	frameBufferInput.device = device;
+	frameBufferInput.renderpass = renderpass;
+	frameBufferInput.swapchainExtent = swapchainExtent;
+	vkInit::make_framebuffers(frameBufferInput, swapchainFrames, debugMode);
+
+	vkInit::commandBufferInputChunk commandBufferInput = { device, commandPool, swapchainFrames };
+	vkInit::make_frame_command_buffers(commandBufferInput, debugMode);
+}
+
+//Everything but the swapchain itself, which make_swapchain hands over to its replacement
+void Engine::destroy_swapchain()
+{
+	for (vkUtil::SwapChainFrame frame : swapchainFrames)
+	{
+		device.destroyImageView(frame.imageView);
+		device.destroyFramebuffer(frame.framebuffer);
+		device.freeCommandBuffers(commandPool, frame.commandBuffer);
+
+		device.destroyImageView(frame.depthBufferView);
+		device.destroyImage(frame.depthBuffer);
+		memoryStatistics.untrack(frame.depthBufferMemory);
+		device.freeMemory(frame.depthBufferMemory);
+	}
+	swapchainFrames.clear();
+
+	//Made again at the new size on first use
+	delete depthPyramid;
+	depthPyramid = nullptr;
+	cullDescriptorPyramid = nullptr;
+}
+
+/*
+* Only size dependent resources are made again. The viewport and scissor are dynamic and
+* the render pass depends on formats alone, so no pipeline is rebuilt.
+*/
+void Engine::recreate_swapchain()
+{
+	int framebufferWidth = 0, framebufferHeight = 0;
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+	if (framebufferWidth == 0 || framebufferHeight == 0)
+		return;
+
+	device.waitIdle();
+	width = framebufferWidth;
+	height = framebufferHeight;
+
+	destroy_swapchain();
+	make_swapchain();
+	make_frame_resources();
+
+	if (debugMode)
+		std::cout << "Resized swapchain to " << swapchainExtent.width << "x" << swapchainExtent.height << std::endl;
+}
+
+void Engine::prewarm_pipelines()
+{
+	vkInit::PipelineManifest manifest = vkInit::load_pipeline_manifest(pipelineManifestFilename, physicalDevice, debugMode);
+	for (vkInit::GraphicsPipelineInBundle& specification : manifest.graphicsPipelines)
+	{
+		//Every graphics pipeline draws to the swapchain, whose format can change between runs on the same device
+		specification.swapchainImageFormat = swapchainFormat;
+		specification.depthFormat = depthFormat;
+		specification.extendedDynamicState = extendedDynamicStateSupported;
+		specification.device = device;
+		specification.pipelineCache = pipelineCache;
+		specification.creationLog = &pipelineCreationLog;
+	}
+	for (vkInit::ComputePipelineInBundle& specification : manifest.computePipelines)
+	{
+		specification.device = device;
+		specification.pipelineCache = pipelineCache;
+		specification.creationLog = &pipelineCreationLog;
+	}
+
+	if (pipelineRegistry->prewarm(manifest) == 0)
+		return;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	size_t landed = pipelineRegistry->finish_pending();
+	pipelineCacheDirty = true;
+	if (debugMode)
+	{
+		std::cout << "Prewarmed " << landed << " pipeline(s) in "
+			<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+	}
+}
+
 void Engine::make_pipeline()
 {
 	vkInit::GraphicsPipelineInBundle specification = {};
 	specification.device = device;
-	specification.vertexFilepath = "./source/Bell/Core/Shaders/vertex.spv";
-	specification.fragmentFilepath = "./source/Bell/Core/Shaders/fragment.spv";
-	specification.swapchainExtent = swapchainExtent;
+	specification.vertexFilepath = "./source/Bell/Core/Shaders/shader.vert";
+	specification.fragmentFilepath = "./source/Bell/Core/Shaders/shader.frag";
 	specification.swapchainImageFormat = swapchainFormat;
+	specification.extendedDynamicState = extendedDynamicStateSupported;
+	specification.depthFormat = depthFormat;
+	specification.pipelineCache = pipelineCache;
+	specification.creationLog = &pipelineCreationLog;
 
-	vkInit::GraphicsPipelineOutBundle output = vkInit::make_graphics_pipeline(specification, debugMode);
-	layout = output.layout;
-	renderpass = output.renderpass;
-	pipeline = output.pipeline;
+	layout = pipelineRegistry->get_layout(specification);
+	renderpass = pipelineRegistry->get_renderpass(swapchainFormat, depthFormat);
+	pipeline = pipelineRegistry->get_graphics_pipeline(specification);
+	pipelineCacheDirty = true;
 }
 
-void Engine::finalize_setup()
+void Engine::make_mesh_pipeline(vkMesh::VertexFormat format)
 {
-	vkInit::framebufferInput frameBufferInput;
-	frameBufferInput.device = device;
-	frameBufferInput.renderpass = renderpass;
-	frameBufferInput.swapchainExtent = swapchainExtent;
-	vkInit::make_framebuffers(frameBufferInput, swapchainFrames, debugMode);
+	vkInit::GraphicsPipelineInBundle specification = {};
+	specification.device = device;
+	specification.fragmentFilepath = "./source/Bell/Core/Shaders/shader.frag";
+	specification.swapchainImageFormat = swapchainFormat;
+	specification.extendedDynamicState = extendedDynamicStateSupported;
+	specification.depthFormat = depthFormat;
+	specification.pipelineCache = pipelineCache;
+	specification.creationLog = &pipelineCreationLog;
+
+	if (format == vkMesh::VertexFormat::eQuantized)
+	{
+		specification.vertexFilepath = "./source/Bell/Core/Shaders/mesh_quantized.vert";
+		specification.bindingDescriptions = { vkMesh::QuantizedVertex::binding_description() };
+		specification.attributeDescriptions = vkMesh::QuantizedVertex::attribute_descriptions();
+	}
+	else
+	{
+		specification.vertexFilepath = "./source/Bell/Core/Shaders/mesh.vert";
+		specification.bindingDescriptions = { vkMesh::Vertex::binding_description() };
+		specification.attributeDescriptions = vkMesh::Vertex::attribute_descriptions();
+	}
+
+	//Instances come from their own binding
+	std::vector<vk::VertexInputAttributeDescription> instanceAttributes = vkMesh::InstanceData::attribute_descriptions(format);
+	specification.bindingDescriptions.push_back(vkMesh::InstanceData::binding_description());
+	specification.attributeDescriptions.insert(specification.attributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.end());
+
+	//glTF winds front faces counter-clockwise, and the projection flips y
+	specification.frontFace = vk::FrontFace::eCounterClockwise;
+
+	//Variants compile on a worker, shader reflection and the layout it gives included, the default one is asked for now so it's usually ready first
+	vkInit::PipelineVariants* variants = new vkInit::PipelineVariants(pipelineRegistry, specification, vkMesh::materialFeatureCount);
+	variants->get(vkMesh::defaultMaterialFeatures);
+	if (format == vkMesh::VertexFormat::eQuantized)
+		quantizedMeshPipelines = variants;
+	else
+		meshPipelines = variants;
+
+	if (shaderWatcher)
+	{
+		for (const std::string& file : pipelineRegistry->source_files())
+			shaderWatcher->watch(file);
+	}
+}
+
+void Engine::make_culling_pipelines()
+{
+	//Frustum culling alone, then the two phases of occlusion culling
+	std::array<const char*, cullPassCount> passDefines = { nullptr, "OCCLUSION_PHASE=1", "OCCLUSION_PHASE=2" };
+	for (uint32_t pass = 0; pass < cullPassCount; pass++)
+	{
+		vkInit::ComputePipelineInBundle specification = {};
+		specification.device = device;
+		specification.computeFilepath = "./source/Bell/Core/Shaders/cull_instances.comp";
+		specification.pipelineCache = pipelineCache;
+		specification.creationLog = &pipelineCreationLog;
+		if (passDefines[pass])
+			specification.shaderDefines.push_back(passDefines[pass]);
+
+		cullLayouts[pass] = pipelineRegistry->get_layout(specification);
+		cullPipelines[pass] = pipelineRegistry->get_compute_pipeline(specification);
+		cullWorkgroupSize = pipelineRegistry->workgroup_size(specification);
+
+		specification.computeFilepath = "./source/Bell/Core/Shaders/cull_clusters.comp";
+		clusterLayouts[pass] = pipelineRegistry->get_layout(specification);
+		clusterPipelines[pass] = pipelineRegistry->get_compute_pipeline(specification);
+		clusterWorkgroupSize = pipelineRegistry->workgroup_size(specification);
+	}
+
+	vkInit::ComputePipelineInBundle pyramidSpecification = {};
+	pyramidSpecification.device = device;
+	pyramidSpecification.computeFilepath = "./source/Bell/Core/Shaders/depth_pyramid.comp";
+	pyramidSpecification.pipelineCache = pipelineCache;
+	pyramidSpecification.creationLog = &pipelineCreationLog;
+	depthPyramidLayout = pipelineRegistry->get_layout(pyramidSpecification);
+	depthPyramidPipeline = pipelineRegistry->get_compute_pipeline(pyramidSpecification);
+	depthPyramidWorkgroupSize = pipelineRegistry->workgroup_size(pyramidSpecification);
+	pipelineCacheDirty = true;
+
+	firstRenderpass = pipelineRegistry->get_renderpass(swapchainFormat, depthFormat, vkInit::RenderPassStage::eFirst);
+	lastRenderpass = pipelineRegistry->get_renderpass(swapchainFormat, depthFormat, vkInit::RenderPassStage::eLast);
+
+	//Instances in, visible instances out and the draw commands counting them, then for occlusion
+	//the visibility history and the depth pyramid. Meshlet culling reads meshlets and jobs as well
+	std::vector<vk::DescriptorPoolSize> poolSizes = {
+		vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, (3 + 4 + 4) + (4 + 5 + 5)),
+		vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, 2) };
+	descriptorPool = vkInit::make_descriptor_pool(device, poolSizes, 2 * cullPassCount, debugMode);
+	make_culling_descriptor_sets();
+}
+
+void Engine::make_culling_descriptor_sets()
+{
+	for (uint32_t pass = 0; pass < cullPassCount; pass++)
+	{
+		const std::vector<vk::DescriptorSetLayout>& setLayouts = pipelineRegistry->descriptor_set_layouts(cullLayouts[pass]);
+		if (descriptorPool && !setLayouts.empty())
+			cullDescriptorSets[pass] = vkInit::allocate_descriptor_set(device, descriptorPool, setLayouts[0], debugMode);
+
+		const std::vector<vk::DescriptorSetLayout>& clusterSetLayouts = pipelineRegistry->descriptor_set_layouts(clusterLayouts[pass]);
+		if (descriptorPool && !clusterSetLayouts.empty())
+			clusterDescriptorSets[pass] = vkInit::allocate_descriptor_set(device, descriptorPool, clusterSetLayouts[0], debugMode);
+	}
+
+	//Without a set to bind the pass can't run
+	if (!cullDescriptorSets[eCullFrustum])
+		frustumCulling = false;
+	if (!clusterDescriptorSets[eCullFrustum])
+		clusterCulling = false;
+}
+
+/*
+* A reload can change the set layouts reflected from the culling shaders, and the sets allocated
+* against the old ones can't be bound with the new pipelines. Called between frames, once nothing
+* is in flight.
+*/
+void Engine::refresh_culling_layouts()
+{
+	bool changed = false;
+	for (uint32_t pass = 0; pass < cullPassCount; pass++)
+	{
+		vk::PipelineLayout cullLayout = pipelineRegistry->find_layout(cullPipelines[pass]);
+		if (cullLayout && cullLayout != cullLayouts[pass])
+		{
+			cullLayouts[pass] = cullLayout;
+			changed = true;
+		}
+
+		vk::PipelineLayout clusterLayout = pipelineRegistry->find_layout(clusterPipelines[pass]);
+		if (clusterLayout && clusterLayout != clusterLayouts[pass])
+		{
+			clusterLayouts[pass] = clusterLayout;
+			changed = true;
+		}
+	}
+
+	//The pyramid allocates its own sets, it's made again on first use
+	vk::PipelineLayout pyramidLayout = pipelineRegistry->find_layout(depthPyramidPipeline);
+	if (pyramidLayout && pyramidLayout != depthPyramidLayout)
+	{
+		depthPyramidLayout = pyramidLayout;
+		delete depthPyramid;
+		depthPyramid = nullptr;
+		cullDescriptorPyramid = nullptr;
+		clusterDescriptorPyramid = nullptr;
+	}
+
+	if (!changed || !descriptorPool)
+		return;
+
+	if (debugMode)
+		std::cout << "Culling layouts changed, allocating their descriptor sets again" << std::endl;
+
+	//The pool can't free single sets, so all of them are allocated again and written on next use
+	device.resetDescriptorPool(descriptorPool);
+	cullDescriptorSets = {};
+	clusterDescriptorSets = {};
+	make_culling_descriptor_sets();
+	cullDescriptorBuffers = {};
+	clusterDescriptorBuffers = {};
+	cullDescriptorPyramid = nullptr;
+	clusterDescriptorPyramid = nullptr;
+}
+
+void Engine::set_frustum_culling(bool enabled)
+{
+	frustumCulling = enabled && cullDescriptorSets[eCullFrustum];
+}
+
+void Engine::set_occlusion_culling(bool enabled)
+{
+	occlusionCulling = enabled && depthSampleable && cullDescriptorSets[eCullFirstPhase] && cullDescriptorSets[eCullSecondPhase]
+		&& !pipelineRegistry->descriptor_set_layouts(depthPyramidLayout).empty();
+
+	//Whatever was recorded before is stale by now
+	visibilityInstanceCount = 0;
+	clusterVisibilityCount = 0;
+
+	if (debugMode && enabled && !occlusionCulling)
+		std::cout << "Occlusion culling isn't available on this device" << std::endl;
+}
+
+void Engine::set_cluster_culling(bool enabled)
+{
+	clusterCulling = enabled && clusterDescriptorSets[eCullFrustum];
+}
+
+uint32_t Engine::load_model(const char* filename, vkMesh::VertexFormat format)
+{
+	uint32_t firstMesh = static_cast<uint32_t>(meshes.size());
+	auto start = std::chrono::steady_clock::now();
+
+	//Cooked meshes are mapped and copied straight to the staging buffers, the source is only parsed on a cache miss
+	std::string cachePath = vkMesh::mesh_cache_path(filename);
+	vkMesh::MeshCache cache;
+	std::vector<vkMesh::MeshData> meshData;
+	std::vector<vkMesh::MeshView> meshViews;
+
+	if (cache.open(cachePath, filename))
+	{
+		meshViews = cache.meshes();
+		if (debugMode)
+			std::cout << "Using mesh cache \"" << cachePath << "\"" << std::endl;
+	}
+	else
+	{
+		meshData = vkMesh::build_static_batches(vkMesh::load_gltf(filename, debugMode), debugMode);
+		vkMesh::build_meshlets(meshData, debugMode);
+		vkMesh::write_mesh_cache(cachePath, filename, meshData, debugMode);
+		meshViews.assign(meshData.begin(), meshData.end());
+	}
+
+	if (meshViews.empty())
+		return firstMesh;
+
+	if (format == vkMesh::VertexFormat::eQuantized && !quantizedMeshPipelines)
+		make_mesh_pipeline(format);
+	else if (format == vkMesh::VertexFormat::eFloat && !meshPipelines)
+		make_mesh_pipeline(format);
+
+	vkMesh::MeshUploadChunk uploadChunk = {};
+	uploadChunk.logicalDevice = device;
+	uploadChunk.physicalDevice = physicalDevice;
+	uploadChunk.queue = graphicsQueue;
+	uploadChunk.commandBuffer = mainCommandBuffer;
+	uploadChunk.statistics = &memoryStatistics;
+	uploadChunk.deferDestroy = [this](std::function<void()>&& destroyer) { defer_destroy(std::move(destroyer)); };
+
+	//Sized for a typical scene up front, it doubles when a load doesn't fit
+	if (!geometryPool.vertexBuffer)
+		geometryPool = vkMesh::make_geometry_pool(uploadChunk, 32 << 20, 16 << 20, 1 << 20);
+
+	size_t vertexBytes = 0;
+	for (const vkMesh::MeshView& view : meshViews)
+	{
+		vertexBytes += view.vertexCount * (format == vkMesh::VertexFormat::eQuantized ? sizeof(vkMesh::QuantizedVertex) : sizeof(vkMesh::Vertex));
+
+		if (meshes.empty())
+		{
+			sceneBoundsMin = view.boundsMin;
+			sceneBoundsMax = view.boundsMax;
+		}
+		sceneBoundsMin = glm::min(sceneBoundsMin, view.boundsMin);
+		sceneBoundsMax = glm::max(sceneBoundsMax, view.boundsMax);
+
+		meshes.push_back(vkMesh::upload_mesh(view, geometryPool, uploadChunk, format));
+	}
+
+	if (debugMode)
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		std::cout << "Uploaded " << meshViews.size() << " mesh(es) from \"" << filename << "\" in " << elapsed.count() << " ms, "
+			<< vertexBytes << " bytes of vertices" << std::endl;
+	}
+	return firstMesh;
+}
+
+void Engine::draw_mesh(uint32_t meshIndex, const glm::mat4& transform, const glm::vec4& color, uint32_t materialIndex)
+{
+	vkMesh::InstanceData instance;
+	instance.transform = transform;
+	instance.color = color;
+	instance.materialIndex = materialIndex;
+	instanceBatcher.submit(meshIndex, instance);
+}
+
+//Per frame buffers double when they grow, so a slowly rising count doesn't reallocate every frame
+static vk::DeviceSize grown_capacity(vk::DeviceSize capacity, vk::DeviceSize size)
+{
+	capacity = std::max<vk::DeviceSize>(capacity * 2, 64 * 1024);
+	while (capacity < size)
+		capacity *= 2;
+	return capacity;
+}
+
+void Engine::reserve_host_buffer(vkUtil::HostBuffer& buffer, vk::DeviceSize size, vk::BufferUsageFlags usage, const char* name)
+{
+	if (size <= buffer.size)
+		return;
+
+	//The old buffer may still be read by the frame in flight
+	if (buffer.buffer)
+	{
+		vk::Device owner = device;
+		vkUtil::HostBuffer retired = buffer;
+		vkUtil::MemoryStatistics* statistics = &memoryStatistics;
+		defer_destroy([owner, retired, statistics]() mutable
+			{
+				vkUtil::destroyHostBuffer(owner, retired, statistics);
+			});
+	}
+
+	vkUtil::BufferInputChunk inputChunk = {};
+	inputChunk.logicalDevice = device;
+	inputChunk.physicalDevice = physicalDevice;
+	inputChunk.size = grown_capacity(buffer.size, size);
+	inputChunk.usage = usage;
+	inputChunk.category = vkUtil::MemoryCategory::eBuffer;
+	inputChunk.statistics = &memoryStatistics;
+	buffer = vkUtil::createHostBuffer(inputChunk);
+
+	if (debugMode)
+		std::cout << "The " << name << " buffer holds " << buffer.size << " bytes" << std::endl;
+}
+
+void Engine::reserve_device_buffer(vkUtil::Buffer& buffer, vk::DeviceSize size, vk::BufferUsageFlags usage, const char* name)
+{
+	if (size <= buffer.size)
+		return;
 
+	if (buffer.buffer)
+	{
+		vk::Device owner = device;
+		vkUtil::Buffer retired = buffer;
+		vkUtil::MemoryStatistics* statistics = &memoryStatistics;
+		defer_destroy([owner, retired, statistics]() mutable
+			{
+				vkUtil::destroyBuffer(owner, retired, statistics);
+			});
+	}
+
+	vkUtil::BufferInputChunk inputChunk = {};
+	inputChunk.logicalDevice = device;
+	inputChunk.physicalDevice = physicalDevice;
+	inputChunk.size = grown_capacity(buffer.size, size);
+	inputChunk.usage = usage;
+	inputChunk.memoryProperties = vk::MemoryPropertyFlagBits::eDeviceLocal;
+	inputChunk.category = vkUtil::MemoryCategory::eBuffer;
+	inputChunk.statistics = &memoryStatistics;
+	buffer = vkUtil::createBuffer(inputChunk);
+
+	if (debugMode)
+		std::cout << "The " << name << " buffer holds " << buffer.size << " bytes" << std::endl;
+}
+
+void Engine::finalize_setup()
+{
 	commandPool = vkInit::make_command_pool(device, physicalDevice, surface, debugMode);
 
+	make_frame_resources();
+
 	vkInit::commandBufferInputChunk commandBufferInput = { device, commandPool, swapchainFrames };
-	mainCommandBuffer = vkInit::make_command_buffers(commandBufferInput, debugMode);
+	mainCommandBuffer = vkInit::make_command_buffer(commandBufferInput, debugMode);
 
 	inFlightFence = vkInit::make_fence(device, debugMode);
 	imageAvailable = vkInit::make_semaphore(device, debugMode);
 	renderFinished = vkInit::make_semaphore(device, debugMode);
 }
 
+void Engine::prepare_culling(vk::CommandBuffer commandBuffer, uint32_t instanceCount, bool occlusion)
+{
+	reserve_device_buffer(culledInstanceBuffer, instanceCount * sizeof(vkMesh::InstanceData),
+		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer, "culled instance");
+
+	if (occlusion)
+	{
+		reserve_device_buffer(visibilityBuffer, instanceCount * sizeof(uint32_t),
+			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, "visibility");
+
+		if (!depthPyramid)
+		{
+			vkUtil::DepthPyramidInput pyramidInput = {};
+			pyramidInput.device = device;
+			pyramidInput.physicalDevice = physicalDevice;
+			pyramidInput.depthExtent = swapchainExtent;
+			pyramidInput.setLayout = pipelineRegistry->descriptor_set_layouts(depthPyramidLayout)[0];
+			pyramidInput.statistics = &memoryStatistics;
+			depthPyramid = new vkUtil::DepthPyramid(pyramidInput, debugMode);
+		}
+
+		//Instances are known by their place in the sorted instance list. When the count changes the
+		//history means nothing and every instance counts as visible once. A reordering with the same
+		//count only costs time, the second phase still finds everything the first one missed
+		if (visibilityInstanceCount != instanceCount)
+		{
+			commandBuffer.fillBuffer(visibilityBuffer.buffer, 0, VK_WHOLE_SIZE, 1);
+			vkUtil::memory_barrier(commandBuffer, vkUtil::transfer_to_compute());
+			visibilityInstanceCount = instanceCount;
+		}
+	}
+
+	//Rewritten only when a buffer was replaced, the sets aren't in use while recording. The frustum
+	//pass has no visibility binding
+	std::array<vk::Buffer, 4> buffers = { instanceBuffer.buffer, culledInstanceBuffer.buffer, indirectBuffer.buffer, visibilityBuffer.buffer };
+	if (buffers != cullDescriptorBuffers)
+	{
+		for (uint32_t pass = 0; pass < cullPassCount; pass++)
+		{
+			uint32_t bindingCount = pass == eCullFrustum ? 3 : 4;
+			for (uint32_t binding = 0; binding < bindingCount; binding++)
+			{
+				if (cullDescriptorSets[pass] && buffers[binding])
+					vkInit::write_buffer_descriptor(device, cullDescriptorSets[pass], binding, vk::DescriptorType::eStorageBuffer, buffers[binding]);
+			}
+		}
+		cullDescriptorBuffers = buffers;
+	}
+
+	if (occlusion && depthPyramid->view() != cullDescriptorPyramid)
+	{
+		vkInit::write_image_descriptor(device, cullDescriptorSets[eCullSecondPhase], 4, vk::DescriptorType::eCombinedImageSampler,
+			depthPyramid->view(), vk::ImageLayout::eGeneral, depthPyramid->sampler());
+		cullDescriptorPyramid = depthPyramid->view();
+	}
+}
+
+void Engine::record_culling(vk::CommandBuffer commandBuffer, CullPass pass, vk::Pipeline cullingPipeline, const glm::mat4& viewProjection,
+	uint32_t instanceCount, uint32_t drawOffset)
+{
+	vkUtil::CullConstants constants = vkUtil::make_cull_constants(viewProjection, instanceCount, drawOffset);
+
+	vkUtil::ComputeDispatch dispatch;
+	dispatch.pipeline = cullingPipeline;
+	dispatch.layout = pipelineRegistry->find_layout(cullPipelines[pass]);
+	dispatch.descriptorSets = { cullDescriptorSets[pass] };
+	dispatch.pushConstants = &constants;
+	dispatch.pushConstantSize = sizeof(constants);
+	dispatch.workgroupSize = cullWorkgroupSize;
+	vkUtil::dispatch_items(commandBuffer, dispatch, instanceCount);
+
+	vkUtil::memory_barrier(commandBuffer, vkUtil::compute_to_graphics());
+}
+
+void Engine::prepare_cluster_culling(vk::CommandBuffer commandBuffer, uint32_t commandCount, bool occlusion)
+{
+	//The second phase writes a second copy of the commands
+	reserve_device_buffer(clusterCommandBuffer, (occlusion ? 2 : 1) * commandCount * sizeof(vk::DrawIndexedIndirectCommand),
+		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer, "cluster command");
+
+	//Keyed by command like the instance history is by instance, and reset the same way
+	if (occlusion)
+	{
+		reserve_device_buffer(clusterVisibilityBuffer, commandCount * sizeof(uint32_t),
+			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, "cluster visibility");
+
+		if (clusterVisibilityCount != commandCount)
+		{
+			commandBuffer.fillBuffer(clusterVisibilityBuffer.buffer, 0, VK_WHOLE_SIZE, 1);
+			vkUtil::memory_barrier(commandBuffer, vkUtil::transfer_to_compute());
+			clusterVisibilityCount = commandCount;
+		}
+	}
+
+	std::array<vk::Buffer, 5> buffers = { instanceBuffer.buffer, geometryPool.meshletBuffer, clusterJobBuffer.buffer,
+		clusterCommandBuffer.buffer, clusterVisibilityBuffer.buffer };
+	if (buffers != clusterDescriptorBuffers)
+	{
+		for (uint32_t pass = 0; pass < cullPassCount; pass++)
+		{
+			uint32_t bindingCount = pass == eCullFrustum ? 4 : 5;
+			for (uint32_t binding = 0; binding < bindingCount; binding++)
+			{
+				if (clusterDescriptorSets[pass] && buffers[binding])
+					vkInit::write_buffer_descriptor(device, clusterDescriptorSets[pass], binding, vk::DescriptorType::eStorageBuffer, buffers[binding]);
+			}
+		}
+		clusterDescriptorBuffers = buffers;
+	}
+
+	//prepare_culling has made the pyramid by now
+	if (occlusion && depthPyramid->view() != clusterDescriptorPyramid)
+	{
+		vkInit::write_image_descriptor(device, clusterDescriptorSets[eCullSecondPhase], 5, vk::DescriptorType::eCombinedImageSampler,
+			depthPyramid->view(), vk::ImageLayout::eGeneral, depthPyramid->sampler());
+		clusterDescriptorPyramid = depthPyramid->view();
+	}
+}
+
+void Engine::record_cluster_culling(vk::CommandBuffer commandBuffer, CullPass pass, vk::Pipeline cullingPipeline, const glm::mat4& viewProjection,
+	const glm::vec3& cameraPosition, uint32_t jobCount, uint32_t maxMeshletCount, uint32_t drawOffset)
+{
+	vkUtil::ClusterCullConstants constants = vkUtil::make_cluster_cull_constants(viewProjection, cameraPosition, jobCount, drawOffset);
+
+	vkUtil::ComputeDispatch dispatch;
+	dispatch.pipeline = cullingPipeline;
+	dispatch.layout = pipelineRegistry->find_layout(clusterPipelines[pass]);
+	dispatch.descriptorSets = { clusterDescriptorSets[pass] };
+	dispatch.pushConstants = &constants;
+	dispatch.pushConstantSize = sizeof(constants);
+	dispatch.workgroupSize = clusterWorkgroupSize;
+
+	//A row of workgroups per job, the shader loops when there are more jobs than the guaranteed rows
+	vkUtil::dispatch(commandBuffer, dispatch, vkUtil::group_count(maxMeshletCount, clusterWorkgroupSize.x), std::min(jobCount, 65535u));
+
+	vkUtil::memory_barrier(commandBuffer, vkUtil::compute_to_graphics());
+}
+
 void Engine::record_draw_commands(vk::CommandBuffer commandBuffer, uint32_t imageIndex)
 {
 	vk::CommandBufferBeginInfo beginInfo = {};
@@ -107,21 +737,277 @@ void Engine::record_draw_commands(vk::CommandBuffer commandBuffer, uint32_t imag
 			std::cout << "Failed to begin recording command buffer" << std::endl;
 	}
 
-	vk::RenderPassBeginInfo renderPassInfo = {};
-	renderPassInfo.renderPass = renderpass;
-	renderPassInfo.framebuffer = swapchainFrames[imageIndex].framebuffer;
-	renderPassInfo.renderArea.offset.x = 0;
-	renderPassInfo.renderArea.offset.y = 0;
-	renderPassInfo.renderArea.extent = swapchainExtent;
+	//Instances and draw commands are written, and culled, before the render pass begins since
+	//dispatches can't be recorded inside one
+	vkMesh::MeshConstants constants = {};
+	std::vector<vk::DrawIndexedIndirectCommand> indirectCommands;
+	std::vector<vkUtil::IndirectBucket> buckets;
+	vk::Buffer drawnInstances = nullptr;
+	uint32_t instanceCount = 0;
+	uint32_t commandCount = 0;
+
+	//Occlusion culling needs every one of its pipelines built
+	bool occlusion = false;
+	vk::Pipeline firstPhasePipeline = nullptr;
+	vk::Pipeline secondPhasePipeline = nullptr;
+	vk::Pipeline pyramidPipeline = nullptr;
+
+	//Meshlet culling, for meshes with enough meshlets
+	std::vector<vkUtil::ClusterJob> clusterJobs;
+	std::vector<vkUtil::IndirectBucket> clusterBuckets;
+	uint32_t clusterCommandCount = 0;
+	uint32_t maxJobMeshletCount = 0;
+	vk::Pipeline clusterPipeline = nullptr;
+	vk::Pipeline clusterSecondPhasePipeline = nullptr;
+	glm::vec3 cameraPosition(0.0f);
+	if (meshes.empty())
+	{
+		//Nothing to instance yet
+		instanceBatcher.clear();
+	}
+	else
+	{
+		//Frame the whole scene from slightly above
+		glm::vec3 center = 0.5f * (sceneBoundsMin + sceneBoundsMax);
+		float radius = std::max(0.5f * glm::length(sceneBoundsMax - sceneBoundsMin), 0.001f);
+		cameraPosition = center + radius * glm::vec3(0.0f, 0.75f, 2.5f);
+		glm::mat4 view = glm::lookAt(cameraPosition, center, glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 projection = glm::perspective(glm::radians(45.0f),
+			float(swapchainExtent.width) / float(swapchainExtent.height), radius * 0.05f, radius * 10.0f);
+		projection[1][1] *= -1;
+		constants.viewProjection = projection * view;
+
+		//Loaded meshes are already in world space, then whatever was submitted this frame
+		for (uint32_t i = 0; i < meshes.size(); i++)
+			instanceBatcher.submit(i, vkMesh::InstanceData());
+		instanceBatcher.build(meshes);
+		instanceBatcher.clear();
+		const std::vector<vkMesh::InstanceData>& instances = instanceBatcher.instances();
+		reserve_host_buffer(instanceBuffer, instances.size() * sizeof(vkMesh::InstanceData),
+			vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer, "instance");
+		memcpy(instanceBuffer.data, instances.data(), instances.size() * sizeof(vkMesh::InstanceData));
+		drawnInstances = instanceBuffer.buffer;
+
+		if (indirectDrawSupported)
+		{
+			if (occlusionCulling)
+			{
+				firstPhasePipeline = pipelineRegistry->find(cullPipelines[eCullFirstPhase]);
+				secondPhasePipeline = pipelineRegistry->find(cullPipelines[eCullSecondPhase]);
+				pyramidPipeline = pipelineRegistry->find(depthPyramidPipeline);
+				occlusion = firstPhasePipeline && secondPhasePipeline && pyramidPipeline;
+			}
+
+			//Clustered meshes are drawn whole unless every pass meshlet culling needs is built
+			if (clusterCulling)
+			{
+				clusterPipeline = pipelineRegistry->find(clusterPipelines[occlusion ? eCullFirstPhase : eCullFrustum]);
+				if (occlusion)
+				{
+					clusterSecondPhasePipeline = pipelineRegistry->find(clusterPipelines[eCullSecondPhase]);
+					if (!clusterSecondPhasePipeline)
+						clusterPipeline = nullptr;
+				}
+			}
+
+			//The history goes stale while nothing keeps it
+			if (!occlusion)
+				visibilityInstanceCount = 0;
+			if (!occlusion || !clusterPipeline)
+				clusterVisibilityCount = 0;
+
+			vkUtil::build_indirect_commands(instanceBatcher.batches(), meshes, indirectCommands, buckets, static_cast<bool>(clusterPipeline));
+			instanceCount = static_cast<uint32_t>(instances.size());
+			commandCount = static_cast<uint32_t>(indirectCommands.size());
+			if (clusterPipeline)
+				clusterCommandCount = vkUtil::build_cluster_jobs(instanceBatcher.batches(), meshes, clusterJobs, clusterBuckets, maxJobMeshletCount);
+
+			//The culling passes count the instances that survive back in
+			vk::Pipeline cullingPipeline = occlusion ? firstPhasePipeline
+				: frustumCulling ? pipelineRegistry->find(cullPipelines[eCullFrustum]) : nullptr;
+			if (cullingPipeline)
+			{
+				for (vk::DrawIndexedIndirectCommand& command : indirectCommands)
+					command.instanceCount = 0;
+			}
+
+			//The second phase counts into its own copy of the commands
+			if (occlusion)
+			{
+				indirectCommands.resize(2 * commandCount);
+				std::copy_n(indirectCommands.begin(), commandCount, indirectCommands.begin() + commandCount);
+			}
+
+			reserve_host_buffer(indirectBuffer, indirectCommands.size() * sizeof(vk::DrawIndexedIndirectCommand),
+				vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eStorageBuffer, "indirect");
+			memcpy(indirectBuffer.data, indirectCommands.data(), indirectCommands.size() * sizeof(vk::DrawIndexedIndirectCommand));
+
+			if (cullingPipeline)
+			{
+				prepare_culling(commandBuffer, instanceCount, occlusion);
+				record_culling(commandBuffer, occlusion ? eCullFirstPhase : eCullFrustum, cullingPipeline, constants.viewProjection, instanceCount, 0);
+				drawnInstances = culledInstanceBuffer.buffer;
+			}
+
+			if (!clusterJobs.empty())
+			{
+				reserve_host_buffer(clusterJobBuffer, clusterJobs.size() * sizeof(vkUtil::ClusterJob),
+					vk::BufferUsageFlagBits::eStorageBuffer, "cluster job");
+				memcpy(clusterJobBuffer.data, clusterJobs.data(), clusterJobs.size() * sizeof(vkUtil::ClusterJob));
+
+				prepare_cluster_culling(commandBuffer, clusterCommandCount, occlusion);
+				record_cluster_culling(commandBuffer, occlusion ? eCullFirstPhase : eCullFrustum, clusterPipeline, constants.viewProjection,
+					cameraPosition, static_cast<uint32_t>(clusterJobs.size()), maxJobMeshletCount, 0);
+			}
+		}
+	}
+
 	vk::ClearValue clearColor = { std::array<float, 4>{1.0f, 0.5f, 0.25f, 1.0f} };
-	renderPassInfo.clearValueCount = 1;
-	renderPassInfo.pClearValues = &clearColor;
+	vk::ClearValue clearDepth;
+	clearDepth.depthStencil = vk::ClearDepthStencilValue(1.0f, 0);
+	std::array<vk::ClearValue, 2> clearValues = { clearColor, clearDepth };
+	auto begin_pass = [&](vk::RenderPass pass)
+		{
+			vk::RenderPassBeginInfo renderPassInfo = {};
+			renderPassInfo.renderPass = pass;
+			renderPassInfo.framebuffer = swapchainFrames[imageIndex].framebuffer;
+			renderPassInfo.renderArea.offset.x = 0;
+			renderPassInfo.renderArea.offset.y = 0;
+			renderPassInfo.renderArea.extent = swapchainExtent;
+			renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+			renderPassInfo.pClearValues = clearValues.data();
+
+			commandBuffer.beginRenderPass(&renderPassInfo, vk::SubpassContents::eInline);
+
+			vkUtil::set_viewport(commandBuffer, swapchainExtent);
+		};
+
+	//The first pass keeps its attachments for the second, which loads them
+	begin_pass(occlusion ? firstRenderpass : renderpass);
+
+	if (meshes.empty())
+	{
+		vk::Pipeline trianglePipeline = pipelineRegistry->find(pipeline);
+		if (trianglePipeline)
+		{
+			commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, trianglePipeline);
+			if (extendedDynamicStateSupported)
+				vkUtil::set_raster_state(commandBuffer, vkUtil::RasterState(), dldi);
+
+			commandBuffer.draw(3, 1, 0, 0);
+		}
+	}
+	else
+	{
+		//Every mesh is a range of the same two buffers, every instance of the instance buffer
+		std::array<vk::Buffer, 2> vertexBuffers = { geometryPool.vertexBuffer, drawnInstances };
+		std::array<vk::DeviceSize, 2> offsets = { 0, 0 };
+		commandBuffer.bindIndexBuffer(geometryPool.indexBuffer, 0, vk::IndexType::eUint32);
+
+		//glTF winds front faces counter-clockwise, and the projection flips y
+		vkUtil::RasterState meshRasterState;
+		meshRasterState.frontFace = vk::FrontFace::eCounterClockwise;
+		if (extendedDynamicStateSupported)
+			vkUtil::set_raster_state(commandBuffer, meshRasterState, dldi);
+
+		//Push constants are the same for every draw, they're pushed again only when a pipeline with
+		//another layout is bound
+		vk::Pipeline boundPipeline = nullptr;
+		vk::PipelineLayout pushedLayout = nullptr;
+		auto bind_mesh_pipeline = [&](const vkMesh::Mesh& mesh)
+			{
+				bool quantized = mesh.vertexFormat == vkMesh::VertexFormat::eQuantized;
+				vkInit::PipelineVariants* variants = quantized ? quantizedMeshPipelines : meshPipelines;
+				uint64_t key = variants->get(mesh.features);
+				vk::Pipeline meshPipeline = pipelineRegistry->find(key);
+				if (meshPipeline && meshPipeline != boundPipeline)
+				{
+					commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, meshPipeline);
+					boundPipeline = meshPipeline;
+
+					vk::PipelineLayout meshLayout = pipelineRegistry->find_layout(key);
+					if (meshLayout != pushedLayout)
+					{
+						commandBuffer.pushConstants(meshLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(constants), &constants);
+						pushedLayout = meshLayout;
+					}
+				}
+				return static_cast<bool>(meshPipeline);
+			};
 
-	commandBuffer.beginRenderPass(&renderPassInfo, vk::SubpassContents::eInline);
+		//Meshlets draw from the instances as they were submitted, the culled ones are packed by batch
+		auto draw_meshes = [&](uint32_t commandOffset, uint32_t clusterCommandOffset)
+			{
+				commandBuffer.bindVertexBuffers(0, static_cast<uint32_t>(vertexBuffers.size()), vertexBuffers.data(), offsets.data());
+				if (indirectDrawSupported)
+				{
+					for (const vkUtil::IndirectBucket& bucket : buckets)
+					{
+						if (bind_mesh_pipeline(meshes[bucket.meshIndex]))
+							vkUtil::draw_indirect_bucket(commandBuffer, indirectBuffer.buffer, bucket, maxIndirectDrawCount, commandOffset);
+					}
+				}
+				else
+				{
+					for (const vkUtil::InstanceBatch& batch : instanceBatcher.batches())
+					{
+						const vkMesh::Mesh& mesh = meshes[batch.meshIndex];
+						if (bind_mesh_pipeline(mesh))
+							commandBuffer.drawIndexed(mesh.indexCount, batch.instanceCount, mesh.firstIndex, mesh.vertexOffset, batch.firstInstance);
+					}
+				}
 
-	commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+				if (!clusterJobs.empty())
+				{
+					commandBuffer.bindVertexBuffers(1, 1, &instanceBuffer.buffer, offsets.data());
+					for (const vkUtil::IndirectBucket& bucket : clusterBuckets)
+					{
+						if (bind_mesh_pipeline(meshes[bucket.meshIndex]))
+							vkUtil::draw_indirect_bucket(commandBuffer, clusterCommandBuffer.buffer, bucket, maxIndirectDrawCount, clusterCommandOffset);
+					}
+				}
+			};
 
-	commandBuffer.draw(3, 1, 0, 0);
+		draw_meshes(0, 0);
+
+		if (occlusion)
+		{
+			/*
+			* What was visible last frame is drawn, so its depth is the occluder for everything else.
+			* The pyramid is built from it, the second phase draws what the first missed and becomes
+			* the visibility of the next frame
+			*/
+			commandBuffer.endRenderPass();
+
+			const vkUtil::SwapChainFrame& frame = swapchainFrames[imageIndex];
+			vk::ImageAspectFlags depthAspects = vkImage::depth_image_aspects(depthFormat);
+			vkUtil::image_barrier(commandBuffer, vkUtil::graphics_to_compute(), frame.depthBuffer, depthAspects,
+				vk::ImageLayout::eDepthStencilAttachmentOptimal, vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+
+			vkUtil::ComputeDispatch pyramidDispatch;
+			pyramidDispatch.pipeline = pyramidPipeline;
+			pyramidDispatch.layout = pipelineRegistry->find_layout(depthPyramidPipeline);
+			pyramidDispatch.workgroupSize = depthPyramidWorkgroupSize;
+			depthPyramid->record(commandBuffer, pyramidDispatch, frame.depthBufferView);
+
+			record_culling(commandBuffer, eCullSecondPhase, secondPhasePipeline, constants.viewProjection, instanceCount, commandCount);
+			if (!clusterJobs.empty())
+			{
+				record_cluster_culling(commandBuffer, eCullSecondPhase, clusterSecondPhasePipeline, constants.viewProjection,
+					cameraPosition, static_cast<uint32_t>(clusterJobs.size()), maxJobMeshletCount, clusterCommandCount);
+			}
+
+			vkUtil::image_barrier(commandBuffer, vkUtil::compute_to_depth_attachment(), frame.depthBuffer, depthAspects,
+				vk::ImageLayout::eDepthStencilReadOnlyOptimal, vk::ImageLayout::eDepthStencilAttachmentOptimal);
+
+			//Graphics bindings outlive the render pass, but the dispatches pushed their own constants
+			begin_pass(lastRenderpass);
+			if (pushedLayout)
+				commandBuffer.pushConstants(pushedLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(constants), &constants);
+
+			draw_meshes(commandCount, clusterCommandCount);
+		}
+	}
 
 	commandBuffer.endRenderPass();
 
@@ -136,12 +1022,77 @@ void Engine::record_draw_commands(vk::CommandBuffer commandBuffer, uint32_t imag
 	}
 }
 
+void Engine::save_pipeline_cache()
+{
+	vkUtil::save_pipeline_cache(device, physicalDevice, pipelineCache, pipelineCacheFilename, debugMode);
+	pipelineCacheDirty = false;
+	lastPipelineCacheSave = std::chrono::steady_clock::now();
+}
+
+void Engine::enable_shader_hot_reload()
+{
+	if (!shaderWatcher)
+		shaderWatcher = new vkUtil::FileWatcher();
+
+	//Reloads read the sources being edited, not the SPIR-V built into the executable
+	vkUtil::embedded_shaders_enabled() = false;
+
+	//Pipelines requested later add their sources in make_mesh_pipeline
+	for (const std::string& file : pipelineRegistry->source_files())
+		shaderWatcher->watch(file);
+
+	if (debugMode)
+		std::cout << "Watching " << shaderWatcher->watched_count() << " shader source(s) for changes" << std::endl;
+}
+
 void Engine::render()
 {
 	device.waitForFences(1, &inFlightFence, VK_TRUE, UINT64_MAX);
-	device.resetFences(1, &inFlightFence);
 
-	uint32_t imageIndex{ device.acquireNextImageKHR(swapchain, UINT64_MAX, imageAvailable, nullptr).value };
+	//The fence guards the only frame in flight, so everything submitted so far has now completed
+	completedFrames = submittedFrames;
+	deletionQueue.flush(completedFrames);
+
+	//Saved shaders are recompiled in the background, the pipelines using them swap over in poll below
+	if (shaderWatcher)
+	{
+		std::vector<std::string> changed = shaderWatcher->poll();
+		if (!changed.empty())
+			pipelineRegistry->reload(changed);
+	}
+
+	//Pipelines finished by the background compiler are picked up here, between frames
+	if (pipelineRegistry->poll() > 0)
+	{
+		pipelineCacheDirty = true;
+		refresh_culling_layouts();
+	}
+
+	//Persist newly compiled pipelines now and then, so a crash doesn't lose them
+	if (pipelineCacheDirty && std::chrono::steady_clock::now() - lastPipelineCacheSave > pipelineCacheSaveInterval)
+		save_pipeline_cache();
+
+	//A minimized window has nothing to draw to
+	int framebufferWidth = 0, framebufferHeight = 0;
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+	if (framebufferWidth == 0 || framebufferHeight == 0)
+		return;
+	if (framebufferWidth != width || framebufferHeight != height)
+		recreate_swapchain();
+
+	uint32_t imageIndex;
+	try
+	{
+		imageIndex = device.acquireNextImageKHR(swapchain, UINT64_MAX, imageAvailable, nullptr).value;
+	}
+	catch (vk::OutOfDateKHRError err)
+	{
+		recreate_swapchain();
+		return;
+	}
+
+	//Only once a frame is certain to be submitted, or the next wait would never return
+	device.resetFences(1, &inFlightFence);
 
 	vk::CommandBuffer commandBuffer = swapchainFrames[imageIndex].commandBuffer;
 
@@ -164,6 +1115,7 @@ void Engine::render()
 	try 
 	{
 		graphicsQueue.submit(submitInfo, inFlightFence);
+		submittedFrames++;
 	}
 	catch (vk::SystemError err)
 	{
@@ -179,7 +1131,61 @@ void Engine::render()
 	presentInfo.pSwapchains = swapchains;
 	presentInfo.pImageIndices = &imageIndex;
 
-	presentQueue.presentKHR(presentInfo);
+	vk::Result present;
+	try
+	{
+		present = presentQueue.presentKHR(presentInfo);
+	}
+	catch (vk::OutOfDateKHRError err)
+	{
+		present = vk::Result::eErrorOutOfDateKHR;
+	}
+	if (present != vk::Result::eSuccess)
+		recreate_swapchain();
+}
+
+void Engine::defer_destroy(std::function<void()>&& destroyer)
+{
+	deletionQueue.push(submittedFrames, std::move(destroyer));
+}
+
+const vkUtil::MemoryStatistics& Engine::memory_statistics()
+{
+	memoryStatistics.refresh(physicalDevice, memoryBudgetSupported);
+	return memoryStatistics;
+}
+
+void Engine::dump_memory_statistics(const char* filename)
+{
+	std::ofstream file(filename, std::ios::trunc);
+
+	if (!file.is_open())
+	{
+		if (debugMode)
+			std::cout << "Failed to open \"" << filename << "\" for the memory report" << std::endl;
+		return;
+	}
+
+	file << memory_statistics().to_json();
+}
+
+const vkUtil::PipelineCreationLog& Engine::pipeline_creation_log() const
+{
+	return pipelineCreationLog;
+}
+
+void Engine::dump_pipeline_report(const char* filename, vkUtil::PipelineReportOrder order)
+{
+	std::ofstream file(filename, std::ios::trunc);
+
+	if (!file.is_open())
+	{
+		if (debugMode)
+			std::cout << "Failed to open \"" << filename << "\" for the pipeline report" << std::endl;
+		return;
+	}
+
+	file << pipelineCreationLog.to_json(order);
 }
 
 Engine::~Engine()
@@ -188,23 +1194,67 @@ Engine::~Engine()
 
 	if (debugMode)
 		std::cout << "Closing engine" << std::endl;
+
+	size_t retired = deletionQueue.flush_all();
+	if (debugMode)
+		std::cout << "Destroyed " << retired << " deferred resource(s)" << std::endl;
 	
 	device.destroyFence(inFlightFence);
 	device.destroySemaphore(imageAvailable);
 	device.destroySemaphore(renderFinished);
 
+	destroy_swapchain();
 	device.destroyCommandPool(commandPool);
 
-	device.destroyPipeline(pipeline);
-	device.destroyPipelineLayout(layout);
-	device.destroyRenderPass(renderpass);
+	for (vkMesh::Mesh& mesh : meshes)
+		vkMesh::free_mesh(geometryPool, mesh, &memoryStatistics);
+	if (geometryPool.vertexBuffer)
+		vkMesh::destroy_geometry_pool(device, geometryPool, &memoryStatistics);
+	if (instanceBuffer.buffer)
+		vkUtil::destroyHostBuffer(device, instanceBuffer, &memoryStatistics);
+	if (indirectBuffer.buffer)
+		vkUtil::destroyHostBuffer(device, indirectBuffer, &memoryStatistics);
+	if (culledInstanceBuffer.buffer)
+		vkUtil::destroyBuffer(device, culledInstanceBuffer, &memoryStatistics);
+	if (visibilityBuffer.buffer)
+		vkUtil::destroyBuffer(device, visibilityBuffer, &memoryStatistics);
+	if (clusterJobBuffer.buffer)
+		vkUtil::destroyHostBuffer(device, clusterJobBuffer, &memoryStatistics);
+	if (clusterCommandBuffer.buffer)
+		vkUtil::destroyBuffer(device, clusterCommandBuffer, &memoryStatistics);
+	if (clusterVisibilityBuffer.buffer)
+		vkUtil::destroyBuffer(device, clusterVisibilityBuffer, &memoryStatistics);
+	device.destroyDescriptorPool(descriptorPool);
 
-	for (vkUtil::SwapChainFrame frame : swapchainFrames)
+	vkInit::PipelineManifest manifest = pipelineRegistry->manifest();
+	manifest.device = vkInit::make_pipeline_manifest_device(physicalDevice);
+	vkUtil::save_pipeline_manifest(manifest, pipelineManifestFilename, debugMode);
+
+	delete shaderWatcher;
+	delete meshPipelines;
+	delete quantizedMeshPipelines;
+	delete pipelineRegistry;
+
+	if (debugMode && pipelineCreationLog.size() > 0)
+		std::cout << "Slowest pipelines to create:\n" << pipelineCreationLog.to_string(vkUtil::PipelineReportOrder::eWallTime, 10);
+
+	vkUtil::ShaderOptimizationStatistics shaderStatistics = vkUtil::shader_optimization_statistics();
+	if (debugMode && shaderStatistics.moduleCount > 0)
 	{
-		device.destroyImageView(frame.imageView);
-		device.destroyFramebuffer(frame.framebuffer);
+		std::cout << "Optimized " << shaderStatistics.moduleCount << " shader module(s): " << shaderStatistics.bytesBefore << " -> "
+			<< shaderStatistics.bytesAfter << " bytes (" << int(shaderStatistics.size_reduction() * 100.0) << "% smaller), "
+			<< shaderStatistics.instructionsBefore << " -> " << shaderStatistics.instructionsAfter << " instructions" << std::endl;
 	}
+
+	if (pipelineCacheDirty)
+		save_pipeline_cache();
+	device.destroyPipelineCache(pipelineCache);
+
 	device.destroySwapchainKHR(swapchain);
+
+	if (debugMode && memoryStatistics.live_allocations() > 0)
+		std::cout << "Leaked GPU allocations at shutdown:\n" << memory_statistics().to_json() << std::endl;
+
 	device.destroy();
 
 	instance.destroySurfaceKHR(surface);
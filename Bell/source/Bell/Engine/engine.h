@@ -3,6 +3,25 @@
 #include <GLFW/glfw3.h>
 #include "config.h"
 #include "frame.h"
+#include "buffers.h"
+#include "deletion_queue.h"
+#include "memory_stats.h"
+#include "pipeline_stats.h"
+#include <Model/mesh.h>
+#include <Render/instancing.h>
+#include <chrono>
+
+namespace vkInit
+{
+	class PipelineRegistry;
+	class PipelineVariants;
+}
+
+namespace vkUtil
+{
+	class FileWatcher;
+	class DepthPyramid;
+}
 
 class Engine
 {
@@ -14,6 +33,47 @@ public:
 
 	void render();
 
+	//Import a glTF/glb file and upload its meshes, they are drawn every frame from then on.
+	//Returns the index of the first mesh it added, for draw_mesh
+	uint32_t load_model(const char* filename, vkMesh::VertexFormat format = vkMesh::VertexFormat::eFloat);
+
+	//Draw one more instance of a loaded mesh in the next frame. Instances of the same mesh
+	//are merged into a single instanced draw
+	void draw_mesh(uint32_t meshIndex, const glm::mat4& transform, const glm::vec4& color = glm::vec4(1.0f), uint32_t materialIndex = 0);
+
+	//Destroy a resource once every frame submitted so far has finished on the GPU
+	void defer_destroy(std::function<void()>&& destroyer);
+
+	//GPU memory usage per heap and category, refreshed from the driver on every call
+	const vkUtil::MemoryStatistics& memory_statistics();
+
+	//Write the current memory statistics as JSON
+	void dump_memory_statistics(const char* filename);
+
+	//Write the pipeline cache to disk now, it is also saved periodically and at shutdown
+	void save_pipeline_cache();
+
+	//How long each pipeline took to create, and where the driver spent that time when it can tell
+	const vkUtil::PipelineCreationLog& pipeline_creation_log() const;
+
+	//Write the pipeline creation report as JSON
+	void dump_pipeline_report(const char* filename, vkUtil::PipelineReportOrder order = vkUtil::PipelineReportOrder::eWallTime);
+
+	//Watch the shader sources and rebuild the pipelines using them when one is saved
+	void enable_shader_hot_reload();
+
+	//Cull instances against the camera frustum in a compute pass before drawing, on by default.
+	//Only devices with the indirect draw path cull
+	void set_frustum_culling(bool enabled);
+
+	//Two phase hierarchical Z occlusion culling, off by default. It tests the frustum as well, so it
+	//takes over from frustum culling while on. Needs a depth format shaders can sample
+	void set_occlusion_culling(bool enabled);
+
+	//Cull the meshlets of large meshes one by one, by frustum, normal cone and, with occlusion culling,
+	//the depth pyramid, on by default. Off, they're culled and drawn whole like any other mesh
+	void set_cluster_culling(bool enabled);
+
 private:
 
 	//Wether to print debug messages in functions
@@ -39,11 +99,100 @@ private:
 	std::vector<vkUtil::SwapChainFrame> swapchainFrames;
 	vk::Format swapchainFormat;
 	vk::Extent2D swapchainExtent;
+	vk::Format depthFormat;
+	bool extendedDynamicStateSupported{ false };
+
+	//Memory-related variables
+	vkUtil::MemoryStatistics memoryStatistics;
+	bool memoryBudgetSupported{ false };
 
 	//Pipeline-related variables
+	vk::PipelineCache pipelineCache;
+	bool pipelineCacheDirty{ false };
+	std::chrono::steady_clock::time_point lastPipelineCacheSave;
+	vkUtil::PipelineCreationLog pipelineCreationLog;
+
+	//Owns every pipeline, layout and render pass below, identical requests share handles.
+	//Pipelines are held as registry keys so a reload can swap them underneath
+	vkInit::PipelineRegistry* pipelineRegistry{ nullptr };
 	vk::PipelineLayout layout;
 	vk::RenderPass renderpass;
-	vk::Pipeline pipeline;
+	uint64_t pipeline{ 0 };
+
+	//Shader hot reload, only made when enabled
+	vkUtil::FileWatcher* shaderWatcher{ nullptr };
+
+	//Mesh pipelines, made on the first load_model call that uses their vertex format. Each material
+	//feature combination is a variant, compiled in the background the first time a mesh needs it.
+	//Layouts come from the registry with the pipeline, a reload can change them
+	vkInit::PipelineVariants* meshPipelines{ nullptr };
+	vkInit::PipelineVariants* quantizedMeshPipelines{ nullptr };
+
+	//Scene-related variables, every mesh lives in the geometry pool
+	vkMesh::GeometryPool geometryPool;
+	std::vector<vkMesh::Mesh> meshes;
+	glm::vec3 sceneBoundsMin{ 0.0f };
+	glm::vec3 sceneBoundsMax{ 0.0f };
+
+	//Instancing-related variables. Every loaded mesh is drawn once in place each frame, plus the
+	//instances submitted through draw_mesh
+	vkUtil::InstanceBatcher instanceBatcher;
+	vkUtil::HostBuffer instanceBuffer;
+
+	//Indirect drawing, one command per instance batch and one draw call per pipeline. Without
+	//drawIndirectFirstInstance the batches are drawn directly instead
+	bool indirectDrawSupported{ false };
+	uint32_t maxIndirectDrawCount{ 1 };
+	vkUtil::HostBuffer indirectBuffer;
+
+	//GPU culling. A compute pass packs the visible instances into culledInstanceBuffer and counts them
+	//into the indirect commands, which are then drawn from it. cull_instances.comp is built once per pass
+	enum CullPass
+	{
+		eCullFrustum,
+		eCullFirstPhase,
+		eCullSecondPhase,
+		cullPassCount
+	};
+	bool frustumCulling{ true };
+	std::array<uint64_t, cullPassCount> cullPipelines{};
+	std::array<vk::PipelineLayout, cullPassCount> cullLayouts;
+	std::array<vk::DescriptorSet, cullPassCount> cullDescriptorSets;
+	glm::uvec3 cullWorkgroupSize{ 1, 1, 1 };
+	vk::DescriptorPool descriptorPool;
+	std::array<vk::Buffer, 4> cullDescriptorBuffers;
+	vk::ImageView cullDescriptorPyramid;
+	vkUtil::Buffer culledInstanceBuffer{};
+
+	//Occlusion culling. The instances visible last frame are drawn first, the depth they leave is reduced
+	//into the depth pyramid, and the rest are tested against it and drawn by a second render pass.
+	//visibilityBuffer keeps each instance's result for the next frame. The pyramid is made on first use
+	//and again with the swapchain
+	bool occlusionCulling{ false };
+	bool depthSampleable{ false };
+	vk::RenderPass firstRenderpass;
+	vk::RenderPass lastRenderpass;
+	uint64_t depthPyramidPipeline{ 0 };
+	vk::PipelineLayout depthPyramidLayout;
+	glm::uvec3 depthPyramidWorkgroupSize{ 1, 1, 1 };
+	vkUtil::DepthPyramid* depthPyramid{ nullptr };
+	vkUtil::Buffer visibilityBuffer{};
+	uint32_t visibilityInstanceCount{ 0 };
+
+	//Meshlet culling. Instances of clustered meshes become jobs in clusterJobBuffer, cull_clusters.comp
+	//writes a command per meshlet into clusterCommandBuffer and they draw from the unculled instances.
+	//It runs the same passes as instance culling, next to them, and keeps its own visibility
+	bool clusterCulling{ true };
+	std::array<uint64_t, cullPassCount> clusterPipelines{};
+	std::array<vk::PipelineLayout, cullPassCount> clusterLayouts;
+	std::array<vk::DescriptorSet, cullPassCount> clusterDescriptorSets;
+	glm::uvec3 clusterWorkgroupSize{ 1, 1, 1 };
+	std::array<vk::Buffer, 5> clusterDescriptorBuffers;
+	vk::ImageView clusterDescriptorPyramid;
+	vkUtil::HostBuffer clusterJobBuffer{};
+	vkUtil::Buffer clusterCommandBuffer{};
+	vkUtil::Buffer clusterVisibilityBuffer{};
+	uint32_t clusterVisibilityCount{ 0 };
 
 	//Command-related variables
 	vk::CommandPool commandPool;
@@ -53,16 +202,48 @@ private:
 	vk::Fence inFlightFence;
 	vk::Semaphore imageAvailable, renderFinished;
 
+	//Deferred destruction, keyed by the number of frames submitted
+	uint64_t submittedFrames{ 0 };
+	uint64_t completedFrames{ 0 };
+	vkUtil::DeletionQueue deletionQueue;
+
 	//Instance setup
 	void make_instance();
 
 	//Device setup
 	void make_device();
 
-	//Pipeline setup
+	//Swapchain setup, remade when the window's framebuffer changes size. Pipelines don't depend on it
+	void make_swapchain();
+	void make_frame_resources();
+	void destroy_swapchain();
+	void recreate_swapchain();
+
+	//Pipeline setup. Every pipeline the last session used is compiled on the workers first
+	void prewarm_pipelines();
 	void make_pipeline();
+	void make_mesh_pipeline(vkMesh::VertexFormat format);
+	void make_culling_pipelines();
+	void make_culling_descriptor_sets();
+	void refresh_culling_layouts();
 
 	void finalize_setup();
 
+	//Grow a per frame buffer to hold at least size bytes, the old one is destroyed once the GPU is done with it
+	void reserve_host_buffer(vkUtil::HostBuffer& buffer, vk::DeviceSize size, vk::BufferUsageFlags usage, const char* name);
+	void reserve_device_buffer(vkUtil::Buffer& buffer, vk::DeviceSize size, vk::BufferUsageFlags usage, const char* name);
+
+	//Size the culling buffers for this frame's instances and point the descriptor sets at them
+	void prepare_culling(vk::CommandBuffer commandBuffer, uint32_t instanceCount, bool occlusion);
+
+	//Record a culling dispatch for the instances and indirect commands already written this frame
+	void record_culling(vk::CommandBuffer commandBuffer, CullPass pass, vk::Pipeline cullingPipeline, const glm::mat4& viewProjection,
+		uint32_t instanceCount, uint32_t drawOffset);
+
+	//The same for the meshlets of the cluster jobs already written this frame
+	void prepare_cluster_culling(vk::CommandBuffer commandBuffer, uint32_t commandCount, bool occlusion);
+	void record_cluster_culling(vk::CommandBuffer commandBuffer, CullPass pass, vk::Pipeline cullingPipeline, const glm::mat4& viewProjection,
+		const glm::vec3& cameraPosition, uint32_t jobCount, uint32_t maxMeshletCount, uint32_t drawOffset);
+
 	void record_draw_commands(vk::CommandBuffer commandBuffer, uint32_t imageIndex);
 };
\ No newline at end of file
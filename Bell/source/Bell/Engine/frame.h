@@ -9,6 +9,10 @@ namespace vkUtil
 		vk::ImageView imageView;
 		vk::Framebuffer framebuffer;
 		vk::CommandBuffer commandBuffer;
+
+		vk::Image depthBuffer;
+		vk::DeviceMemory depthBufferMemory;
+		vk::ImageView depthBufferView;
 	};
 
 }
\ No newline at end of file
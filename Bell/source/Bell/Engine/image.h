@@ -0,0 +1,115 @@
+#pragma once
+#include "config.h"
+#include "memory.h"
+
+namespace vkImage
+{
+	struct ImageInputChunk
+	{
+		vk::Device logicalDevice;
+		vk::PhysicalDevice physicalDevice;
+		uint32_t width, height;
+		vk::ImageTiling tiling;
+		vk::ImageUsageFlags usage;
+		vk::MemoryPropertyFlags memoryProperties;
+		vk::Format format;
+		vkUtil::MemoryCategory category;
+		vkUtil::MemoryStatistics* statistics;
+		uint32_t mipLevels{ 1 };
+	};
+
+	vk::Image make_image(const ImageInputChunk& input)
+	{
+		vk::ImageCreateInfo imageInfo = {};
+		imageInfo.flags = vk::ImageCreateFlags();
+		imageInfo.imageType = vk::ImageType::e2D;
+		imageInfo.extent = vk::Extent3D(input.width, input.height, 1);
+		imageInfo.mipLevels = input.mipLevels;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = input.format;
+		imageInfo.tiling = input.tiling;
+		imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+		imageInfo.usage = input.usage;
+		imageInfo.sharingMode = vk::SharingMode::eExclusive;
+		imageInfo.samples = vk::SampleCountFlagBits::e1;
+
+		try
+		{
+			return input.logicalDevice.createImage(imageInfo);
+		}
+		catch (vk::SystemError err)
+		{
+			std::cout << "Unable to make image" << std::endl;
+			return nullptr;
+		}
+	}
+
+	vk::DeviceMemory make_image_memory(const ImageInputChunk& input, vk::Image image)
+	{
+		vk::MemoryRequirements requirements = input.logicalDevice.getImageMemoryRequirements(image);
+
+		vk::MemoryAllocateInfo allocation = {};
+		allocation.allocationSize = requirements.size;
+
+		try
+		{
+			allocation.memoryTypeIndex = vkUtil::findMemoryTypeIndex(input.physicalDevice, requirements.memoryTypeBits, input.memoryProperties);
+			vk::DeviceMemory imageMemory = input.logicalDevice.allocateMemory(allocation);
+			input.logicalDevice.bindImageMemory(image, imageMemory, 0);
+
+			if (input.statistics)
+				input.statistics->track(imageMemory, allocation.memoryTypeIndex, input.category, requirements.size, requirements.size);
+
+			return imageMemory;
+		}
+		catch (vk::SystemError err)
+		{
+			std::cout << "Unable to allocate memory for image" << std::endl;
+			return nullptr;
+		}
+	}
+
+	vk::ImageView make_image_view(vk::Device logicalDevice, vk::Image image, vk::Format format, vk::ImageAspectFlags aspect,
+		uint32_t baseMipLevel = 0, uint32_t mipLevelCount = 1)
+	{
+		vk::ImageViewCreateInfo createInfo = {};
+		createInfo.image = image;
+		createInfo.viewType = vk::ImageViewType::e2D;
+		createInfo.format = format;
+		createInfo.components.r = vk::ComponentSwizzle::eIdentity;
+		createInfo.components.g = vk::ComponentSwizzle::eIdentity;
+		createInfo.components.b = vk::ComponentSwizzle::eIdentity;
+		createInfo.components.a = vk::ComponentSwizzle::eIdentity;
+		createInfo.subresourceRange.aspectMask = aspect;
+		createInfo.subresourceRange.baseMipLevel = baseMipLevel;
+		createInfo.subresourceRange.levelCount = mipLevelCount;
+		createInfo.subresourceRange.baseArrayLayer = 0;
+		createInfo.subresourceRange.layerCount = 1;
+
+		return logicalDevice.createImageView(createInfo);
+	}
+
+	//Layout transitions of a depth stencil image cover both aspects
+	vk::ImageAspectFlags depth_image_aspects(vk::Format format)
+	{
+		if (format == vk::Format::eD24UnormS8Uint || format == vk::Format::eD32SfloatS8Uint || format == vk::Format::eD16UnormS8Uint)
+			return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+		return vk::ImageAspectFlagBits::eDepth;
+	}
+
+	vk::Format find_supported_format(vk::PhysicalDevice physicalDevice, const std::vector<vk::Format>& candidates, vk::ImageTiling tiling, vk::FormatFeatureFlags features)
+	{
+		for (vk::Format format : candidates)
+		{
+			vk::FormatProperties properties = physicalDevice.getFormatProperties(format);
+
+			if (tiling == vk::ImageTiling::eLinear && (properties.linearTilingFeatures & features) == features)
+				return format;
+
+			if (tiling == vk::ImageTiling::eOptimal && (properties.optimalTilingFeatures & features) == features)
+				return format;
+		}
+
+		throw std::runtime_error("Unable to find suitable format");
+	}
+}
@@ -85,7 +85,8 @@ namespace vkInit
 		version &= ~(0xFFFU);
 		 
 		//Or use an earlier version to ensure compatibility with more devices
-		version = VK_MAKE_API_VERSION(0, 1, 0, 0);
+		//1.1 is needed to query memory budgets, optional features are still checked per device
+		version = std::min(version, VK_MAKE_API_VERSION(0, 1, 1, 0));
 
 		vk::ApplicationInfo appInfo = vk::ApplicationInfo(
 			applicationName,
@@ -194,6 +194,15 @@ This mode may result in visible tearing if rendering to the image is not timed c
 		default:
 			std::cout << "Other\n";
 		}
+
+		vk::PhysicalDeviceMemoryProperties memoryProperties = device.getMemoryProperties();
+		for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+		{
+			std::cout << "Memory heap " << i << ": " << (memoryProperties.memoryHeaps[i].size >> 20) << " MiB";
+			if (memoryProperties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+				std::cout << ", device local";
+			std::cout << "\n";
+		}
 	}
 
 }
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+#include "config.h"
+#include "memory_stats.h"
+#include "buffers.h"
+
+namespace vkUtil
+{
+	struct BufferInputChunk
+	{
+		size_t size;
+		vk::BufferUsageFlags usage;
+		vk::Device logicalDevice;
+		vk::PhysicalDevice physicalDevice;
+		vk::MemoryPropertyFlags memoryProperties;
+		MemoryCategory category;
+		MemoryStatistics* statistics;
+	};
+
+	//Throws if no memory type has the requested properties, falling back to another type would pick the wrong heap
+	uint32_t findMemoryTypeIndex(vk::PhysicalDevice physicalDevice, uint32_t supportedMemoryIndices, vk::MemoryPropertyFlags requestedProperties)
+	{
+		vk::PhysicalDeviceMemoryProperties memoryProperties = physicalDevice.getMemoryProperties();
+
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		{
+			//Bit i of supportedMemoryIndices is set if memory type i can be used
+			bool supported{ static_cast<bool>(supportedMemoryIndices & (1 << i)) };
+
+			bool sufficient{ (memoryProperties.memoryTypes[i].propertyFlags & requestedProperties) == requestedProperties };
+
+			if (supported && sufficient)
+				return i;
+		}
+
+		std::cout << "No memory type with properties " << vk::to_string(requestedProperties) << " in type bits " << supportedMemoryIndices << std::endl;
+		throw vk::OutOfDeviceMemoryError("No suitable memory type");
+	}
+
+	vk::DeviceMemory allocateMemory(const BufferInputChunk& input, vk::MemoryRequirements requirements, vk::DeviceSize usedBytes)
+	{
+		vk::MemoryAllocateInfo allocInfo = {};
+		allocInfo.allocationSize = requirements.size;
+		allocInfo.memoryTypeIndex = findMemoryTypeIndex(input.physicalDevice, requirements.memoryTypeBits, input.memoryProperties);
+
+		vk::DeviceMemory memory = input.logicalDevice.allocateMemory(allocInfo);
+
+		if (input.statistics)
+			input.statistics->track(memory, allocInfo.memoryTypeIndex, input.category, requirements.size, usedBytes);
+
+		return memory;
+	}
+
+	void allocateBufferMemory(Buffer& buffer, const BufferInputChunk& input)
+	{
+		vk::MemoryRequirements memoryRequirements = input.logicalDevice.getBufferMemoryRequirements(buffer.buffer);
+
+		buffer.bufferMemory = allocateMemory(input, memoryRequirements, input.size);
+		input.logicalDevice.bindBufferMemory(buffer.buffer, buffer.bufferMemory, 0);
+	}
+
+	Buffer createBuffer(const BufferInputChunk& input)
+	{
+		vk::BufferCreateInfo bufferInfo = {};
+		bufferInfo.flags = vk::BufferCreateFlags();
+		bufferInfo.size = input.size;
+		bufferInfo.usage = input.usage;
+		bufferInfo.sharingMode = vk::SharingMode::eExclusive;
+
+		Buffer buffer;
+		buffer.buffer = input.logicalDevice.createBuffer(bufferInfo);
+		buffer.size = input.size;
+
+		allocateBufferMemory(buffer, input);
+
+		return buffer;
+	}
+
+	void destroyBuffer(vk::Device device, Buffer& buffer, MemoryStatistics* statistics)
+	{
+		if (statistics)
+			statistics->untrack(buffer.bufferMemory);
+
+		device.destroyBuffer(buffer.buffer);
+		device.freeMemory(buffer.bufferMemory);
+		buffer.buffer = nullptr;
+		buffer.bufferMemory = nullptr;
+	}
+
+	//The memory properties of the input are replaced with host visible and coherent
+	HostBuffer createHostBuffer(BufferInputChunk input)
+	{
+		input.memoryProperties = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+		Buffer created = createBuffer(input);
+
+		HostBuffer buffer;
+		buffer.buffer = created.buffer;
+		buffer.memory = created.bufferMemory;
+		buffer.data = input.logicalDevice.mapMemory(buffer.memory, 0, input.size);
+		buffer.size = input.size;
+		return buffer;
+	}
+
+	void destroyHostBuffer(vk::Device device, HostBuffer& buffer, MemoryStatistics* statistics)
+	{
+		if (statistics)
+			statistics->untrack(buffer.memory);
+
+		device.unmapMemory(buffer.memory);
+		device.destroyBuffer(buffer.buffer);
+		device.freeMemory(buffer.memory);
+		buffer = HostBuffer();
+	}
+
+	//Blocking copy, for uploads outside the frame loop
+	void copyBuffer(Buffer& srcBuffer, Buffer& dstBuffer, vk::DeviceSize size, vk::Queue queue, vk::CommandBuffer commandBuffer, vk::DeviceSize dstOffset = 0)
+	{
+		commandBuffer.reset();
+
+		vk::CommandBufferBeginInfo beginInfo = {};
+		beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+		commandBuffer.begin(beginInfo);
+
+		vk::BufferCopy copyRegion = {};
+		copyRegion.srcOffset = 0;
+		copyRegion.dstOffset = dstOffset;
+		copyRegion.size = size;
+		commandBuffer.copyBuffer(srcBuffer.buffer, dstBuffer.buffer, 1, &copyRegion);
+
+		commandBuffer.end();
+
+		vk::SubmitInfo submitInfo = {};
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		queue.submit(submitInfo, nullptr);
+		queue.waitIdle();
+	}
+}
@@ -0,0 +1,213 @@
+#pragma once
+#include "config.h"
+#include <unordered_map>
+#include <iomanip>
+
+namespace vkUtil
+{
+	enum class MemoryCategory
+	{
+		eTexture,
+		eBuffer,
+		eRenderTarget,
+		eStaging,
+		eCount
+	};
+
+	inline const char* to_string(MemoryCategory category)
+	{
+		switch (category)
+		{
+		case MemoryCategory::eTexture:
+			return "textures";
+		case MemoryCategory::eBuffer:
+			return "buffers";
+		case MemoryCategory::eRenderTarget:
+			return "render_targets";
+		case MemoryCategory::eStaging:
+			return "staging";
+		default:
+			return "unknown";
+		}
+	}
+
+	struct HeapStatistics
+	{
+		vk::DeviceSize size{ 0 };
+		bool deviceLocal{ false };
+
+		//What the driver reports for the whole process (VK_EXT_memory_budget), or our own totals without it
+		vk::DeviceSize budget{ 0 };
+		vk::DeviceSize usage{ 0 };
+
+		//What Bell itself has allocated from the heap, and how much of that is actually handed out
+		vk::DeviceSize allocatedBytes{ 0 };
+		vk::DeviceSize usedBytes{ 0 };
+		uint32_t allocationCount{ 0 };
+
+		//Fraction of allocated bytes not handed out to resources (alignment padding, free space in pools)
+		double fragmentation() const
+		{
+			if (allocatedBytes == 0)
+				return 0.0;
+			return double(allocatedBytes - usedBytes) / double(allocatedBytes);
+		}
+	};
+
+	struct CategoryStatistics
+	{
+		vk::DeviceSize bytes{ 0 };
+		vk::DeviceSize peakBytes{ 0 };
+		uint32_t allocationCount{ 0 };
+	};
+
+	//Tracks every vk::DeviceMemory the engine allocates, so usage can be read at runtime or dumped as JSON
+	class MemoryStatistics
+	{
+	public:
+
+		void set_memory_properties(const vk::PhysicalDeviceMemoryProperties& properties)
+		{
+			memoryProperties = properties;
+			heaps.resize(properties.memoryHeapCount);
+			for (uint32_t i = 0; i < properties.memoryHeapCount; i++)
+			{
+				heaps[i].size = properties.memoryHeaps[i].size;
+				heaps[i].deviceLocal = bool(properties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+				heaps[i].budget = heaps[i].size;
+			}
+		}
+
+		//usedBytes can be lower than allocatedBytes for allocations that are sub-allocated from later (pools)
+		void track(vk::DeviceMemory memory, uint32_t memoryTypeIndex, MemoryCategory category, vk::DeviceSize allocatedBytes, vk::DeviceSize usedBytes)
+		{
+			Allocation allocation = { memoryProperties.memoryTypes[memoryTypeIndex].heapIndex, category, allocatedBytes, usedBytes };
+			allocations[static_cast<VkDeviceMemory>(memory)] = allocation;
+
+			HeapStatistics& heap = heaps[allocation.heapIndex];
+			heap.allocatedBytes += allocatedBytes;
+			heap.usedBytes += usedBytes;
+			heap.allocationCount++;
+
+			CategoryStatistics& stats = categories[static_cast<size_t>(category)];
+			stats.bytes += allocatedBytes;
+			stats.peakBytes = std::max(stats.peakBytes, stats.bytes);
+			stats.allocationCount++;
+		}
+
+		//For pools: report how much of a tracked allocation is currently handed out
+		void set_used(vk::DeviceMemory memory, vk::DeviceSize usedBytes)
+		{
+			auto it = allocations.find(static_cast<VkDeviceMemory>(memory));
+			if (it == allocations.end())
+				return;
+
+			HeapStatistics& heap = heaps[it->second.heapIndex];
+			heap.usedBytes = heap.usedBytes - it->second.usedBytes + usedBytes;
+			it->second.usedBytes = usedBytes;
+		}
+
+		void untrack(vk::DeviceMemory memory)
+		{
+			auto it = allocations.find(static_cast<VkDeviceMemory>(memory));
+			if (it == allocations.end())
+				return;
+
+			HeapStatistics& heap = heaps[it->second.heapIndex];
+			heap.allocatedBytes -= it->second.allocatedBytes;
+			heap.usedBytes -= it->second.usedBytes;
+			heap.allocationCount--;
+
+			CategoryStatistics& stats = categories[static_cast<size_t>(it->second.category)];
+			stats.bytes -= it->second.allocatedBytes;
+			stats.allocationCount--;
+
+			allocations.erase(it);
+		}
+
+		//Pull the driver's view of each heap, budgetSupported means VK_EXT_memory_budget is enabled on the device
+		void refresh(vk::PhysicalDevice physicalDevice, bool budgetSupported)
+		{
+			if (budgetSupported)
+			{
+				auto chain = physicalDevice.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+				const vk::PhysicalDeviceMemoryBudgetPropertiesEXT& budget = chain.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+				for (size_t i = 0; i < heaps.size(); i++)
+				{
+					heaps[i].budget = budget.heapBudget[i];
+					heaps[i].usage = budget.heapUsage[i];
+				}
+			}
+			else
+			{
+				for (HeapStatistics& heap : heaps)
+				{
+					heap.budget = heap.size;
+					heap.usage = heap.allocatedBytes;
+				}
+			}
+		}
+
+		const std::vector<HeapStatistics>& get_heaps() const
+		{
+			return heaps;
+		}
+
+		const CategoryStatistics& get_category(MemoryCategory category) const
+		{
+			return categories[static_cast<size_t>(category)];
+		}
+
+		size_t live_allocations() const
+		{
+			return allocations.size();
+		}
+
+		std::string to_json() const
+		{
+			std::stringstream json;
+			json << std::fixed << std::setprecision(4);
+			json << "{\n\t\"heaps\": [\n";
+			for (size_t i = 0; i < heaps.size(); i++)
+			{
+				const HeapStatistics& heap = heaps[i];
+				json << "\t\t{ \"index\": " << i
+					<< ", \"deviceLocal\": " << (heap.deviceLocal ? "true" : "false")
+					<< ", \"size\": " << heap.size
+					<< ", \"budget\": " << heap.budget
+					<< ", \"usage\": " << heap.usage
+					<< ", \"allocated\": " << heap.allocatedBytes
+					<< ", \"used\": " << heap.usedBytes
+					<< ", \"allocations\": " << heap.allocationCount
+					<< ", \"fragmentation\": " << heap.fragmentation()
+					<< " }" << (i + 1 < heaps.size() ? "," : "") << "\n";
+			}
+			json << "\t],\n\t\"categories\": {\n";
+			for (size_t i = 0; i < categories.size(); i++)
+			{
+				const CategoryStatistics& stats = categories[i];
+				json << "\t\t\"" << to_string(static_cast<MemoryCategory>(i)) << "\": { \"bytes\": " << stats.bytes
+					<< ", \"peak\": " << stats.peakBytes
+					<< ", \"allocations\": " << stats.allocationCount
+					<< " }" << (i + 1 < categories.size() ? "," : "") << "\n";
+			}
+			json << "\t},\n\t\"liveAllocations\": " << allocations.size() << "\n}\n";
+			return json.str();
+		}
+
+	private:
+
+		struct Allocation
+		{
+			uint32_t heapIndex;
+			MemoryCategory category;
+			vk::DeviceSize allocatedBytes;
+			vk::DeviceSize usedBytes;
+		};
+
+		vk::PhysicalDeviceMemoryProperties memoryProperties;
+		std::vector<HeapStatistics> heaps;
+		std::array<CategoryStatistics, static_cast<size_t>(MemoryCategory::eCount)> categories{};
+		std::unordered_map<VkDeviceMemory, Allocation> allocations;
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "config.h"
 #include <Core/Shaders/shaders.h>
+#include "pipeline_stats.h"
 
 namespace vkInit
 {
@@ -9,8 +10,36 @@ namespace vkInit
 		vk::Device device;
 		std::string vertexFilepath;
 		std::string fragmentFilepath;
-		vk::Extent2D swapchainExtent;
 		vk::Format swapchainImageFormat;
+		vk::Format depthFormat;
+		std::vector<vk::VertexInputBindingDescription> bindingDescriptions;
+		std::vector<vk::VertexInputAttributeDescription> attributeDescriptions;
+		std::vector<vk::PushConstantRange> pushConstantRanges;
+		vk::FrontFace frontFace = vk::FrontFace::eClockwise;
+		vk::PipelineCache pipelineCache = nullptr;
+
+		//Where creation times go, nothing is recorded without one
+		vkUtil::PipelineCreationLog* creationLog = nullptr;
+
+		//Viewport and scissor are always dynamic. With extended dynamic state the cull mode, front face
+		//and depth test, write and compare op are set while recording too, and the values below are ignored
+		bool extendedDynamicState = false;
+
+		//Fixed function state
+		vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+		vk::PolygonMode polygonMode = vk::PolygonMode::eFill;
+		vk::CullModeFlags cullMode = vk::CullModeFlagBits::eBack;
+		bool depthTest = true;
+		bool depthWrite = true;
+		vk::CompareOp depthCompareOp = vk::CompareOp::eLess;
+		bool blendEnable = false;
+
+		//Preprocessor defines for GLSL shaders, "NAME" or "NAME=VALUE"
+		std::vector<std::string> shaderDefines;
+
+		//Specialization constants, applied to both shader stages
+		std::vector<vk::SpecializationMapEntry> specializationEntries;
+		std::vector<uint8_t> specializationData;
 	};
 
 	struct GraphicsPipelineOutBundle
@@ -20,12 +49,15 @@ namespace vkInit
 		vk::Pipeline pipeline;
 	};
 
-	vk::PipelineLayout make_pipeline_layout(vk::Device device, bool debug)
+	vk::PipelineLayout make_pipeline_layout(vk::Device device, const std::vector<vk::DescriptorSetLayout>& setLayouts,
+		const std::vector<vk::PushConstantRange>& pushConstantRanges, bool debug)
 	{
 		vk::PipelineLayoutCreateInfo layoutInfo;
 		layoutInfo.flags = vk::PipelineLayoutCreateFlags();
-		layoutInfo.setLayoutCount = 0;
-		layoutInfo.pushConstantRangeCount = 0;
+		layoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		layoutInfo.pSetLayouts = setLayouts.data();
+		layoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+		layoutInfo.pPushConstantRanges = pushConstantRanges.data();
 		try {
 			return device.createPipelineLayout(layoutInfo);
 		}
@@ -33,38 +65,96 @@ namespace vkInit
 		{
 			if (debug)
 				std::cout << "Failed to create pipeline layout" << std::endl;
+			return nullptr;
 		}
 	}
 
-	vk::RenderPass make_renderpass(vk::Device device, vk::Format swapchainImageFormat, bool debug)
+	vk::PipelineLayout make_pipeline_layout(vk::Device device, const std::vector<vk::PushConstantRange>& pushConstantRanges, bool debug)
+	{
+		return make_pipeline_layout(device, {}, pushConstantRanges, debug);
+	}
+
+	/*
+	* Where a render pass sits in the frame. A frame drawn in one pass clears and presents. Occlusion
+	* culling splits it in two: the first pass clears and keeps its depth for the depth pyramid, the
+	* last continues on top of it and presents. The three are compatible, so pipelines work in any.
+	*/
+	enum class RenderPassStage
+	{
+		eWhole,
+		eFirst,
+		eLast
+	};
+
+	vk::RenderPass make_renderpass(vk::Device device, vk::Format swapchainImageFormat, vk::Format depthFormat, bool debug,
+		RenderPassStage stage = RenderPassStage::eWhole)
 	{
+		bool first = stage == RenderPassStage::eFirst;
+		bool last = stage == RenderPassStage::eLast;
+
 		vk::AttachmentDescription colorAttachment = {};
 		colorAttachment.flags = vk::AttachmentDescriptionFlags();
 		colorAttachment.format = swapchainImageFormat;
 		colorAttachment.samples = vk::SampleCountFlagBits::e1;
-		colorAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+		colorAttachment.loadOp = last ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear;
 		colorAttachment.storeOp = vk::AttachmentStoreOp::eStore;
 		colorAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
 		colorAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
-		colorAttachment.initialLayout = vk::ImageLayout::eUndefined;
-		colorAttachment.finalLayout = vk::ImageLayout::ePresentSrcKHR;
+		colorAttachment.initialLayout = last ? vk::ImageLayout::eColorAttachmentOptimal : vk::ImageLayout::eUndefined;
+		colorAttachment.finalLayout = first ? vk::ImageLayout::eColorAttachmentOptimal : vk::ImageLayout::ePresentSrcKHR;
 
 		vk::AttachmentReference colorAttachmentRef = {};
 		colorAttachmentRef.attachment = 0;
 		colorAttachmentRef.layout = vk::ImageLayout::eColorAttachmentOptimal;
 
+		vk::AttachmentDescription depthAttachment = {};
+		depthAttachment.flags = vk::AttachmentDescriptionFlags();
+		depthAttachment.format = depthFormat;
+		depthAttachment.samples = vk::SampleCountFlagBits::e1;
+		depthAttachment.loadOp = last ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear;
+		depthAttachment.storeOp = first ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+		depthAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+		depthAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+		depthAttachment.initialLayout = last ? vk::ImageLayout::eDepthStencilAttachmentOptimal : vk::ImageLayout::eUndefined;
+		depthAttachment.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+
+		vk::AttachmentReference depthAttachmentRef = {};
+		depthAttachmentRef.attachment = 1;
+		depthAttachmentRef.layout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+
 		vk::SubpassDescription subpass = {};
 		subpass.flags = vk::SubpassDescriptionFlags();
 		subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
 		subpass.colorAttachmentCount = 1;
 		subpass.pColorAttachments = &colorAttachmentRef;
+		subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+		//Wait for the previous use of the attachments before clearing them
+		vk::SubpassDependency dependency = {};
+		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependency.dstSubpass = 0;
+		dependency.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eLateFragmentTests;
+		dependency.srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+		dependency.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests;
+		dependency.dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+
+		//The last pass loads what the first one wrote
+		if (last)
+		{
+			dependency.srcAccessMask |= vk::AccessFlagBits::eColorAttachmentWrite;
+			dependency.dstAccessMask |= vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentRead;
+		}
+
+		std::array<vk::AttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
 
 		vk::RenderPassCreateInfo renderpassInfo = {};
 		renderpassInfo.flags = vk::RenderPassCreateFlags();
-		renderpassInfo.attachmentCount = 1;
-		renderpassInfo.pAttachments = &colorAttachment;
+		renderpassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderpassInfo.pAttachments = attachments.data();
 		renderpassInfo.subpassCount = 1;
 		renderpassInfo.pSubpasses = &subpass;
+		renderpassInfo.dependencyCount = 1;
+		renderpassInfo.pDependencies = &dependency;
 
 		try {
 			return device.createRenderPass(renderpassInfo);
@@ -75,95 +165,192 @@ namespace vkInit
 		}
 	}
 
-	GraphicsPipelineOutBundle make_graphics_pipeline(GraphicsPipelineInBundle specification, bool debug)
+	std::string shader_file_name(const std::string& filename)
 	{
+		size_t slash = filename.find_last_of("/\\");
+		return slash == std::string::npos ? filename : filename.substr(slash + 1);
+	}
+
+	//How a pipeline appears in the creation report
+	std::string pipeline_name(const GraphicsPipelineInBundle& specification)
+	{
+		std::string name = shader_file_name(specification.vertexFilepath) + " + " + shader_file_name(specification.fragmentFilepath);
+		for (const std::string& define : specification.shaderDefines)
+			name += " " + define;
+		if (!specification.specializationData.empty())
+		{
+			std::stringstream constants;
+			constants << " [" << std::hex;
+			for (uint8_t byte : specification.specializationData)
+				constants << std::setw(2) << std::setfill('0') << uint32_t(byte);
+			constants << "]";
+			name += constants.str();
+		}
+		return name;
+	}
+
+	//The four parts VK_EXT_graphics_pipeline_library splits a pipeline into, a whole pipeline is all of them
+	const vk::GraphicsPipelineLibraryFlagsEXT allGraphicsPipelineParts = vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface
+		| vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders | vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader
+		| vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface;
+
+	/*
+	* Shared by whole pipelines and pipeline libraries: only the state of the parts being built is
+	* filled in. Whole pipelines pass every part and no pNext, libraries chain their
+	* GraphicsPipelineLibraryCreateInfoEXT.
+	*/
+	vk::Pipeline create_graphics_pipeline(const GraphicsPipelineInBundle& specification, vk::PipelineLayout layout, vk::RenderPass renderpass,
+		vk::GraphicsPipelineLibraryFlagsEXT parts, vk::PipelineCreateFlags flags, const void* pNext, bool debug)
+	{
+		bool vertexInputPart = bool(parts & vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface);
+		bool preRasterizationPart = bool(parts & vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders);
+		bool fragmentPart = bool(parts & vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader);
+		bool outputPart = bool(parts & vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface);
+
 		vk::GraphicsPipelineCreateInfo pipelineInfo = {};
-		pipelineInfo.flags = vk::PipelineCreateFlags();
+		pipelineInfo.flags = flags;
 
 		std::vector <vk::PipelineShaderStageCreateInfo> shaderStages;
 
 		//Vertex Input
 		vk::PipelineVertexInputStateCreateInfo vertexInputInfo = {};
 		vertexInputInfo.flags = vk::PipelineVertexInputStateCreateFlags();
-		vertexInputInfo.vertexAttributeDescriptionCount = 0;
-		vertexInputInfo.vertexBindingDescriptionCount = 0;
-		pipelineInfo.pVertexInputState = &vertexInputInfo;
+		vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(specification.bindingDescriptions.size());
+		vertexInputInfo.pVertexBindingDescriptions = specification.bindingDescriptions.data();
+		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(specification.attributeDescriptions.size());
+		vertexInputInfo.pVertexAttributeDescriptions = specification.attributeDescriptions.data();
 
 		//Input Assembly
 		vk::PipelineInputAssemblyStateCreateInfo inputAssemblyInfo = {};
 		inputAssemblyInfo.flags = vk::PipelineInputAssemblyStateCreateFlags();
-		inputAssemblyInfo.topology = vk::PrimitiveTopology::eTriangleList;
-		pipelineInfo.pInputAssemblyState = &inputAssemblyInfo;
+		inputAssemblyInfo.topology = specification.topology;
+
+		if (vertexInputPart)
+		{
+			pipelineInfo.pVertexInputState = &vertexInputInfo;
+			pipelineInfo.pInputAssemblyState = &inputAssemblyInfo;
+		}
+
+		vk::SpecializationInfo specializationInfo = {};
+		specializationInfo.mapEntryCount = static_cast<uint32_t>(specification.specializationEntries.size());
+		specializationInfo.pMapEntries = specification.specializationEntries.data();
+		specializationInfo.dataSize = specification.specializationData.size();
+		specializationInfo.pData = specification.specializationData.data();
+		const vk::SpecializationInfo* specialization = specification.specializationEntries.empty() ? nullptr : &specializationInfo;
 
 		//Vertex Shader
-		if (debug)
-			std::cout << "Create vertex shader module" << std::endl;
-
-		vk::ShaderModule vertexShader = vkUtil::createModule(specification.vertexFilepath, specification.device, debug);
-		vk::PipelineShaderStageCreateInfo vertexShaderInfo = {};
-		vertexShaderInfo.flags = vk::PipelineShaderStageCreateFlags();
-		vertexShaderInfo.stage = vk::ShaderStageFlagBits::eVertex;
-		vertexShaderInfo.module = vertexShader;
-		vertexShaderInfo.pName = "main";
-		shaderStages.push_back(vertexShaderInfo);
-
-		//Viewport and Scissor
-		vk::Viewport viewport = {};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = specification.swapchainExtent.width;
-		viewport.height = specification.swapchainExtent.height;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-		vk::Rect2D scissor = {};
-		scissor.offset.x = 0.0f;
-		scissor.offset.y = 0.0f;
-		scissor.extent = specification.swapchainExtent;
+		vk::ShaderModule vertexShader = nullptr;
+		if (preRasterizationPart)
+		{
+			if (debug)
+				std::cout << "Create vertex shader module" << std::endl;
+
+			vertexShader = vkUtil::createModule(specification.vertexFilepath, specification.device, debug, specification.shaderDefines);
+			vk::PipelineShaderStageCreateInfo vertexShaderInfo = {};
+			vertexShaderInfo.flags = vk::PipelineShaderStageCreateFlags();
+			vertexShaderInfo.stage = vk::ShaderStageFlagBits::eVertex;
+			vertexShaderInfo.module = vertexShader;
+			vertexShaderInfo.pName = "main";
+			vertexShaderInfo.pSpecializationInfo = specialization;
+			shaderStages.push_back(vertexShaderInfo);
+		}
+
+		//Viewport and Scissor, set when recording so a resize doesn't touch the pipeline
 		vk::PipelineViewportStateCreateInfo viewportState = {};
 		viewportState.flags = vk::PipelineViewportStateCreateFlags();
 		viewportState.viewportCount = 1;
-		viewportState.pViewports = &viewport;
 		viewportState.scissorCount = 1;
-		viewportState.pScissors = &scissor;
-		pipelineInfo.pViewportState = &viewportState;
+
+		//Dynamic State, each part lists the states it owns
+		std::vector<vk::DynamicState> dynamicStates;
+		if (preRasterizationPart)
+		{
+			dynamicStates.push_back(vk::DynamicState::eViewport);
+			dynamicStates.push_back(vk::DynamicState::eScissor);
+			if (specification.extendedDynamicState)
+			{
+				dynamicStates.push_back(vk::DynamicState::eCullModeEXT);
+				dynamicStates.push_back(vk::DynamicState::eFrontFaceEXT);
+			}
+		}
+		if (fragmentPart && specification.extendedDynamicState)
+		{
+			dynamicStates.push_back(vk::DynamicState::eDepthTestEnableEXT);
+			dynamicStates.push_back(vk::DynamicState::eDepthWriteEnableEXT);
+			dynamicStates.push_back(vk::DynamicState::eDepthCompareOpEXT);
+		}
+		vk::PipelineDynamicStateCreateInfo dynamicState = {};
+		dynamicState.flags = vk::PipelineDynamicStateCreateFlags();
+		dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+		dynamicState.pDynamicStates = dynamicStates.data();
+		if (!dynamicStates.empty())
+			pipelineInfo.pDynamicState = &dynamicState;
 
 		//Rasterizer
 		vk::PipelineRasterizationStateCreateInfo rasterizer = {};
 		rasterizer.flags = vk::PipelineRasterizationStateCreateFlags();
 		rasterizer.depthClampEnable = VK_FALSE;
 		rasterizer.rasterizerDiscardEnable = VK_FALSE;
-		rasterizer.polygonMode = vk::PolygonMode::eFill;
+		rasterizer.polygonMode = specification.polygonMode;
 		rasterizer.lineWidth = 1.0f;
-		rasterizer.cullMode = vk::CullModeFlagBits::eBack;
-		rasterizer.frontFace = vk::FrontFace::eClockwise;
+		rasterizer.cullMode = specification.cullMode;
+		rasterizer.frontFace = specification.frontFace;
 		rasterizer.depthBiasEnable = VK_FALSE;
-		pipelineInfo.pRasterizationState = &rasterizer;
+
+		if (preRasterizationPart)
+		{
+			pipelineInfo.pViewportState = &viewportState;
+			pipelineInfo.pRasterizationState = &rasterizer;
+		}
 
 		//Fragment Shader
-		if (debug)
-			std::cout << "Create fragment shader module" << std::endl;
-
-		vk::ShaderModule fragmentShader = vkUtil::createModule(specification.fragmentFilepath, specification.device, debug);
-		vk::PipelineShaderStageCreateInfo fragmentShaderInfo = {};
-		fragmentShaderInfo.flags = vk::PipelineShaderStageCreateFlags();
-		fragmentShaderInfo.stage = vk::ShaderStageFlagBits::eFragment;
-		fragmentShaderInfo.module = fragmentShader;
-		fragmentShaderInfo.pName = "main";
-		shaderStages.push_back(fragmentShaderInfo);
+		vk::ShaderModule fragmentShader = nullptr;
+		if (fragmentPart)
+		{
+			if (debug)
+				std::cout << "Create fragment shader module" << std::endl;
+
+			fragmentShader = vkUtil::createModule(specification.fragmentFilepath, specification.device, debug, specification.shaderDefines);
+			vk::PipelineShaderStageCreateInfo fragmentShaderInfo = {};
+			fragmentShaderInfo.flags = vk::PipelineShaderStageCreateFlags();
+			fragmentShaderInfo.stage = vk::ShaderStageFlagBits::eFragment;
+			fragmentShaderInfo.module = fragmentShader;
+			fragmentShaderInfo.pName = "main";
+			fragmentShaderInfo.pSpecializationInfo = specialization;
+			shaderStages.push_back(fragmentShaderInfo);
+		}
 		pipelineInfo.stageCount = shaderStages.size();
 		pipelineInfo.pStages = shaderStages.data();
 
+		//Depth
+		vk::PipelineDepthStencilStateCreateInfo depthState = {};
+		depthState.flags = vk::PipelineDepthStencilStateCreateFlags();
+		depthState.depthTestEnable = specification.depthTest;
+		depthState.depthWriteEnable = specification.depthWrite;
+		depthState.depthCompareOp = specification.depthCompareOp;
+		depthState.depthBoundsTestEnable = VK_FALSE;
+		depthState.stencilTestEnable = VK_FALSE;
+		if (fragmentPart)
+			pipelineInfo.pDepthStencilState = &depthState;
+
 		//Multisampling
 		vk::PipelineMultisampleStateCreateInfo multisampling = {};
 		multisampling.flags = vk::PipelineMultisampleStateCreateFlags();
 		multisampling.sampleShadingEnable = VK_FALSE;
 		multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
-		pipelineInfo.pMultisampleState = &multisampling;
+		if (fragmentPart || outputPart)
+			pipelineInfo.pMultisampleState = &multisampling;
 
 		//Color Blend
 		vk::PipelineColorBlendAttachmentState colorBlendAttachment = {};
 		colorBlendAttachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
-		colorBlendAttachment.blendEnable = VK_FALSE;
+		colorBlendAttachment.blendEnable = specification.blendEnable;
+		colorBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+		colorBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+		colorBlendAttachment.colorBlendOp = vk::BlendOp::eAdd;
+		colorBlendAttachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+		colorBlendAttachment.dstAlphaBlendFactor = vk::BlendFactor::eZero;
+		colorBlendAttachment.alphaBlendOp = vk::BlendOp::eAdd;
 		vk::PipelineColorBlendStateCreateInfo colorBlending = {};
 		colorBlending.flags = vk::PipelineColorBlendStateCreateFlags();
 		colorBlending.logicOpEnable = VK_FALSE;
@@ -174,19 +361,12 @@ namespace vkInit
 		colorBlending.blendConstants[1] = 0.0f;
 		colorBlending.blendConstants[2] = 0.0f;
 		colorBlending.blendConstants[3] = 0.0f;
-		pipelineInfo.pColorBlendState = &colorBlending;
-
-		//Pipeline Layout
-		if (debug)
-			std::cout << "Create Pipeline Layout" << std::endl;
-		vk::PipelineLayout layout = make_pipeline_layout(specification.device, debug);
-		pipelineInfo.layout = layout;
-
-		//Renderpass
-		if (debug)
-			std::cout << "Create RenderPass" << std::endl;
+		if (outputPart)
+			pipelineInfo.pColorBlendState = &colorBlending;
 
-		vk::RenderPass renderpass = make_renderpass(specification.device, specification.swapchainImageFormat, debug);
+		//The vertex input and output parts don't touch resources, so they go without a layout
+		if (preRasterizationPart || fragmentPart)
+			pipelineInfo.layout = layout;
 		pipelineInfo.renderPass = renderpass;
 
 		//Extra
@@ -196,23 +376,55 @@ namespace vkInit
 		if (debug)
 			std::cout << "Create Graphics Pipeline" << std::endl;
 
+		std::string name = pipeline_name(specification);
+		if (parts != allGraphicsPipelineParts)
+			name += " (library)";
+		vkUtil::PipelineCreationTimer timer(specification.creationLog, name);
+		std::vector<vk::ShaderStageFlagBits> stages;
+		for (const vk::PipelineShaderStageCreateInfo& stage : shaderStages)
+			stages.push_back(stage.stage);
+		pipelineInfo.pNext = timer.chain(pNext, stages);
+
 		vk::Pipeline graphicsPipeline;
 		try {
-			graphicsPipeline = (specification.device.createGraphicsPipeline(nullptr, pipelineInfo)).value;
+			graphicsPipeline = (specification.device.createGraphicsPipeline(specification.pipelineCache, pipelineInfo)).value;
 		}
 		catch (vk::SystemError err)
 		{
 			if (debug)
 				std::cout << "Failed to create Graphics Pipeline" << std::endl;
 		}
+		timer.finish(bool(graphicsPipeline));
+
+		if (vertexShader)
+			specification.device.destroyShaderModule(vertexShader);
+		if (fragmentShader)
+			specification.device.destroyShaderModule(fragmentShader);
+		return graphicsPipeline;
+	}
+
+	//Build a pipeline against a layout and render pass made elsewhere, eg. shared through the pipeline registry
+	vk::Pipeline make_graphics_pipeline(const GraphicsPipelineInBundle& specification, vk::PipelineLayout layout, vk::RenderPass renderpass, bool debug)
+	{
+		return create_graphics_pipeline(specification, layout, renderpass, allGraphicsPipelineParts, vk::PipelineCreateFlags(), nullptr, debug);
+	}
+
+	GraphicsPipelineOutBundle make_graphics_pipeline(const GraphicsPipelineInBundle& specification, bool debug)
+	{
+		//Pipeline Layout
+		if (debug)
+			std::cout << "Create Pipeline Layout" << std::endl;
+		vk::PipelineLayout layout = make_pipeline_layout(specification.device, specification.pushConstantRanges, debug);
+
+		//Renderpass
+		if (debug)
+			std::cout << "Create RenderPass" << std::endl;
+		vk::RenderPass renderpass = make_renderpass(specification.device, specification.swapchainImageFormat, specification.depthFormat, debug);
 
 		GraphicsPipelineOutBundle output = {};
 		output.layout = layout;
 		output.renderpass = renderpass;
-		output.pipeline = graphicsPipeline;
-
-		specification.device.destroyShaderModule(vertexShader);
-		specification.device.destroyShaderModule(fragmentShader);
+		output.pipeline = make_graphics_pipeline(specification, layout, renderpass, debug);
 		return output;
 	}
 }
\ No newline at end of file
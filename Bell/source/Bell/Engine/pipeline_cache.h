@@ -0,0 +1,164 @@
+#pragma once
+#include "config.h"
+#include <Core/hash.h>
+#include <Core/mapped_file.h>
+#include <filesystem>
+#include <cstring>
+
+namespace vkInit
+{
+	/*
+	* Pipeline cache file: our own header, then the blob from vkGetPipelineCacheData.
+	* Drivers are meant to reject foreign data themselves, but a truncated or stale blob
+	* has crashed enough of them that it's checked here before it is handed over.
+	*/
+	constexpr uint32_t pipelineCacheMagic = 0x43504C42; //"BLPC"
+	constexpr uint32_t pipelineCacheVersion = 1;
+
+	struct PipelineCacheFileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t dataSize;
+		uint64_t dataHash;
+		uint32_t driverVersion;
+		uint8_t driverUUID[VK_UUID_SIZE];
+	};
+
+	//Header written by the driver at the start of the cache data, as laid out by VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+	struct PipelineCacheDataHeader
+	{
+		uint32_t headerSize;
+		uint32_t headerVersion;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+	};
+
+	//The driver UUID needs Vulkan 1.1, older devices fall back to matching the driver version alone
+	PipelineCacheFileHeader make_pipeline_cache_header(vk::PhysicalDevice physicalDevice)
+	{
+		PipelineCacheFileHeader header = {};
+		header.magic = pipelineCacheMagic;
+		header.version = pipelineCacheVersion;
+
+		vk::PhysicalDeviceProperties properties = physicalDevice.getProperties();
+		header.driverVersion = properties.driverVersion;
+
+		if (properties.apiVersion >= VK_API_VERSION_1_1 && vk::enumerateInstanceVersion() >= VK_API_VERSION_1_1)
+		{
+			auto chain = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceIDProperties>();
+			const vk::PhysicalDeviceIDProperties& idProperties = chain.get<vk::PhysicalDeviceIDProperties>();
+			memcpy(header.driverUUID, idProperties.driverUUID.data(), VK_UUID_SIZE);
+		}
+
+		return header;
+	}
+
+	bool is_pipeline_cache_compatible(vk::PhysicalDevice physicalDevice, const char* data, size_t size, bool debug)
+	{
+		if (size < sizeof(PipelineCacheFileHeader) + sizeof(PipelineCacheDataHeader))
+			return false;
+
+		PipelineCacheFileHeader expected = make_pipeline_cache_header(physicalDevice);
+		PipelineCacheFileHeader header;
+		memcpy(&header, data, sizeof(header));
+		const char* blob = data + sizeof(PipelineCacheFileHeader);
+		size_t blobSize = size - sizeof(PipelineCacheFileHeader);
+
+		if (header.magic != expected.magic || header.version != expected.version || header.dataSize != blobSize
+			|| header.dataHash != vkUtil::hash_bytes(blob, blobSize))
+		{
+			if (debug)
+				std::cout << "Pipeline cache is corrupt, discarding it" << std::endl;
+			return false;
+		}
+
+		vk::PhysicalDeviceProperties properties = physicalDevice.getProperties();
+		PipelineCacheDataHeader dataHeader;
+		memcpy(&dataHeader, blob, sizeof(dataHeader));
+
+		if (header.driverVersion != expected.driverVersion || memcmp(header.driverUUID, expected.driverUUID, VK_UUID_SIZE) != 0
+			|| dataHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			|| dataHeader.vendorID != properties.vendorID || dataHeader.deviceID != properties.deviceID
+			|| memcmp(dataHeader.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) != 0)
+		{
+			if (debug)
+				std::cout << "Pipeline cache was made by another device or driver, discarding it" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	//Seeded from the file when it matches this device and driver, empty otherwise
+	vk::PipelineCache make_pipeline_cache(vk::Device device, vk::PhysicalDevice physicalDevice, const std::string& filename, bool debug)
+	{
+		vkUtil::MappedFile file(filename);
+
+		vk::PipelineCacheCreateInfo cacheInfo = {};
+		cacheInfo.flags = vk::PipelineCacheCreateFlags();
+		if (file.is_open() && is_pipeline_cache_compatible(physicalDevice, file.data(), file.size(), debug))
+		{
+			cacheInfo.initialDataSize = file.size() - sizeof(PipelineCacheFileHeader);
+			cacheInfo.pInitialData = file.data() + sizeof(PipelineCacheFileHeader);
+		}
+
+		try
+		{
+			vk::PipelineCache cache = device.createPipelineCache(cacheInfo);
+			if (debug)
+				std::cout << "Made pipeline cache, seeded with " << cacheInfo.initialDataSize << " bytes" << std::endl;
+			return cache;
+		}
+		catch (vk::SystemError err)
+		{
+			if (debug)
+				std::cout << "Failed to make pipeline cache" << std::endl;
+			return nullptr;
+		}
+	}
+}
+
+namespace vkUtil
+{
+	//Written to a temporary file and renamed into place, so a crash mid-write leaves the previous cache intact
+	bool save_pipeline_cache(vk::Device device, vk::PhysicalDevice physicalDevice, vk::PipelineCache cache, const std::string& filename, bool debug)
+	{
+		if (!cache)
+			return false;
+
+		std::vector<uint8_t> data = device.getPipelineCacheData(cache);
+
+		vkInit::PipelineCacheFileHeader header = vkInit::make_pipeline_cache_header(physicalDevice);
+		header.dataSize = data.size();
+		header.dataHash = hash_bytes(data.data(), data.size());
+
+		std::string temporaryPath = filename + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(data.data()), data.size());
+			if (!file)
+			{
+				if (debug)
+					std::cout << "Failed to write pipeline cache \"" << temporaryPath << "\"" << std::endl;
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, filename, error);
+		if (error)
+		{
+			if (debug)
+				std::cout << "Failed to move pipeline cache into place: " << error.message() << std::endl;
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+
+		if (debug)
+			std::cout << "Saved pipeline cache, " << data.size() << " bytes" << std::endl;
+		return true;
+	}
+}
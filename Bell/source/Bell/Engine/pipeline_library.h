@@ -0,0 +1,51 @@
+#pragma once
+#include "config.h"
+#include "pipeline.h"
+
+namespace vkInit
+{
+	/*
+	* VK_EXT_graphics_pipeline_library: a pipeline is split into vertex input, pre-rasterization,
+	* fragment shader and fragment output parts. Each part is compiled once as a library and
+	* shared between every pipeline that agrees on it, a pipeline is then only a link.
+	*/
+	vk::Pipeline make_pipeline_library(const GraphicsPipelineInBundle& specification, vk::PipelineLayout layout, vk::RenderPass renderpass,
+		vk::GraphicsPipelineLibraryFlagBitsEXT part, bool debug)
+	{
+		vk::GraphicsPipelineLibraryCreateInfoEXT libraryInfo = {};
+		libraryInfo.flags = part;
+
+		//Keep what an optimized link needs, see link_graphics_pipeline
+		vk::PipelineCreateFlags flags = vk::PipelineCreateFlagBits::eLibraryKHR | vk::PipelineCreateFlagBits::eRetainLinkTimeOptimizationInfoEXT;
+		return create_graphics_pipeline(specification, layout, renderpass, part, flags, &libraryInfo, debug);
+	}
+
+	//Linking without optimization takes microseconds, an optimized link costs about as much as a whole pipeline
+	vk::Pipeline link_graphics_pipeline(vk::Device device, const std::vector<vk::Pipeline>& libraries, vk::PipelineLayout layout,
+		vk::PipelineCache pipelineCache, bool optimize, vkUtil::PipelineCreationLog* creationLog, const std::string& name, bool debug)
+	{
+		vk::PipelineLibraryCreateInfoKHR libraryInfo = {};
+		libraryInfo.libraryCount = static_cast<uint32_t>(libraries.size());
+		libraryInfo.pLibraries = libraries.data();
+
+		vkUtil::PipelineCreationTimer timer(creationLog, name + (optimize ? " (optimized link)" : " (fast link)"));
+
+		vk::GraphicsPipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.pNext = timer.chain(&libraryInfo, {});
+		pipelineInfo.flags = optimize ? vk::PipelineCreateFlags(vk::PipelineCreateFlagBits::eLinkTimeOptimizationEXT) : vk::PipelineCreateFlags();
+		pipelineInfo.layout = layout;
+
+		vk::Pipeline graphicsPipeline;
+		try
+		{
+			graphicsPipeline = device.createGraphicsPipeline(pipelineCache, pipelineInfo).value;
+		}
+		catch (vk::SystemError err)
+		{
+			if (debug)
+				std::cout << "Failed to link Graphics Pipeline" << std::endl;
+		}
+		timer.finish(bool(graphicsPipeline));
+		return graphicsPipeline;
+	}
+}
@@ -0,0 +1,269 @@
+#pragma once
+#include "config.h"
+#include "pipeline.h"
+#include "compute_pipeline.h"
+#include <Core/json.h>
+#include <Core/mapped_file.h>
+#include <filesystem>
+
+namespace vkInit
+{
+	/*
+	* Every pipeline a session asked for, written at shutdown and compiled ahead of the first
+	* frame on the next launch so no pipeline is made the first time it's drawn with. Only the
+	* state is stored, device, pipeline cache and creation log are filled in by the loader's caller.
+	* Formats and supported features belong to the device, so a manifest another device or driver
+	* wrote is discarded like the pipeline cache is.
+	*/
+	constexpr uint32_t pipelineManifestVersion = 2;
+
+	struct PipelineManifestDevice
+	{
+		uint32_t vendorID{ 0 };
+		uint32_t deviceID{ 0 };
+		uint32_t driverVersion{ 0 };
+		std::vector<uint8_t> deviceUUID;
+	};
+
+	struct PipelineManifest
+	{
+		PipelineManifestDevice device;
+		std::vector<GraphicsPipelineInBundle> graphicsPipelines;
+		std::vector<ComputePipelineInBundle> computePipelines;
+	};
+
+	//The device UUID needs Vulkan 1.1, older devices are matched by IDs and driver version alone
+	PipelineManifestDevice make_pipeline_manifest_device(vk::PhysicalDevice physicalDevice)
+	{
+		PipelineManifestDevice device;
+		vk::PhysicalDeviceProperties properties = physicalDevice.getProperties();
+		device.vendorID = properties.vendorID;
+		device.deviceID = properties.deviceID;
+		device.driverVersion = properties.driverVersion;
+
+		if (properties.apiVersion >= VK_API_VERSION_1_1 && vk::enumerateInstanceVersion() >= VK_API_VERSION_1_1)
+		{
+			auto chain = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceIDProperties>();
+			const vk::PhysicalDeviceIDProperties& idProperties = chain.get<vk::PhysicalDeviceIDProperties>();
+			device.deviceUUID.assign(idProperties.deviceUUID.begin(), idProperties.deviceUUID.end());
+		}
+		return device;
+	}
+
+	bool same_manifest_device(const PipelineManifestDevice& a, const PipelineManifestDevice& b)
+	{
+		return a.vendorID == b.vendorID && a.deviceID == b.deviceID && a.driverVersion == b.driverVersion && a.deviceUUID == b.deviceUUID;
+	}
+
+	std::string json_bytes(const std::vector<uint8_t>& bytes)
+	{
+		static const char digits[] = "0123456789abcdef";
+		std::string hex;
+		for (uint8_t byte : bytes)
+		{
+			hex += digits[byte >> 4];
+			hex += digits[byte & 15];
+		}
+		return hex;
+	}
+
+	std::vector<uint8_t> parse_json_bytes(const std::string& hex)
+	{
+		std::vector<uint8_t> bytes;
+		for (size_t i = 0; i + 1 < hex.size(); i += 2)
+			bytes.push_back(static_cast<uint8_t>(std::strtoul(hex.substr(i, 2).c_str(), nullptr, 16)));
+		return bytes;
+	}
+
+	void write_shader_state(std::ostream& json, const std::vector<std::string>& defines, const std::vector<vk::SpecializationMapEntry>& entries,
+		const std::vector<uint8_t>& data, const std::vector<vk::PushConstantRange>& pushConstantRanges)
+	{
+		json << ", \"defines\": [";
+		for (size_t i = 0; i < defines.size(); i++)
+			json << (i > 0 ? ", " : "") << "\"" << vkUtil::json_escape(defines[i]) << "\"";
+		json << "], \"specialization\": [";
+		for (size_t i = 0; i < entries.size(); i++)
+			json << (i > 0 ? ", " : "") << "[" << entries[i].constantID << ", " << entries[i].offset << ", " << entries[i].size << "]";
+		json << "], \"specializationData\": \"" << json_bytes(data) << "\", \"pushConstants\": [";
+		for (size_t i = 0; i < pushConstantRanges.size(); i++)
+		{
+			const vk::PushConstantRange& range = pushConstantRanges[i];
+			json << (i > 0 ? ", " : "") << "[" << static_cast<uint32_t>(range.stageFlags) << ", " << range.offset << ", " << range.size << "]";
+		}
+		json << "]";
+	}
+
+	void read_shader_state(const vkUtil::JsonValue& value, std::vector<std::string>& defines, std::vector<vk::SpecializationMapEntry>& entries,
+		std::vector<uint8_t>& data, std::vector<vk::PushConstantRange>& pushConstantRanges)
+	{
+		for (const vkUtil::JsonValue& define : value["defines"].array)
+			defines.push_back(define.as_string());
+		for (const vkUtil::JsonValue& entry : value["specialization"].array)
+		{
+			entries.push_back(vk::SpecializationMapEntry(static_cast<uint32_t>(entry[0].as_int(0)),
+				static_cast<uint32_t>(entry[1].as_int(0)), static_cast<size_t>(entry[2].as_int(0))));
+		}
+		data = parse_json_bytes(value["specializationData"].as_string());
+		for (const vkUtil::JsonValue& range : value["pushConstants"].array)
+		{
+			pushConstantRanges.push_back(vk::PushConstantRange(vk::ShaderStageFlags(static_cast<uint32_t>(range[0].as_int(0))),
+				static_cast<uint32_t>(range[1].as_int(0)), static_cast<uint32_t>(range[2].as_int(0))));
+		}
+	}
+
+	std::string pipeline_manifest_to_json(const PipelineManifest& manifest)
+	{
+		std::stringstream json;
+		json << "{\n\t\"version\": " << pipelineManifestVersion << ",\n\t\"device\": { \"vendor\": " << manifest.device.vendorID
+			<< ", \"id\": " << manifest.device.deviceID << ", \"driverVersion\": " << manifest.device.driverVersion
+			<< ", \"uuid\": \"" << json_bytes(manifest.device.deviceUUID) << "\" },\n\t\"graphics\": [\n";
+		for (size_t i = 0; i < manifest.graphicsPipelines.size(); i++)
+		{
+			const GraphicsPipelineInBundle& pipeline = manifest.graphicsPipelines[i];
+			json << "\t\t{ \"vertex\": \"" << vkUtil::json_escape(pipeline.vertexFilepath) << "\""
+				<< ", \"fragment\": \"" << vkUtil::json_escape(pipeline.fragmentFilepath) << "\""
+				<< ", \"colorFormat\": " << static_cast<uint32_t>(pipeline.swapchainImageFormat)
+				<< ", \"depthFormat\": " << static_cast<uint32_t>(pipeline.depthFormat)
+				<< ", \"bindings\": [";
+			for (size_t j = 0; j < pipeline.bindingDescriptions.size(); j++)
+			{
+				const vk::VertexInputBindingDescription& binding = pipeline.bindingDescriptions[j];
+				json << (j > 0 ? ", " : "") << "[" << binding.binding << ", " << binding.stride << ", " << static_cast<uint32_t>(binding.inputRate) << "]";
+			}
+			json << "], \"attributes\": [";
+			for (size_t j = 0; j < pipeline.attributeDescriptions.size(); j++)
+			{
+				const vk::VertexInputAttributeDescription& attribute = pipeline.attributeDescriptions[j];
+				json << (j > 0 ? ", " : "") << "[" << attribute.location << ", " << attribute.binding << ", "
+					<< static_cast<uint32_t>(attribute.format) << ", " << attribute.offset << "]";
+			}
+			json << "], \"extendedDynamicState\": " << (pipeline.extendedDynamicState ? "true" : "false")
+				<< ", \"topology\": " << static_cast<uint32_t>(pipeline.topology)
+				<< ", \"polygonMode\": " << static_cast<uint32_t>(pipeline.polygonMode)
+				<< ", \"cullMode\": " << static_cast<uint32_t>(pipeline.cullMode)
+				<< ", \"frontFace\": " << static_cast<uint32_t>(pipeline.frontFace)
+				<< ", \"depthTest\": " << (pipeline.depthTest ? "true" : "false")
+				<< ", \"depthWrite\": " << (pipeline.depthWrite ? "true" : "false")
+				<< ", \"depthCompareOp\": " << static_cast<uint32_t>(pipeline.depthCompareOp)
+				<< ", \"blend\": " << (pipeline.blendEnable ? "true" : "false");
+			write_shader_state(json, pipeline.shaderDefines, pipeline.specializationEntries, pipeline.specializationData, pipeline.pushConstantRanges);
+			json << " }" << (i + 1 < manifest.graphicsPipelines.size() ? "," : "") << "\n";
+		}
+		json << "\t],\n\t\"compute\": [\n";
+		for (size_t i = 0; i < manifest.computePipelines.size(); i++)
+		{
+			const ComputePipelineInBundle& pipeline = manifest.computePipelines[i];
+			json << "\t\t{ \"compute\": \"" << vkUtil::json_escape(pipeline.computeFilepath) << "\"";
+			write_shader_state(json, pipeline.shaderDefines, pipeline.specializationEntries, pipeline.specializationData, pipeline.pushConstantRanges);
+			json << " }" << (i + 1 < manifest.computePipelines.size() ? "," : "") << "\n";
+		}
+		json << "\t]\n}\n";
+		return json.str();
+	}
+
+	//Empty when there's no manifest yet, or it was written by another version, device or driver
+	PipelineManifest load_pipeline_manifest(const std::string& filename, vk::PhysicalDevice physicalDevice, bool debug)
+	{
+		PipelineManifest manifest;
+		vkUtil::MappedFile file(filename);
+		if (!file.is_open())
+			return manifest;
+
+		vkUtil::JsonValue document;
+		try
+		{
+			document = vkUtil::JsonParser::parse(file.data(), file.data() + file.size());
+		}
+		catch (const std::runtime_error& err)
+		{
+			if (debug)
+				std::cout << "Pipeline manifest \"" << filename << "\" is corrupt: " << err.what() << std::endl;
+			return manifest;
+		}
+		if (document["version"].as_int() != pipelineManifestVersion)
+			return manifest;
+
+		const vkUtil::JsonValue& device = document["device"];
+		manifest.device.vendorID = static_cast<uint32_t>(device["vendor"].as_int(0));
+		manifest.device.deviceID = static_cast<uint32_t>(device["id"].as_int(0));
+		manifest.device.driverVersion = static_cast<uint32_t>(device["driverVersion"].as_int(0));
+		manifest.device.deviceUUID = parse_json_bytes(device["uuid"].as_string());
+		if (!same_manifest_device(manifest.device, make_pipeline_manifest_device(physicalDevice)))
+		{
+			if (debug)
+				std::cout << "Pipeline manifest was made by another device or driver, discarding it" << std::endl;
+			return PipelineManifest();
+		}
+
+		for (const vkUtil::JsonValue& value : document["graphics"].array)
+		{
+			GraphicsPipelineInBundle pipeline = {};
+			pipeline.vertexFilepath = value["vertex"].as_string();
+			pipeline.fragmentFilepath = value["fragment"].as_string();
+			pipeline.swapchainImageFormat = static_cast<vk::Format>(value["colorFormat"].as_int(0));
+			pipeline.depthFormat = static_cast<vk::Format>(value["depthFormat"].as_int(0));
+			for (const vkUtil::JsonValue& binding : value["bindings"].array)
+			{
+				pipeline.bindingDescriptions.push_back(vk::VertexInputBindingDescription(static_cast<uint32_t>(binding[0].as_int(0)),
+					static_cast<uint32_t>(binding[1].as_int(0)), static_cast<vk::VertexInputRate>(binding[2].as_int(0))));
+			}
+			for (const vkUtil::JsonValue& attribute : value["attributes"].array)
+			{
+				pipeline.attributeDescriptions.push_back(vk::VertexInputAttributeDescription(static_cast<uint32_t>(attribute[0].as_int(0)),
+					static_cast<uint32_t>(attribute[1].as_int(0)), static_cast<vk::Format>(attribute[2].as_int(0)), static_cast<uint32_t>(attribute[3].as_int(0))));
+			}
+			pipeline.extendedDynamicState = value["extendedDynamicState"].boolean;
+			pipeline.topology = static_cast<vk::PrimitiveTopology>(value["topology"].as_int(0));
+			pipeline.polygonMode = static_cast<vk::PolygonMode>(value["polygonMode"].as_int(0));
+			pipeline.cullMode = vk::CullModeFlags(static_cast<uint32_t>(value["cullMode"].as_int(0)));
+			pipeline.frontFace = static_cast<vk::FrontFace>(value["frontFace"].as_int(0));
+			pipeline.depthTest = value["depthTest"].boolean;
+			pipeline.depthWrite = value["depthWrite"].boolean;
+			pipeline.depthCompareOp = static_cast<vk::CompareOp>(value["depthCompareOp"].as_int(0));
+			pipeline.blendEnable = value["blend"].boolean;
+			read_shader_state(value, pipeline.shaderDefines, pipeline.specializationEntries, pipeline.specializationData, pipeline.pushConstantRanges);
+			manifest.graphicsPipelines.push_back(pipeline);
+		}
+		for (const vkUtil::JsonValue& value : document["compute"].array)
+		{
+			ComputePipelineInBundle pipeline = {};
+			pipeline.computeFilepath = value["compute"].as_string();
+			read_shader_state(value, pipeline.shaderDefines, pipeline.specializationEntries, pipeline.specializationData, pipeline.pushConstantRanges);
+			manifest.computePipelines.push_back(pipeline);
+		}
+		return manifest;
+	}
+}
+
+namespace vkUtil
+{
+	//Written to a temporary file and renamed into place, like the pipeline cache
+	bool save_pipeline_manifest(const vkInit::PipelineManifest& manifest, const std::string& filename, bool debug)
+	{
+		std::string temporaryPath = filename + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::trunc);
+			file << vkInit::pipeline_manifest_to_json(manifest);
+			if (!file)
+			{
+				if (debug)
+					std::cout << "Failed to write pipeline manifest \"" << temporaryPath << "\"" << std::endl;
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, filename, error);
+		if (error)
+		{
+			std::filesystem::remove(temporaryPath, error);
+			if (debug)
+				std::cout << "Failed to replace pipeline manifest \"" << filename << "\"" << std::endl;
+			return false;
+		}
+
+		if (debug)
+			std::cout << "Saved " << manifest.graphicsPipelines.size() + manifest.computePipelines.size() << " pipeline(s) to \"" << filename << "\"" << std::endl;
+		return true;
+	}
+}
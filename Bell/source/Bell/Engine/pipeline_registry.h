@@ -0,0 +1,1243 @@
+#pragma once
+#include "config.h"
+#include "pipeline.h"
+#include "compute_pipeline.h"
+#include "descriptors.h"
+#include "pipeline_library.h"
+#include "pipeline_manifest.h"
+#include <Core/Shaders/shader_reflection.h>
+#include <Core/hash.h>
+#include <Core/mapped_file.h>
+#include <Core/thread_pool.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <chrono>
+#include <functional>
+#include <set>
+
+namespace vkInit
+{
+	uint64_t hash_push_constant_ranges(const std::vector<vk::PushConstantRange>& ranges)
+	{
+		uint64_t hash = vkUtil::hash_value(ranges.size());
+		for (const vk::PushConstantRange& range : ranges)
+		{
+			hash = vkUtil::hash_value(static_cast<uint32_t>(range.stageFlags), hash);
+			hash = vkUtil::hash_value(range.offset, hash);
+			hash = vkUtil::hash_value(range.size, hash);
+		}
+		return hash;
+	}
+
+	uint64_t hash_descriptor_bindings(const std::vector<vk::DescriptorSetLayoutBinding>& bindings)
+	{
+		uint64_t hash = vkUtil::hash_value(bindings.size());
+		for (const vk::DescriptorSetLayoutBinding& binding : bindings)
+		{
+			hash = vkUtil::hash_value(binding.binding, hash);
+			hash = vkUtil::hash_value(static_cast<uint32_t>(binding.descriptorType), hash);
+			hash = vkUtil::hash_value(binding.descriptorCount, hash);
+			hash = vkUtil::hash_value(static_cast<uint32_t>(binding.stageFlags), hash);
+		}
+		return hash;
+	}
+
+	//Render passes are interchangeable when their attachments are, which for ours comes down to the formats
+	uint64_t hash_renderpass_compatibility(vk::Format colorFormat, vk::Format depthFormat)
+	{
+		uint64_t hash = vkUtil::hash_value(static_cast<uint32_t>(colorFormat));
+		return vkUtil::hash_value(static_cast<uint32_t>(depthFormat), hash);
+	}
+
+	//Hash the SPIR-V itself rather than the path, so a rebuilt shader makes a new pipeline. GLSL is keyed
+	//like the shader cache, by its sources, includes and defines
+	uint64_t hash_shader_file(const std::string& filename, const std::vector<std::string>& defines, uint64_t seed)
+	{
+		if (const vkUtil::EmbeddedShader* embedded = vkUtil::find_embedded_shader(filename, defines))
+			return vkUtil::hash_bytes(embedded->code, embedded->wordCount * sizeof(uint32_t), seed);
+
+		if (!vkUtil::is_spirv_file(filename))
+			return vkUtil::hash_value(vkUtil::shader_cache_key(filename, defines), seed);
+
+		vkUtil::MappedFile file(filename);
+		if (!file.is_open())
+			return vkUtil::hash_string(filename, seed);
+		return vkUtil::hash_bytes(file.data(), file.size(), seed);
+	}
+
+	/*
+	* State hashes follow the parts VK_EXT_graphics_pipeline_library splits a pipeline into, so
+	* libraries can be shared by part. Fields are hashed one by one so padding never leaks in.
+	*/
+	uint64_t hash_vertex_input_state(const GraphicsPipelineInBundle& specification)
+	{
+		uint64_t hash = vkUtil::hash_value(specification.bindingDescriptions.size());
+		for (const vk::VertexInputBindingDescription& binding : specification.bindingDescriptions)
+		{
+			hash = vkUtil::hash_value(binding.binding, hash);
+			hash = vkUtil::hash_value(binding.stride, hash);
+			hash = vkUtil::hash_value(static_cast<uint32_t>(binding.inputRate), hash);
+		}
+		hash = vkUtil::hash_value(specification.attributeDescriptions.size(), hash);
+		for (const vk::VertexInputAttributeDescription& attribute : specification.attributeDescriptions)
+		{
+			hash = vkUtil::hash_value(attribute.location, hash);
+			hash = vkUtil::hash_value(attribute.binding, hash);
+			hash = vkUtil::hash_value(static_cast<uint32_t>(attribute.format), hash);
+			hash = vkUtil::hash_value(attribute.offset, hash);
+		}
+		return vkUtil::hash_value(static_cast<uint32_t>(specification.topology), hash);
+	}
+
+	uint64_t hash_specialization(const std::vector<vk::SpecializationMapEntry>& entries, const std::vector<uint8_t>& data, uint64_t seed)
+	{
+		uint64_t hash = vkUtil::hash_value(entries.size(), seed);
+		for (const vk::SpecializationMapEntry& entry : entries)
+		{
+			hash = vkUtil::hash_value(entry.constantID, hash);
+			hash = vkUtil::hash_value(entry.offset, hash);
+			hash = vkUtil::hash_value(entry.size, hash);
+		}
+		return vkUtil::hash_bytes(data.data(), data.size(), hash);
+	}
+
+	//State that's set while recording doesn't make pipelines different
+	uint64_t hash_pre_rasterization_state(const GraphicsPipelineInBundle& specification)
+	{
+		uint64_t hash = hash_shader_file(specification.vertexFilepath, specification.shaderDefines, vkUtil::fnvOffsetBasis);
+		hash = hash_specialization(specification.specializationEntries, specification.specializationData, hash);
+		hash = vkUtil::hash_value(static_cast<uint32_t>(specification.polygonMode), hash);
+		hash = vkUtil::hash_value(specification.extendedDynamicState, hash);
+		if (!specification.extendedDynamicState)
+		{
+			hash = vkUtil::hash_value(static_cast<uint32_t>(specification.cullMode), hash);
+			hash = vkUtil::hash_value(static_cast<uint32_t>(specification.frontFace), hash);
+		}
+		return vkUtil::hash_value(hash_renderpass_compatibility(specification.swapchainImageFormat, specification.depthFormat), hash);
+	}
+
+	uint64_t hash_fragment_state(const GraphicsPipelineInBundle& specification)
+	{
+		uint64_t hash = hash_shader_file(specification.fragmentFilepath, specification.shaderDefines, vkUtil::fnvOffsetBasis);
+		hash = hash_specialization(specification.specializationEntries, specification.specializationData, hash);
+		hash = vkUtil::hash_value(specification.extendedDynamicState, hash);
+		if (!specification.extendedDynamicState)
+		{
+			hash = vkUtil::hash_value(specification.depthTest, hash);
+			hash = vkUtil::hash_value(specification.depthWrite, hash);
+			hash = vkUtil::hash_value(static_cast<uint32_t>(specification.depthCompareOp), hash);
+		}
+		return vkUtil::hash_value(hash_renderpass_compatibility(specification.swapchainImageFormat, specification.depthFormat), hash);
+	}
+
+	uint64_t hash_fragment_output_state(const GraphicsPipelineInBundle& specification)
+	{
+		uint64_t hash = vkUtil::hash_value(specification.blendEnable);
+		return vkUtil::hash_value(hash_renderpass_compatibility(specification.swapchainImageFormat, specification.depthFormat), hash);
+	}
+
+	//Every piece of state make_graphics_pipeline reads. The layout follows from the shaders and push constant ranges
+	uint64_t hash_pipeline_state(const GraphicsPipelineInBundle& specification)
+	{
+		uint64_t hash = vkUtil::hash_value(hash_vertex_input_state(specification));
+		hash = vkUtil::hash_value(hash_pre_rasterization_state(specification), hash);
+		hash = vkUtil::hash_value(hash_fragment_state(specification), hash);
+		hash = vkUtil::hash_value(hash_fragment_output_state(specification), hash);
+		return vkUtil::hash_value(hash_push_constant_ranges(specification.pushConstantRanges), hash);
+	}
+
+	//Seeded differently from graphics state, both kinds of pipeline share the registry's keys
+	uint64_t hash_compute_state(const ComputePipelineInBundle& specification)
+	{
+		uint64_t hash = hash_shader_file(specification.computeFilepath, specification.shaderDefines, vkUtil::hash_value(static_cast<uint32_t>(vk::PipelineBindPoint::eCompute)));
+		hash = hash_specialization(specification.specializationEntries, specification.specializationData, hash);
+		return vkUtil::hash_value(hash_push_constant_ranges(specification.pushConstantRanges), hash);
+	}
+
+	/*
+	* Equality to go with the state hashes, a matching hash alone could be a collision. Shaders
+	* compare by path and defines, their contents only go into the hash.
+	*/
+	bool same_vertex_input_state(const GraphicsPipelineInBundle& a, const GraphicsPipelineInBundle& b)
+	{
+		return a.bindingDescriptions == b.bindingDescriptions && a.attributeDescriptions == b.attributeDescriptions && a.topology == b.topology;
+	}
+
+	bool same_pre_rasterization_state(const GraphicsPipelineInBundle& a, const GraphicsPipelineInBundle& b)
+	{
+		return a.vertexFilepath == b.vertexFilepath && a.shaderDefines == b.shaderDefines
+			&& a.specializationEntries == b.specializationEntries && a.specializationData == b.specializationData
+			&& a.polygonMode == b.polygonMode && a.extendedDynamicState == b.extendedDynamicState
+			&& (a.extendedDynamicState || (a.cullMode == b.cullMode && a.frontFace == b.frontFace))
+			&& a.swapchainImageFormat == b.swapchainImageFormat && a.depthFormat == b.depthFormat;
+	}
+
+	bool same_fragment_state(const GraphicsPipelineInBundle& a, const GraphicsPipelineInBundle& b)
+	{
+		return a.fragmentFilepath == b.fragmentFilepath && a.shaderDefines == b.shaderDefines
+			&& a.specializationEntries == b.specializationEntries && a.specializationData == b.specializationData
+			&& a.extendedDynamicState == b.extendedDynamicState
+			&& (a.extendedDynamicState || (a.depthTest == b.depthTest && a.depthWrite == b.depthWrite && a.depthCompareOp == b.depthCompareOp))
+			&& a.swapchainImageFormat == b.swapchainImageFormat && a.depthFormat == b.depthFormat;
+	}
+
+	bool same_fragment_output_state(const GraphicsPipelineInBundle& a, const GraphicsPipelineInBundle& b)
+	{
+		return a.blendEnable == b.blendEnable && a.swapchainImageFormat == b.swapchainImageFormat && a.depthFormat == b.depthFormat;
+	}
+
+	bool same_pipeline_state(const GraphicsPipelineInBundle& a, const GraphicsPipelineInBundle& b)
+	{
+		return same_vertex_input_state(a, b) && same_pre_rasterization_state(a, b) && same_fragment_state(a, b)
+			&& same_fragment_output_state(a, b) && a.pushConstantRanges == b.pushConstantRanges;
+	}
+
+	bool same_compute_state(const ComputePipelineInBundle& a, const ComputePipelineInBundle& b)
+	{
+		return a.computeFilepath == b.computeFilepath && a.shaderDefines == b.shaderDefines
+			&& a.specializationEntries == b.specializationEntries && a.specializationData == b.specializationData
+			&& a.pushConstantRanges == b.pushConstantRanges;
+	}
+
+	uint64_t hash_library_state(vk::GraphicsPipelineLibraryFlagBitsEXT part, const GraphicsPipelineInBundle& specification)
+	{
+		switch (part)
+		{
+		case vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface:
+			return hash_vertex_input_state(specification);
+		case vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders:
+			return hash_pre_rasterization_state(specification);
+		case vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader:
+			return hash_fragment_state(specification);
+		default:
+			return hash_fragment_output_state(specification);
+		}
+	}
+
+	bool same_library_state(vk::GraphicsPipelineLibraryFlagBitsEXT part, const GraphicsPipelineInBundle& a, const GraphicsPipelineInBundle& b)
+	{
+		switch (part)
+		{
+		case vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface:
+			return same_vertex_input_state(a, b);
+		case vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders:
+			return same_pre_rasterization_state(a, b);
+		case vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader:
+			return same_fragment_state(a, b);
+		default:
+			return same_fragment_output_state(a, b);
+		}
+	}
+
+	/*
+	* Owns every pipeline, pipeline layout and render pass the engine makes. Requests are
+	* hashed, and a request matching an earlier one gets the existing handles back, so
+	* identical state is compiled once and layouts and render passes are shared. What a
+	* key was made from is kept beside it and compared on every hit. A key taken by other
+	* inputs is a collision, which moves on to the next key rather than sharing the object.
+	*/
+	class PipelineRegistry
+	{
+	public:
+
+		//Pipelines replaced by a reload are handed to deferDestroy, a frame in flight may still use them
+		PipelineRegistry(vk::Device device, std::function<void(std::function<void()>&&)> deferDestroy, bool debug) :
+			device(device), deferDestroy(std::move(deferDestroy)), debug(debug) {}
+
+		~PipelineRegistry()
+		{
+			//Compilations still running hold the device, let them land so they are destroyed with the rest
+			for (auto& entry : pending)
+			{
+				vk::Pipeline pipeline = entry.second.pipeline.get();
+				if (pipeline && pipelines.count(entry.first))
+					device.destroyPipeline(pipeline);
+				else if (pipeline)
+					pipelines[entry.first] = pipeline;
+			}
+
+			for (auto& entry : pipelines)
+				device.destroyPipeline(entry.second);
+			for (auto& entry : libraries)
+			{
+				if (entry.second.building.valid())
+					entry.second.library = entry.second.building.get();
+				device.destroyPipeline(entry.second.library);
+			}
+			for (auto& entry : layouts)
+				device.destroyPipelineLayout(entry.second.layout);
+			for (auto& entry : setLayouts)
+				device.destroyDescriptorSetLayout(entry.second.setLayout);
+			for (auto& entry : renderpasses)
+				device.destroyRenderPass(entry.second.renderpass);
+
+			if (debug)
+			{
+				std::cout << "Pipeline registry: " << pipelines.size() << " pipeline(s), " << layouts.size() << " layout(s), " << setLayouts.size() << " descriptor set layout(s), "
+					<< renderpasses.size() << " render pass(es), " << hits << " request(s) served from the registry" << std::endl;
+				if (useLibraries)
+					std::cout << "Pipeline libraries: " << libraries.size() << " part(s), " << fastLinks << " fast link(s)" << std::endl;
+			}
+		}
+
+		//New pipelines are linked from shared library parts from now on, see fast_link
+		void enable_pipeline_libraries()
+		{
+			useLibraries = true;
+		}
+
+		PipelineRegistry(const PipelineRegistry&) = delete;
+		PipelineRegistry& operator=(const PipelineRegistry&) = delete;
+
+		vk::DescriptorSetLayout get_descriptor_set_layout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings)
+		{
+			uint64_t key = free_or_matching_key(setLayouts, hash_descriptor_bindings(bindings),
+				[&](const SetLayoutEntry& entry) { return entry.bindings == bindings; });
+			auto found = setLayouts.find(key);
+			if (found != setLayouts.end())
+				return found->second.setLayout;
+
+			vk::DescriptorSetLayout setLayout = make_descriptor_set_layout(device, bindings, debug);
+			setLayouts[key] = { bindings, setLayout };
+			return setLayout;
+		}
+
+		//Set layouts are shared, so their handles identify them
+		vk::PipelineLayout get_layout(const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, const std::vector<vk::PushConstantRange>& pushConstantRanges)
+		{
+			uint64_t key = hash_push_constant_ranges(pushConstantRanges);
+			for (vk::DescriptorSetLayout setLayout : descriptorSetLayouts)
+				key = vkUtil::hash_value(static_cast<VkDescriptorSetLayout>(setLayout), key);
+			key = free_or_matching_key(layouts, key, [&](const LayoutEntry& entry)
+				{
+					return entry.setLayouts == descriptorSetLayouts && entry.pushConstantRanges == pushConstantRanges;
+				});
+			auto found = layouts.find(key);
+			if (found != layouts.end())
+				return found->second.layout;
+
+			vk::PipelineLayout layout = make_pipeline_layout(device, descriptorSetLayouts, pushConstantRanges, debug);
+			layouts[key] = { descriptorSetLayouts, pushConstantRanges, layout };
+			layoutSets[static_cast<VkPipelineLayout>(layout)] = descriptorSetLayouts;
+			return layout;
+		}
+
+		vk::PipelineLayout get_layout(const std::vector<vk::PushConstantRange>& pushConstantRanges)
+		{
+			return get_layout(std::vector<vk::DescriptorSetLayout>(), pushConstantRanges);
+		}
+
+		/*
+		* The layout a pipeline's shaders ask for: a descriptor set layout per set from the bindings
+		* some stage uses, and one push constant range covering every stage's block. Bindings no
+		* stage touches are left out and reported so they can be removed from the shader as well.
+		* Push constant ranges in the specification only count when the shaders declare none.
+		*/
+		vk::PipelineLayout get_layout(const GraphicsPipelineInBundle& specification)
+		{
+			vkUtil::ShaderReflection reflection = vkUtil::merge_reflections({
+				reflect(specification.vertexFilepath, specification.shaderDefines, vk::ShaderStageFlagBits::eVertex),
+				reflect(specification.fragmentFilepath, specification.shaderDefines, vk::ShaderStageFlagBits::eFragment) }, debug);
+			return get_layout(reflection, specification.pushConstantRanges,
+				"\"" + specification.vertexFilepath + "\" or \"" + specification.fragmentFilepath + "\"");
+		}
+
+		vk::PipelineLayout get_layout(const ComputePipelineInBundle& specification)
+		{
+			return get_layout(reflect(specification.computeFilepath, specification.shaderDefines, vk::ShaderStageFlagBits::eCompute),
+				specification.pushConstantRanges, "\"" + specification.computeFilepath + "\"");
+		}
+
+		vk::PipelineLayout get_layout(const vkUtil::ShaderReflection& reflection, const std::vector<vk::PushConstantRange>& specifiedRanges, const std::string& shaderNames)
+		{
+			std::vector<std::vector<vk::DescriptorSetLayoutBinding>> sets;
+			std::vector<const vkUtil::ShaderBinding*> unused;
+			for (const vkUtil::ShaderBinding& binding : reflection.bindings)
+			{
+				if (!binding.used)
+				{
+					unused.push_back(&binding);
+					continue;
+				}
+				if (binding.set >= sets.size())
+					sets.resize(binding.set + 1);
+				sets[binding.set].push_back(vk::DescriptorSetLayoutBinding(binding.binding, binding.type, binding.count, binding.stages));
+			}
+
+			//Sets below the highest one used still need a layout, an empty one will do
+			std::vector<vk::DescriptorSetLayout> descriptorSetLayouts;
+			for (const std::vector<vk::DescriptorSetLayoutBinding>& set : sets)
+				descriptorSetLayouts.push_back(get_descriptor_set_layout(set));
+
+			const std::vector<vk::PushConstantRange>& pushConstantRanges = reflection.pushConstantRanges.empty() ?
+				specifiedRanges : reflection.pushConstantRanges;
+
+			size_t layoutCount = layouts.size();
+			vk::PipelineLayout layout = get_layout(descriptorSetLayouts, pushConstantRanges);
+			if (debug && layouts.size() > layoutCount)
+			{
+				for (const vkUtil::ShaderBinding* binding : unused)
+				{
+					std::cout << "\"" << binding->name << "\" (set " << binding->set << ", binding " << binding->binding
+						<< ") is never used by " << shaderNames << ", leaving it out of the layout" << std::endl;
+				}
+			}
+			return layout;
+		}
+
+		//Descriptor set layouts of a layout made here, to allocate sets against. Empty for a layout made elsewhere
+		const std::vector<vk::DescriptorSetLayout>& descriptor_set_layouts(vk::PipelineLayout layout) const
+		{
+			static const std::vector<vk::DescriptorSetLayout> none;
+			auto found = layoutSets.find(static_cast<VkPipelineLayout>(layout));
+			return found != layoutSets.end() ? found->second : none;
+		}
+
+		/*
+		* Reflected once per build of a shader, an edited shader hashes differently and is reflected
+		* again. A shader nothing has reflected yet is compiled here, on the calling thread. The
+		* background paths reflect on a worker first instead, see reflect_in_background.
+		*/
+		const vkUtil::ShaderReflection& reflect(const std::string& filename, const std::vector<std::string>& defines, vk::ShaderStageFlagBits stage)
+		{
+			ShaderSource source = shader_source(filename, defines, stage);
+			if (const vkUtil::ShaderReflection* found = find_reflection(source))
+				return *found;
+			return store_reflection(source, vkUtil::reflect_shader(vkUtil::load_spirv(filename, defines, debug), stage, debug));
+		}
+
+		vk::RenderPass get_renderpass(vk::Format colorFormat, vk::Format depthFormat, RenderPassStage stage = RenderPassStage::eWhole)
+		{
+			uint64_t key = vkUtil::hash_value(static_cast<uint32_t>(stage), hash_renderpass_compatibility(colorFormat, depthFormat));
+			key = free_or_matching_key(renderpasses, key, [&](const RenderPassEntry& entry)
+				{
+					return entry.colorFormat == colorFormat && entry.depthFormat == depthFormat && entry.stage == stage;
+				});
+			auto found = renderpasses.find(key);
+			if (found != renderpasses.end())
+				return found->second.renderpass;
+
+			vk::RenderPass renderpass = make_renderpass(device, colorFormat, depthFormat, debug, stage);
+			renderpasses[key] = { colorFormat, depthFormat, stage, renderpass };
+			return renderpass;
+		}
+
+		//Compile on the calling thread, for pipelines the very first frame needs. Returns the registry key
+		uint64_t get_graphics_pipeline(const GraphicsPipelineInBundle& specification)
+		{
+			uint64_t key = graphics_key(specification);
+			requested.insert(key);
+			if (pipelines.count(key) || land(key))
+			{
+				hits++;
+				return key;
+			}
+
+			vk::PipelineLayout layout = get_layout(specification);
+			vk::RenderPass renderpass = get_renderpass(specification.swapchainImageFormat, specification.depthFormat);
+			vk::Pipeline pipeline = make_graphics_pipeline(complete_vertex_input(specification), layout, renderpass, debug);
+			if (pipeline)
+			{
+				pipelines[key] = pipeline;
+				pipelineLayouts[key] = layout;
+				specifications[key] = specification;
+			}
+			return key;
+		}
+
+		/*
+		* Queue a pipeline for compilation on a worker thread and return its key straight away.
+		* Until it is ready, find() answers with the fallback pipeline, if one is given, or null
+		* so the caller can skip the draw. Shaders not reflected yet are compiled and reflected on
+		* a worker too, as are library parts nothing has built yet. The layout and render pass are
+		* made once they are, they're cheap.
+		*/
+		uint64_t request_graphics_pipeline(const GraphicsPipelineInBundle& specification, uint64_t fallbackKey = 0)
+		{
+			uint64_t key = graphics_key(specification);
+			requested.insert(key);
+			if (fallbackKey != 0 && fallbackKey != key)
+				fallbacks[key] = fallbackKey;
+
+			if (pipelines.count(key) || in_flight(key))
+			{
+				hits++;
+				return key;
+			}
+
+			specifications[key] = specification;
+			compile_in_background(key, specification, true);
+			return key;
+		}
+
+		//Compute pipelines are a single stage and quick to make, so they're made on the calling thread
+		uint64_t get_compute_pipeline(const ComputePipelineInBundle& specification)
+		{
+			uint64_t key = compute_key(specification);
+			requested.insert(key);
+			if (pipelines.count(key) || land(key))
+			{
+				hits++;
+				return key;
+			}
+
+			vk::PipelineLayout layout = get_layout(specification);
+			vk::Pipeline pipeline = make_compute_pipeline(specification, layout, debug);
+			if (pipeline)
+			{
+				pipelines[key] = pipeline;
+				pipelineLayouts[key] = layout;
+				computeSpecifications[key] = specification;
+			}
+			return key;
+		}
+
+		//local_size of a compute shader, for sizing dispatches
+		glm::uvec3 workgroup_size(const ComputePipelineInBundle& specification)
+		{
+			return reflect(specification.computeFilepath, specification.shaderDefines, vk::ShaderStageFlagBits::eCompute).workgroupSize;
+		}
+
+		//The pipeline for a key, its fallback while it is still compiling, or null
+		vk::Pipeline find(uint64_t key) const
+		{
+			auto found = pipelines.find(key);
+			if (found != pipelines.end())
+				return found->second;
+
+			auto fallback = fallbacks.find(key);
+			if (fallback != fallbacks.end())
+			{
+				found = pipelines.find(fallback->second);
+				if (found != pipelines.end())
+					return found->second;
+			}
+			return nullptr;
+		}
+
+		//The layout find(key)'s pipeline was made with, so callers push and bind against the pipeline
+		//actually in use. A reload can change it
+		vk::PipelineLayout find_layout(uint64_t key) const
+		{
+			auto found = pipelineLayouts.find(key);
+			if (found != pipelineLayouts.end() && pipelines.count(key))
+				return found->second;
+
+			auto fallback = fallbacks.find(key);
+			if (fallback != fallbacks.end())
+			{
+				found = pipelineLayouts.find(fallback->second);
+				if (found != pipelineLayouts.end() && pipelines.count(fallback->second))
+					return found->second;
+			}
+			return nullptr;
+		}
+
+		/*
+		* Move finished compilations into the registry without waiting on the rest. Called once
+		* per frame before recording, so a pipeline switches over at a frame boundary. Shaders
+		* reflected since the last poll get their pipelines queued, and pipelines whose library
+		* parts have all been built are fast linked. Returns how many pipelines landed.
+		*/
+		size_t poll()
+		{
+			for (auto& entry : libraries)
+			{
+				if (entry.second.building.valid() && entry.second.building.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+					entry.second.library = entry.second.building.get();
+			}
+
+			std::vector<uint64_t> linkable;
+			for (const auto& entry : linking)
+			{
+				if (parts_built(entry.second))
+					linkable.push_back(entry.first);
+			}
+
+			std::vector<std::pair<uint64_t, bool>> reflected;
+			for (auto it = reflecting.begin(); it != reflecting.end();)
+			{
+				if (it->second.reflections.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				{
+					++it;
+					continue;
+				}
+
+				store_reflections(it->second);
+				reflected.emplace_back(it->first, it->second.fastLink);
+				it = reflecting.erase(it);
+			}
+
+			size_t landed = 0;
+			std::vector<uint64_t> finished;
+			for (auto it = pending.begin(); it != pending.end();)
+			{
+				if (it->second.pipeline.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				{
+					++it;
+					continue;
+				}
+
+				if (land_pipeline(it->first, it->second.pipeline.get(), it->second.layout))
+					landed++;
+				finished.push_back(it->first);
+				it = pending.erase(it);
+			}
+
+			//Queued after the loops, inserting into pending while walking it could rehash it. A pipeline
+			//compiled from reflected shaders starts from the current sources, so it's never dirty
+			for (const std::pair<uint64_t, bool>& entry : reflected)
+			{
+				dirty.erase(entry.first);
+				compile_registered(entry.first, entry.second);
+			}
+			for (uint64_t key : finished)
+				rebuild_if_dirty(key);
+			for (uint64_t key : linkable)
+			{
+				if (finish_link(key))
+					landed++;
+				else
+					compile_registered(key, false);
+			}
+			return landed;
+		}
+
+		//Wait for every compilation still running, eg. a prewarm before the first frame. A finished
+		//reflection or library part queues more work, so this waits until none is left
+		size_t finish_pending()
+		{
+			size_t landed = 0;
+			while (!pending.empty() || !reflecting.empty() || !linking.empty())
+			{
+				for (auto& entry : reflecting)
+					entry.second.reflections.wait();
+				for (auto& entry : pending)
+					entry.second.pipeline.wait();
+				for (auto& entry : libraries)
+				{
+					if (entry.second.building.valid())
+						entry.second.building.wait();
+				}
+				landed += poll();
+			}
+			return landed;
+		}
+
+		//Every pipeline asked for so far, to prewarm the next session with. Prewarmed pipelines nobody
+		//asked for are left out, so the manifest doesn't collect stale state from run to run
+		PipelineManifest manifest() const
+		{
+			PipelineManifest manifest;
+			for (const auto& entry : specifications)
+			{
+				if (requested.count(entry.first))
+					manifest.graphicsPipelines.push_back(entry.second);
+			}
+			for (const auto& entry : computeSpecifications)
+			{
+				if (requested.count(entry.first))
+					manifest.computePipelines.push_back(entry.second);
+			}
+			return manifest;
+		}
+
+		/*
+		* Queue every pipeline in a manifest on the workers. They're whole, optimized pipelines
+		* rather than library links. Asking for one afterwards waits for it rather than building
+		* it again. Returns how many were queued.
+		*/
+		size_t prewarm(const PipelineManifest& manifest)
+		{
+			size_t queued = 0;
+			for (const GraphicsPipelineInBundle& specification : manifest.graphicsPipelines)
+			{
+				uint64_t key = graphics_key(specification);
+				if (pipelines.count(key) || in_flight(key))
+					continue;
+				specifications[key] = specification;
+				compile_in_background(key, specification);
+				queued++;
+			}
+			for (const ComputePipelineInBundle& specification : manifest.computePipelines)
+			{
+				uint64_t key = compute_key(specification);
+				if (pipelines.count(key) || in_flight(key))
+					continue;
+				computeSpecifications[key] = specification;
+				compile_compute_in_background(key, specification);
+				queued++;
+			}
+
+			if (debug && queued > 0)
+				std::cout << "Prewarming " << queued << " pipeline(s)" << std::endl;
+			return queued;
+		}
+
+		/*
+		* Rebuild, in the background, every pipeline built from one of the changed files. Keys don't
+		* change, poll() swaps the new pipeline in under the old key once it compiles. A pipeline
+		* still compiling from before the change is marked dirty and built again once it lands,
+		* so the last save is always the one that ends up in use.
+		*/
+		size_t reload(const std::vector<std::string>& changedFiles)
+		{
+			std::set<std::string> changed(changedFiles.begin(), changedFiles.end());
+			size_t rebuilding = 0;
+			for (auto& entry : specifications)
+			{
+				bool affected = false;
+				for (const std::string& stage : { entry.second.vertexFilepath, entry.second.fragmentFilepath })
+				{
+					for (const std::string& file : vkUtil::shader_source_files(stage))
+						affected = affected || changed.count(file) > 0;
+				}
+				if (!affected)
+					continue;
+
+				if (in_flight(entry.first))
+					dirty.insert(entry.first);
+				else
+					compile_in_background(entry.first, entry.second);
+				rebuilding++;
+			}
+			for (auto& entry : computeSpecifications)
+			{
+				bool affected = false;
+				for (const std::string& file : vkUtil::shader_source_files(entry.second.computeFilepath))
+					affected = affected || changed.count(file) > 0;
+				if (!affected)
+					continue;
+
+				if (in_flight(entry.first))
+					dirty.insert(entry.first);
+				else
+					compile_compute_in_background(entry.first, entry.second);
+				rebuilding++;
+			}
+
+			if (debug && rebuilding > 0)
+				std::cout << "Rebuilding " << rebuilding << " pipeline(s) after a shader change" << std::endl;
+			return rebuilding;
+		}
+
+		//Every shader source the registered pipelines are built from, includes too
+		std::set<std::string> source_files() const
+		{
+			std::set<std::string> files;
+			for (const auto& entry : specifications)
+			{
+				for (const std::string& stage : { entry.second.vertexFilepath, entry.second.fragmentFilepath })
+				{
+					for (const std::string& file : vkUtil::shader_source_files(stage))
+						files.insert(file);
+				}
+			}
+			for (const auto& entry : computeSpecifications)
+			{
+				for (const std::string& file : vkUtil::shader_source_files(entry.second.computeFilepath))
+					files.insert(file);
+			}
+			return files;
+		}
+
+		size_t pending_count() const
+		{
+			return pending.size() + reflecting.size() + linking.size();
+		}
+
+		size_t pipeline_count() const
+		{
+			return pipelines.size();
+		}
+
+	private:
+
+		//What each key was made from, compared on lookup, see free_or_matching_key
+		struct SetLayoutEntry
+		{
+			std::vector<vk::DescriptorSetLayoutBinding> bindings;
+			vk::DescriptorSetLayout setLayout;
+		};
+
+		struct LayoutEntry
+		{
+			std::vector<vk::DescriptorSetLayout> setLayouts;
+			std::vector<vk::PushConstantRange> pushConstantRanges;
+			vk::PipelineLayout layout;
+		};
+
+		//One stage of one build of a shader, contentHash is hash_shader_file's
+		struct ShaderSource
+		{
+			std::string filename;
+			std::vector<std::string> defines;
+			vk::ShaderStageFlagBits stage;
+			uint64_t contentHash;
+		};
+
+		struct ReflectionEntry
+		{
+			ShaderSource source;
+			vkUtil::ShaderReflection reflection;
+		};
+
+		struct RenderPassEntry
+		{
+			vk::Format colorFormat;
+			vk::Format depthFormat;
+			RenderPassStage stage;
+			vk::RenderPass renderpass;
+		};
+
+		//library is null while the part is still building on a worker
+		struct LibraryEntry
+		{
+			vk::GraphicsPipelineLibraryFlagBitsEXT part;
+			vk::PipelineLayout layout;
+			GraphicsPipelineInBundle specification;
+			vk::Pipeline library;
+			std::future<vk::Pipeline> building;
+		};
+
+		//A fast link waiting for its library parts, keys into libraries. A part missing from it failed to build
+		struct PendingLink
+		{
+			GraphicsPipelineInBundle specification;
+			vk::PipelineLayout layout;
+			std::vector<uint64_t> parts;
+		};
+
+		//A compilation running on a worker and the layout it was made against
+		struct PendingPipeline
+		{
+			std::future<vk::Pipeline> pipeline;
+			vk::PipelineLayout layout;
+		};
+
+		//Shaders compiled and reflected ahead of their pipeline, see reflect_in_background
+		struct PendingReflection
+		{
+			std::future<std::vector<vkUtil::ShaderReflection>> reflections;
+			std::vector<ShaderSource> sources;
+			bool fastLink;
+		};
+
+		//The hash, or the key after it when the hash already belongs to something else
+		template<typename Map, typename Same>
+		static uint64_t free_or_matching_key(const Map& map, uint64_t key, Same same)
+		{
+			for (auto found = map.find(key); found != map.end() && !same(found->second); found = map.find(key))
+				key = vkUtil::hash_value(key);
+			return key;
+		}
+
+		//Graphics and compute pipelines share keys, a key either kind holds is taken for the other
+		uint64_t graphics_key(const GraphicsPipelineInBundle& specification) const
+		{
+			uint64_t key = hash_pipeline_state(specification);
+			while (computeSpecifications.count(key) || (specifications.count(key) && !same_pipeline_state(specifications.at(key), specification)))
+				key = vkUtil::hash_value(key);
+			return key;
+		}
+
+		uint64_t compute_key(const ComputePipelineInBundle& specification) const
+		{
+			uint64_t key = hash_compute_state(specification);
+			while (specifications.count(key) || (computeSpecifications.count(key) && !same_compute_state(computeSpecifications.at(key), specification)))
+				key = vkUtil::hash_value(key);
+			return key;
+		}
+
+		bool in_flight(uint64_t key) const
+		{
+			return pending.count(key) || reflecting.count(key) || linking.count(key);
+		}
+
+		/*
+		* Wait for a compilation of key that's already running, true when it produced a pipeline.
+		* A key still being reflected has no pipeline yet, the reflections are kept and the caller
+		* compiles it. A key waiting for library parts waits for them and is linked.
+		*/
+		bool land(uint64_t key)
+		{
+			auto link = linking.find(key);
+			if (link != linking.end())
+			{
+				for (uint64_t part : link->second.parts)
+				{
+					auto library = libraries.find(part);
+					if (library != libraries.end() && library->second.building.valid())
+						library->second.library = library->second.building.get();
+				}
+				return finish_link(key);
+			}
+
+			auto reflection = reflecting.find(key);
+			if (reflection != reflecting.end())
+			{
+				store_reflections(reflection->second);
+				reflecting.erase(reflection);
+				dirty.erase(key);
+				return false;
+			}
+
+			auto found = pending.find(key);
+			if (found == pending.end())
+				return false;
+
+			vk::Pipeline pipeline = found->second.pipeline.get();
+			vk::PipelineLayout layout = found->second.layout;
+			pending.erase(found);
+			bool landed = land_pipeline(key, pipeline, layout);
+			rebuild_if_dirty(key);
+			return landed;
+		}
+
+		//A finished compilation of key, replacing the pipeline it was rebuilt from if there is one
+		bool land_pipeline(uint64_t key, vk::Pipeline pipeline, vk::PipelineLayout layout)
+		{
+			auto previous = pipelines.find(key);
+			if (!pipeline)
+			{
+				if (debug && previous != pipelines.end())
+					std::cout << "Pipeline rebuild failed, keeping the previous one" << std::endl;
+				return false;
+			}
+
+			if (previous != pipelines.end())
+			{
+				//A reload, the pipeline it replaces may still be used by the frame in flight
+				vk::Device owner = device;
+				vk::Pipeline retired = previous->second;
+				deferDestroy([owner, retired]() { owner.destroyPipeline(retired); });
+				previous->second = pipeline;
+			}
+			else
+				pipelines[key] = pipeline;
+			pipelineLayouts[key] = layout;
+			fallbacks.erase(key);
+			return true;
+		}
+
+		//A reload arrived while key was compiling, what just landed was built from the old sources
+		void rebuild_if_dirty(uint64_t key)
+		{
+			if (dirty.erase(key))
+				compile_registered(key, false);
+		}
+
+		//Compile a pipeline the registry holds the specification of, whichever kind it is
+		void compile_registered(uint64_t key, bool fastLink)
+		{
+			auto graphics = specifications.find(key);
+			if (graphics != specifications.end())
+				compile_in_background(key, graphics->second, fastLink);
+			auto compute = computeSpecifications.find(key);
+			if (compute != computeSpecifications.end())
+				compile_compute_in_background(key, compute->second);
+		}
+
+		//With fastLink, and pipeline libraries enabled, a fast linked pipeline is used until the optimized one lands
+		void compile_in_background(uint64_t key, const GraphicsPipelineInBundle& specification, bool fastLink = false)
+		{
+			if (reflect_in_background(key, shader_sources(specification), fastLink))
+				return;
+			if (fastLink && useLibraries && fast_link(key, specification))
+				return;
+
+			vk::PipelineLayout layout = get_layout(specification);
+			vk::RenderPass renderpass = get_renderpass(specification.swapchainImageFormat, specification.depthFormat);
+			GraphicsPipelineInBundle completed = complete_vertex_input(specification);
+
+			bool debugMessages = debug;
+			pending[key] = { workers.submit([completed, layout, renderpass, debugMessages]()
+				{
+					return make_graphics_pipeline(completed, layout, renderpass, debugMessages);
+				}), layout };
+		}
+
+		void compile_compute_in_background(uint64_t key, const ComputePipelineInBundle& specification)
+		{
+			if (reflect_in_background(key, shader_sources(specification), false))
+				return;
+
+			vk::PipelineLayout layout = get_layout(specification);
+			bool debugMessages = debug;
+			pending[key] = { workers.submit([specification, layout, debugMessages]()
+				{
+					return make_compute_pipeline(specification, layout, debugMessages);
+				}), layout };
+		}
+
+		ShaderSource shader_source(const std::string& filename, const std::vector<std::string>& defines, vk::ShaderStageFlagBits stage) const
+		{
+			return { filename, defines, stage, hash_shader_file(filename, defines, vkUtil::fnvOffsetBasis) };
+		}
+
+		std::vector<ShaderSource> shader_sources(const GraphicsPipelineInBundle& specification) const
+		{
+			return {
+				shader_source(specification.vertexFilepath, specification.shaderDefines, vk::ShaderStageFlagBits::eVertex),
+				shader_source(specification.fragmentFilepath, specification.shaderDefines, vk::ShaderStageFlagBits::eFragment) };
+		}
+
+		std::vector<ShaderSource> shader_sources(const ComputePipelineInBundle& specification) const
+		{
+			return { shader_source(specification.computeFilepath, specification.shaderDefines, vk::ShaderStageFlagBits::eCompute) };
+		}
+
+		uint64_t reflection_key(const ShaderSource& source) const
+		{
+			return free_or_matching_key(reflections, vkUtil::hash_value(static_cast<uint32_t>(source.stage), source.contentHash),
+				[&](const ReflectionEntry& entry)
+				{
+					return entry.source.contentHash == source.contentHash && entry.source.stage == source.stage
+						&& entry.source.filename == source.filename && entry.source.defines == source.defines;
+				});
+		}
+
+		const vkUtil::ShaderReflection* find_reflection(const ShaderSource& source) const
+		{
+			auto found = reflections.find(reflection_key(source));
+			return found == reflections.end() ? nullptr : &found->second.reflection;
+		}
+
+		const vkUtil::ShaderReflection& store_reflection(const ShaderSource& source, const vkUtil::ShaderReflection& reflection)
+		{
+			return (reflections[reflection_key(source)] = { source, reflection }).reflection;
+		}
+
+		void store_reflections(PendingReflection& job)
+		{
+			std::vector<vkUtil::ShaderReflection> results = job.reflections.get();
+			for (size_t i = 0; i < results.size() && i < job.sources.size(); i++)
+				store_reflection(job.sources[i], results[i]);
+		}
+
+		/*
+		* Layouts come from reflection, and reflecting a shader means compiling it. Shaders of key
+		* that haven't been reflected are compiled and reflected on a worker, and poll() queues the
+		* pipeline itself once they are. False when every shader is reflected already.
+		*/
+		bool reflect_in_background(uint64_t key, const std::vector<ShaderSource>& sources, bool fastLink)
+		{
+			std::vector<ShaderSource> missing;
+			for (const ShaderSource& source : sources)
+			{
+				if (!find_reflection(source))
+					missing.push_back(source);
+			}
+			if (missing.empty())
+				return false;
+
+			bool debugMessages = debug;
+			PendingReflection& job = reflecting[key];
+			job.sources = missing;
+			job.fastLink = fastLink;
+			job.reflections = workers.submit([missing, debugMessages]()
+				{
+					std::vector<vkUtil::ShaderReflection> results;
+					for (const ShaderSource& source : missing)
+						results.push_back(vkUtil::reflect_shader(vkUtil::load_spirv(source.filename, source.defines, debugMessages), source.stage, debugMessages));
+					return results;
+				});
+			return true;
+		}
+
+		/*
+		* A pipeline usable soon: its four parts come from the library cache and are linked without
+		* optimization. Parts nothing has built yet are built on the workers, the fallback is used
+		* until poll() links them. The optimized link runs on a worker and replaces the fast one in
+		* poll(), like a reload does.
+		*/
+		bool fast_link(uint64_t key, const GraphicsPipelineInBundle& specification)
+		{
+			PendingLink link;
+			link.layout = get_layout(specification);
+			link.specification = complete_vertex_input(specification);
+			vk::RenderPass renderpass = get_renderpass(specification.swapchainImageFormat, specification.depthFormat);
+			for (vk::GraphicsPipelineLibraryFlagBitsEXT part : { vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface,
+				vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders, vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader,
+				vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface })
+			{
+				link.parts.push_back(request_library(link.specification, link.layout, renderpass, part));
+			}
+
+			if (!parts_built(link))
+			{
+				linking[key] = std::move(link);
+				return true;
+			}
+			return link_parts(key, link);
+		}
+
+		bool parts_built(const PendingLink& link) const
+		{
+			for (uint64_t part : link.parts)
+			{
+				auto found = libraries.find(part);
+				if (found != libraries.end() && found->second.building.valid())
+					return false;
+			}
+			return true;
+		}
+
+		//A waiting link whose parts are built. False when a part failed, the key is then left to a whole compile
+		bool finish_link(uint64_t key)
+		{
+			PendingLink link = std::move(linking.at(key));
+			linking.erase(key);
+			if (link_parts(key, link))
+				return true;
+
+			//Failed parts are dropped so the next pipeline to need them tries again
+			for (uint64_t part : link.parts)
+			{
+				auto found = libraries.find(part);
+				if (found != libraries.end() && !found->second.library && !found->second.building.valid())
+					libraries.erase(found);
+			}
+			dirty.erase(key);
+			return false;
+		}
+
+		bool link_parts(uint64_t key, const PendingLink& link)
+		{
+			std::vector<vk::Pipeline> parts;
+			for (uint64_t part : link.parts)
+			{
+				auto found = libraries.find(part);
+				if (found == libraries.end() || !found->second.library)
+					return false;
+				parts.push_back(found->second.library);
+			}
+
+			std::string name = pipeline_name(link.specification);
+			vk::Pipeline pipeline = link_graphics_pipeline(device, parts, link.layout, link.specification.pipelineCache, false,
+				link.specification.creationLog, name, debug);
+			if (!pipeline)
+				return false;
+			land_pipeline(key, pipeline, link.layout);
+			fastLinks++;
+
+			vk::Device owner = device;
+			vk::PipelineLayout layout = link.layout;
+			vk::PipelineCache pipelineCache = link.specification.pipelineCache;
+			vkUtil::PipelineCreationLog* creationLog = link.specification.creationLog;
+			bool debugMessages = debug;
+			pending[key] = { workers.submit([owner, parts, layout, pipelineCache, creationLog, name, debugMessages]()
+				{
+					return link_graphics_pipeline(owner, parts, layout, pipelineCache, true, creationLog, name, debugMessages);
+				}), layout };
+			return true;
+		}
+
+		/*
+		* The libraries key of one part of a pipeline, building it on a worker if nothing has yet.
+		* Parts that read resources are made against a layout, so it's part of their key
+		*/
+		uint64_t request_library(const GraphicsPipelineInBundle& specification, vk::PipelineLayout layout, vk::RenderPass renderpass,
+			vk::GraphicsPipelineLibraryFlagBitsEXT part)
+		{
+			bool usesLayout = part == vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders || part == vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader;
+			uint64_t key = vkUtil::hash_value(static_cast<uint32_t>(part), hash_library_state(part, specification));
+			if (usesLayout)
+				key = vkUtil::hash_value(static_cast<VkPipelineLayout>(layout), key);
+			key = free_or_matching_key(libraries, key, [&](const LibraryEntry& entry)
+				{
+					return entry.part == part && (!usesLayout || entry.layout == layout) && same_library_state(part, entry.specification, specification);
+				});
+			if (libraries.count(key))
+				return key;
+
+			bool debugMessages = debug;
+			LibraryEntry& entry = libraries[key];
+			entry.part = part;
+			entry.layout = layout;
+			entry.specification = specification;
+			entry.building = workers.submit([specification, layout, renderpass, part, debugMessages]()
+				{
+					return make_pipeline_library(specification, layout, renderpass, part, debugMessages);
+				});
+			return key;
+		}
+
+		/*
+		* Without attribute descriptions the vertex shader's inputs are packed into binding 0 in
+		* location order. Given ones are checked against the shader instead: a location the shader
+		* reads with no attribute is an error, an attribute the shader ignores is only wasted fetch.
+		*/
+		GraphicsPipelineInBundle complete_vertex_input(const GraphicsPipelineInBundle& specification)
+		{
+			GraphicsPipelineInBundle completed = specification;
+			const std::vector<vkUtil::ShaderInput>& inputs =
+				reflect(specification.vertexFilepath, specification.shaderDefines, vk::ShaderStageFlagBits::eVertex).vertexInputs;
+
+			if (completed.attributeDescriptions.empty())
+			{
+				uint32_t offset = 0;
+				for (const vkUtil::ShaderInput& input : inputs)
+				{
+					completed.attributeDescriptions.push_back(vk::VertexInputAttributeDescription(input.location, 0, input.format, offset));
+					offset += input.size;
+				}
+				if (offset > 0)
+					completed.bindingDescriptions = { vk::VertexInputBindingDescription(0, offset, vk::VertexInputRate::eVertex) };
+				return completed;
+			}
+
+			if (!debug)
+				return completed;
+			for (const vkUtil::ShaderInput& input : inputs)
+			{
+				bool described = std::any_of(completed.attributeDescriptions.begin(), completed.attributeDescriptions.end(),
+					[&](const vk::VertexInputAttributeDescription& attribute) { return attribute.location == input.location; });
+				if (!described)
+					std::cout << "\"" << specification.vertexFilepath << "\" reads \"" << input.name << "\" at location "
+						<< input.location << " but no attribute feeds it" << std::endl;
+			}
+			for (const vk::VertexInputAttributeDescription& attribute : completed.attributeDescriptions)
+			{
+				bool read = std::any_of(inputs.begin(), inputs.end(),
+					[&](const vkUtil::ShaderInput& input) { return input.location == attribute.location; });
+				if (!read)
+					std::cout << "Attribute at location " << attribute.location << " isn't read by \""
+						<< specification.vertexFilepath << "\", it could be dropped" << std::endl;
+			}
+			return completed;
+		}
+
+		vk::Device device;
+		std::function<void(std::function<void()>&&)> deferDestroy;
+		bool debug;
+
+		//Pipelines are checked against specifications and computeSpecifications, see graphics_key
+		std::unordered_map<uint64_t, vk::Pipeline> pipelines;
+		std::unordered_map<uint64_t, vk::PipelineLayout> pipelineLayouts;
+		std::unordered_map<uint64_t, LayoutEntry> layouts;
+		std::unordered_map<uint64_t, SetLayoutEntry> setLayouts;
+		std::unordered_map<VkPipelineLayout, std::vector<vk::DescriptorSetLayout>> layoutSets;
+		std::unordered_map<uint64_t, ReflectionEntry> reflections;
+		std::unordered_map<uint64_t, RenderPassEntry> renderpasses;
+		std::unordered_map<uint64_t, GraphicsPipelineInBundle> specifications;
+		std::unordered_map<uint64_t, ComputePipelineInBundle> computeSpecifications;
+		std::unordered_set<uint64_t> requested;
+		size_t hits{ 0 };
+
+		//VK_EXT_graphics_pipeline_library parts, see fast_link
+		bool useLibraries{ false };
+		std::unordered_map<uint64_t, LibraryEntry> libraries;
+		std::unordered_map<uint64_t, PendingLink> linking;
+		size_t fastLinks{ 0 };
+
+		//Background compilation, see request_graphics_pipeline
+		std::unordered_map<uint64_t, PendingPipeline> pending;
+		std::unordered_map<uint64_t, PendingReflection> reflecting;
+		std::unordered_map<uint64_t, uint64_t> fallbacks;
+		vkUtil::ThreadPool workers;
+
+		//Keys changed on disk while they were compiling, see reload
+		std::unordered_set<uint64_t> dirty;
+	};
+}
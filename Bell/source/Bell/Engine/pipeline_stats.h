@@ -0,0 +1,255 @@
+#pragma once
+#include "config.h"
+#include <Core/json.h>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <iomanip>
+
+namespace vkUtil
+{
+	struct PipelineStageTiming
+	{
+		vk::ShaderStageFlagBits stage;
+		double milliseconds{ 0.0 };
+		bool cacheHit{ false };
+	};
+
+	/*
+	* One pipeline creation. Wall time is measured around the create call. The driver's own
+	* duration, the per-stage durations and whether the pipeline cache had it all come from
+	* VK_EXT_pipeline_creation_feedback, and are only valid when feedbackValid is.
+	*/
+	struct PipelineCreationRecord
+	{
+		std::string name;
+		double wallMilliseconds{ 0.0 };
+		bool created{ false };
+
+		bool feedbackValid{ false };
+		double driverMilliseconds{ 0.0 };
+		bool cacheHit{ false };
+		std::vector<PipelineStageTiming> stages;
+	};
+
+	enum class PipelineReportOrder
+	{
+		eWallTime,
+		eDriverTime,
+		eName,
+		eCreation
+	};
+
+	inline const char* stage_name(vk::ShaderStageFlagBits stage)
+	{
+		switch (stage)
+		{
+		case vk::ShaderStageFlagBits::eVertex:
+			return "vertex";
+		case vk::ShaderStageFlagBits::eFragment:
+			return "fragment";
+		case vk::ShaderStageFlagBits::eCompute:
+			return "compute";
+		default:
+			return "other";
+		}
+	}
+
+	//Every pipeline made by the registry, written from the compile threads as well as the main one
+	class PipelineCreationLog
+	{
+	public:
+
+		//Feedback structures may only be chained when VK_EXT_pipeline_creation_feedback is enabled
+		void set_feedback_supported(bool supported)
+		{
+			feedbackSupported = supported;
+		}
+
+		bool feedback_supported() const
+		{
+			return feedbackSupported;
+		}
+
+		void record(PipelineCreationRecord&& record)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			records.push_back(std::move(record));
+		}
+
+		//A copy, slowest first for the time orders
+		std::vector<PipelineCreationRecord> report(PipelineReportOrder order) const
+		{
+			std::vector<PipelineCreationRecord> sorted;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				sorted = records;
+			}
+
+			switch (order)
+			{
+			case PipelineReportOrder::eWallTime:
+				std::stable_sort(sorted.begin(), sorted.end(),
+					[](const PipelineCreationRecord& a, const PipelineCreationRecord& b) { return a.wallMilliseconds > b.wallMilliseconds; });
+				break;
+			case PipelineReportOrder::eDriverTime:
+				std::stable_sort(sorted.begin(), sorted.end(),
+					[](const PipelineCreationRecord& a, const PipelineCreationRecord& b) { return a.driverMilliseconds > b.driverMilliseconds; });
+				break;
+			case PipelineReportOrder::eName:
+				std::stable_sort(sorted.begin(), sorted.end(),
+					[](const PipelineCreationRecord& a, const PipelineCreationRecord& b) { return a.name < b.name; });
+				break;
+			default:
+				break;
+			}
+			return sorted;
+		}
+
+		size_t size() const
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return records.size();
+		}
+
+		double total_wall_milliseconds() const
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			double total = 0.0;
+			for (const PipelineCreationRecord& record : records)
+				total += record.wallMilliseconds;
+			return total;
+		}
+
+		//A table with at most limit rows, for the console
+		std::string to_string(PipelineReportOrder order, size_t limit = SIZE_MAX) const
+		{
+			std::vector<PipelineCreationRecord> sorted = report(order);
+			std::stringstream table;
+			table << std::fixed << std::setprecision(2);
+			table << sorted.size() << " pipeline(s) created\n";
+			for (size_t i = 0; i < sorted.size() && i < limit; i++)
+			{
+				const PipelineCreationRecord& record = sorted[i];
+				table << std::setw(9) << record.wallMilliseconds << " ms  ";
+				if (record.feedbackValid)
+				{
+					table << "driver " << record.driverMilliseconds << " ms" << (record.cacheHit ? ", cache hit" : "");
+					for (const PipelineStageTiming& stage : record.stages)
+						table << ", " << stage_name(stage.stage) << " " << stage.milliseconds << " ms";
+					table << "  ";
+				}
+				table << record.name << (record.created ? "" : " (failed)") << "\n";
+			}
+			return table.str();
+		}
+
+		std::string to_json(PipelineReportOrder order) const
+		{
+			std::vector<PipelineCreationRecord> sorted = report(order);
+			std::stringstream json;
+			json << std::fixed << std::setprecision(4);
+			json << "{\n\t\"feedbackSupported\": " << (feedbackSupported ? "true" : "false") << ",\n\t\"pipelines\": [\n";
+			for (size_t i = 0; i < sorted.size(); i++)
+			{
+				const PipelineCreationRecord& record = sorted[i];
+				json << "\t\t{ \"name\": \"" << json_escape(record.name) << "\""
+					<< ", \"created\": " << (record.created ? "true" : "false")
+					<< ", \"wallMs\": " << record.wallMilliseconds;
+				if (record.feedbackValid)
+				{
+					json << ", \"driverMs\": " << record.driverMilliseconds
+						<< ", \"cacheHit\": " << (record.cacheHit ? "true" : "false")
+						<< ", \"stages\": [";
+					for (size_t j = 0; j < record.stages.size(); j++)
+					{
+						const PipelineStageTiming& stage = record.stages[j];
+						json << (j > 0 ? ", " : " ") << "{ \"stage\": \"" << stage_name(stage.stage) << "\", \"ms\": " << stage.milliseconds
+							<< ", \"cacheHit\": " << (stage.cacheHit ? "true" : "false") << " }";
+					}
+					json << " ]";
+				}
+				json << " }" << (i + 1 < sorted.size() ? "," : "") << "\n";
+			}
+			json << "\t]\n}\n";
+			return json.str();
+		}
+
+	private:
+
+		mutable std::mutex mutex;
+		std::vector<PipelineCreationRecord> records;
+		bool feedbackSupported{ false };
+	};
+
+	/*
+	* Times one create call and chains the feedback structures for it. Lives on the stack next to
+	* the create info, which points into it, so it can't be copied.
+	*/
+	class PipelineCreationTimer
+	{
+	public:
+
+		PipelineCreationTimer(PipelineCreationLog* log, std::string name) :
+			log(log), name(std::move(name)), start(std::chrono::steady_clock::now()) {}
+
+		PipelineCreationTimer(const PipelineCreationTimer&) = delete;
+		PipelineCreationTimer& operator=(const PipelineCreationTimer&) = delete;
+
+		//Returns what the create info's pNext should be, stages in the order of its pStages
+		const void* chain(const void* pNext, const std::vector<vk::ShaderStageFlagBits>& shaderStages)
+		{
+			if (!log || !log->feedback_supported())
+				return pNext;
+
+			stages = shaderStages;
+			stageFeedback.resize(stages.size());
+			feedbackInfo.pNext = pNext;
+			feedbackInfo.pPipelineCreationFeedback = &pipelineFeedback;
+			feedbackInfo.pipelineStageCreationFeedbackCount = static_cast<uint32_t>(stageFeedback.size());
+			feedbackInfo.pPipelineStageCreationFeedbacks = stageFeedback.data();
+			chained = true;
+			return &feedbackInfo;
+		}
+
+		void finish(bool created)
+		{
+			if (!log)
+				return;
+
+			PipelineCreationRecord record;
+			record.name = name;
+			record.created = created;
+			record.wallMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			if (chained && (pipelineFeedback.flags & vk::PipelineCreationFeedbackFlagBits::eValid))
+			{
+				record.feedbackValid = true;
+				record.driverMilliseconds = pipelineFeedback.duration / 1e6;
+				record.cacheHit = bool(pipelineFeedback.flags & vk::PipelineCreationFeedbackFlagBits::eApplicationPipelineCacheHit);
+				for (size_t i = 0; i < stages.size(); i++)
+				{
+					if (!(stageFeedback[i].flags & vk::PipelineCreationFeedbackFlagBits::eValid))
+						continue;
+					PipelineStageTiming stage;
+					stage.stage = stages[i];
+					stage.milliseconds = stageFeedback[i].duration / 1e6;
+					stage.cacheHit = bool(stageFeedback[i].flags & vk::PipelineCreationFeedbackFlagBits::eApplicationPipelineCacheHit);
+					record.stages.push_back(stage);
+				}
+			}
+			log->record(std::move(record));
+		}
+
+	private:
+
+		PipelineCreationLog* log;
+		std::string name;
+		std::chrono::steady_clock::time_point start;
+
+		bool chained{ false };
+		std::vector<vk::ShaderStageFlagBits> stages;
+		vk::PipelineCreationFeedback pipelineFeedback = {};
+		std::vector<vk::PipelineCreationFeedback> stageFeedback;
+		vk::PipelineCreationFeedbackCreateInfo feedbackInfo = {};
+	};
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "config.h"
+#include "pipeline.h"
+#include "pipeline_registry.h"
+#include <unordered_map>
+#include <cstring>
+
+namespace vkInit
+{
+	//Feature bit i becomes the VkBool32 specialization constant with constant_id i
+	void specialize_features(GraphicsPipelineInBundle& specification, uint32_t features, uint32_t featureCount)
+	{
+		specification.specializationEntries.clear();
+		specification.specializationData.resize(featureCount * sizeof(VkBool32));
+		for (uint32_t i = 0; i < featureCount; i++)
+		{
+			VkBool32 enabled = (features >> i) & 1u;
+			memcpy(specification.specializationData.data() + i * sizeof(VkBool32), &enabled, sizeof(VkBool32));
+			specification.specializationEntries.push_back(vk::SpecializationMapEntry(i, i * sizeof(VkBool32), sizeof(VkBool32)));
+		}
+	}
+
+	/*
+	* Pipelines made from one specification that differ only in which features are switched
+	* on. Features are specialization constants rather than defines, so every variant shares
+	* one SPIR-V module and the driver folds the disabled branches away when it compiles the
+	* variant. A variant is requested from the registry the first time it is asked for, and
+	* draws with the first variant ever requested until it has compiled.
+	*/
+	class PipelineVariants
+	{
+	public:
+
+		PipelineVariants(PipelineRegistry* registry, const GraphicsPipelineInBundle& specification, uint32_t featureCount) :
+			registry(registry), specification(specification), featureCount(featureCount) {}
+
+		//Registry key of the variant, cheap once it has been asked for
+		uint64_t get(uint32_t features)
+		{
+			features &= featureCount < 32 ? (1u << featureCount) - 1 : ~0u;
+			auto found = keys.find(features);
+			if (found != keys.end())
+				return found->second;
+
+			GraphicsPipelineInBundle variant = specification;
+			specialize_features(variant, features, featureCount);
+			uint64_t key = registry->request_graphics_pipeline(variant, fallbackKey);
+			if (fallbackKey == 0)
+				fallbackKey = key;
+			keys[features] = key;
+			return key;
+		}
+
+		size_t variant_count() const
+		{
+			return keys.size();
+		}
+
+	private:
+
+		PipelineRegistry* registry;
+		GraphicsPipelineInBundle specification;
+		uint32_t featureCount;
+		uint64_t fallbackKey{ 0 };
+		std::unordered_map<uint32_t, uint64_t> keys;
+	};
+}
@@ -25,12 +25,13 @@ namespace vkUtil
 		int i = 0;
 		for (vk::QueueFamilyProperties queueFamily : queueFamilies)
 		{
-			if (queueFamily.queueFlags & vk::QueueFlagBits::eGraphics)
+			//Compute work is recorded alongside the draws, Vulkan guarantees a family that does both when any does graphics
+			if ((queueFamily.queueFlags & vk::QueueFlagBits::eGraphics) && (queueFamily.queueFlags & vk::QueueFlagBits::eCompute))
 			{
 				indices.graphicsFamily = i;
 
 				if (debug)
-					std::cout << "Queue Family " << i << " is suitable for graphics \n";
+					std::cout << "Queue Family " << i << " is suitable for graphics and compute \n";
 			}
 
 			if (device.getSurfaceSupportKHR(i, surface)) {
@@ -0,0 +1,115 @@
+#pragma once
+#include "config.h"
+#include <map>
+
+namespace vkUtil
+{
+	//First fit sub-allocator over [0, capacity), free ranges are kept sorted by offset and merged with their neighbours
+	class RangeAllocator
+	{
+	public:
+
+		RangeAllocator() = default;
+
+		explicit RangeAllocator(vk::DeviceSize capacity)
+		{
+			reset(capacity);
+		}
+
+		void reset(vk::DeviceSize capacity)
+		{
+			freeRanges.clear();
+			totalBytes = capacity;
+			usedBytes = 0;
+			if (capacity > 0)
+				freeRanges[0] = capacity;
+		}
+
+		//The alignment doesn't have to be a power of two, vertex ranges are aligned to the vertex stride
+		bool allocate(vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& offset)
+		{
+			if (size == 0)
+				return false;
+
+			for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it)
+			{
+				vk::DeviceSize rangeBegin = it->first;
+				vk::DeviceSize rangeEnd = it->first + it->second;
+				vk::DeviceSize aligned = (rangeBegin + alignment - 1) / alignment * alignment;
+				if (aligned + size > rangeEnd)
+					continue;
+
+				freeRanges.erase(it);
+				if (aligned > rangeBegin)
+					freeRanges[rangeBegin] = aligned - rangeBegin;
+				if (aligned + size < rangeEnd)
+					freeRanges[aligned + size] = rangeEnd - aligned - size;
+
+				usedBytes += size;
+				offset = aligned;
+				return true;
+			}
+			return false;
+		}
+
+		void free(vk::DeviceSize offset, vk::DeviceSize size)
+		{
+			if (size == 0)
+				return;
+
+			usedBytes -= size;
+			auto it = freeRanges.emplace(offset, size).first;
+
+			auto next = std::next(it);
+			if (next != freeRanges.end() && it->first + it->second == next->first)
+			{
+				it->second += next->second;
+				freeRanges.erase(next);
+			}
+
+			if (it != freeRanges.begin())
+			{
+				auto previous = std::prev(it);
+				if (previous->first + previous->second == it->first)
+				{
+					previous->second += it->second;
+					freeRanges.erase(it);
+				}
+			}
+		}
+
+		//Extend the managed range, existing allocations keep their offsets
+		void grow(vk::DeviceSize capacity)
+		{
+			if (capacity <= totalBytes)
+				return;
+
+			vk::DeviceSize previousCapacity = totalBytes;
+			totalBytes = capacity;
+			usedBytes += capacity - previousCapacity;
+			free(previousCapacity, capacity - previousCapacity);
+		}
+
+		vk::DeviceSize capacity() const
+		{
+			return totalBytes;
+		}
+
+		vk::DeviceSize used() const
+		{
+			return usedBytes;
+		}
+
+		size_t free_range_count() const
+		{
+			return freeRanges.size();
+		}
+
+	private:
+
+		//Offset to size
+		std::map<vk::DeviceSize, vk::DeviceSize> freeRanges;
+		vk::DeviceSize totalBytes{ 0 };
+		vk::DeviceSize usedBytes{ 0 };
+	};
+}
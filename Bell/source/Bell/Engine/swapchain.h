@@ -131,7 +131,9 @@ namespace vkInit
 		}
 	}
 
-	SwapChainBundle create_swapchain(vk::Device logicalDevice, vk::PhysicalDevice physicalDevice, vk::SurfaceKHR surface, int width, int height, bool debug)
+	//Pass the swapchain being replaced on a resize, the caller destroys it afterwards
+	SwapChainBundle create_swapchain(vk::Device logicalDevice, vk::PhysicalDevice physicalDevice, vk::SurfaceKHR surface, int width, int height, bool debug,
+		vk::SwapchainKHR oldSwapchain = nullptr)
 	{
 		SwapChainSupportDetails support = query_swapchain_support(physicalDevice, surface, debug);
 
@@ -171,7 +173,7 @@ namespace vkInit
 		//Not "always on top"
 		createInfo.clipped = VK_TRUE;
 
-		createInfo.oldSwapchain = vk::SwapchainKHR(nullptr);
+		createInfo.oldSwapchain = oldSwapchain;
 
 		SwapChainBundle bundle{};
 		try {
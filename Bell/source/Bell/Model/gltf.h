@@ -0,0 +1,652 @@
+#pragma once
+#include <Engine/config.h>
+#include <Core/json.h>
+#include <Core/mapped_file.h>
+#include "mesh.h"
+#include "mesh_optimizer.h"
+#include <gtc/quaternion.hpp>
+#include <future>
+#include <cstring>
+
+namespace vkMesh
+{
+	struct GltfDocument
+	{
+		vkUtil::JsonValue json;
+		std::vector<std::vector<char>> buffers;
+	};
+
+	//Per-primitive result of the importer, the cache miss ratios are kept for logging
+	struct GltfPrimitive
+	{
+		MeshData mesh;
+		float acmrBefore{ 0.0f };
+		float acmrAfter{ 0.0f };
+	};
+
+	std::vector<char> read_binary_file(const std::string& filename)
+	{
+		vkUtil::MappedFile file(filename);
+		if (!file.is_open())
+			return {};
+
+		return std::vector<char>(file.data(), file.data() + file.size());
+	}
+
+	std::vector<char> decode_base64(const std::string& text, size_t start)
+	{
+		auto sextet = [](char c) -> int
+		{
+			if (c >= 'A' && c <= 'Z') return c - 'A';
+			if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+			if (c >= '0' && c <= '9') return c - '0' + 52;
+			if (c == '+' || c == '-') return 62;
+			if (c == '/' || c == '_') return 63;
+			return -1;
+		};
+
+		std::vector<char> bytes;
+		bytes.reserve((text.size() - start) * 3 / 4);
+
+		uint32_t accumulator = 0;
+		int bits = 0;
+		for (size_t i = start; i < text.size(); i++)
+		{
+			int value = sextet(text[i]);
+			if (value < 0)
+				continue;
+
+			accumulator = (accumulator << 6) | static_cast<uint32_t>(value);
+			bits += 6;
+			if (bits >= 8)
+			{
+				bits -= 8;
+				bytes.push_back(static_cast<char>((accumulator >> bits) & 0xFF));
+			}
+		}
+		return bytes;
+	}
+
+	std::vector<char> load_gltf_buffer(const vkUtil::JsonValue& buffer, const std::string& directory, std::vector<char>* glbChunk)
+	{
+		const vkUtil::JsonValue& uri = buffer["uri"];
+
+		//A buffer without a uri refers to the binary chunk of a .glb
+		if (!uri.is_string())
+			return glbChunk ? std::move(*glbChunk) : std::vector<char>();
+
+		const std::string& path = uri.as_string();
+		if (path.rfind("data:", 0) == 0)
+		{
+			size_t comma = path.find(',');
+			return comma == std::string::npos ? std::vector<char>() : decode_base64(path, comma + 1);
+		}
+
+		return read_binary_file(directory + path);
+	}
+
+	size_t gltf_component_count(const std::string& type)
+	{
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		if (type == "MAT4") return 16;
+		return 0;
+	}
+
+	size_t gltf_component_size(int64_t componentType)
+	{
+		switch (componentType)
+		{
+		case 5120: //BYTE
+		case 5121: //UNSIGNED_BYTE
+			return 1;
+		case 5122: //SHORT
+		case 5123: //UNSIGNED_SHORT
+			return 2;
+		case 5125: //UNSIGNED_INT
+		case 5126: //FLOAT
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	//Decode one component, normalized integers are mapped to [0, 1] or [-1, 1] as the spec requires
+	float read_gltf_component(const char* data, int64_t componentType, bool normalized)
+	{
+		switch (componentType)
+		{
+		case 5120:
+		{
+			int8_t value;
+			memcpy(&value, data, sizeof(value));
+			return normalized ? std::max(value / 127.0f, -1.0f) : float(value);
+		}
+		case 5121:
+		{
+			uint8_t value;
+			memcpy(&value, data, sizeof(value));
+			return normalized ? value / 255.0f : float(value);
+		}
+		case 5122:
+		{
+			int16_t value;
+			memcpy(&value, data, sizeof(value));
+			return normalized ? std::max(value / 32767.0f, -1.0f) : float(value);
+		}
+		case 5123:
+		{
+			uint16_t value;
+			memcpy(&value, data, sizeof(value));
+			return normalized ? value / 65535.0f : float(value);
+		}
+		case 5125:
+		{
+			uint32_t value;
+			memcpy(&value, data, sizeof(value));
+			return float(value);
+		}
+		case 5126:
+		{
+			float value;
+			memcpy(&value, data, sizeof(value));
+			return value;
+		}
+		default:
+			return 0.0f;
+		}
+	}
+
+	//Where an accessor's elements sit in its buffer, data is null when the accessor is missing or out of bounds
+	struct GltfAccessorView
+	{
+		const char* data = nullptr;
+		size_t count = 0;
+		size_t stride = 0;
+		size_t componentSize = 0;
+		size_t components = 0;
+		int64_t componentType = 0;
+		bool normalized = false;
+	};
+
+	GltfAccessorView view_gltf_accessor(const GltfDocument& document, int64_t accessorIndex)
+	{
+		GltfAccessorView view;
+		const vkUtil::JsonValue& accessor = document.json["accessors"][accessorIndex];
+		view.count = static_cast<size_t>(accessor["count"].as_int(0));
+
+		int64_t bufferViewIndex = accessor["bufferView"].as_int();
+		if (bufferViewIndex < 0)
+			return view;
+
+		const vkUtil::JsonValue& bufferView = document.json["bufferViews"][bufferViewIndex];
+		int64_t bufferIndex = bufferView["buffer"].as_int();
+		if (bufferIndex < 0 || bufferIndex >= static_cast<int64_t>(document.buffers.size()))
+			return view;
+		const std::vector<char>& buffer = document.buffers[bufferIndex];
+
+		view.componentType = accessor["componentType"].as_int();
+		view.normalized = accessor["normalized"].boolean;
+		view.componentSize = gltf_component_size(view.componentType);
+		view.components = gltf_component_count(accessor["type"].as_string());
+		size_t elementSize = view.componentSize * view.components;
+		view.stride = static_cast<size_t>(bufferView["byteStride"].as_int(0));
+		if (view.stride == 0)
+			view.stride = elementSize;
+
+		size_t offset = static_cast<size_t>(bufferView["byteOffset"].as_int(0) + accessor["byteOffset"].as_int(0));
+		if (view.componentSize == 0 || view.count == 0 || offset + (view.count - 1) * view.stride + elementSize > buffer.size())
+			return view;
+
+		view.data = buffer.data() + offset;
+		return view;
+	}
+
+	//Read an accessor as tightly packed floats, "components" values per element
+	std::vector<float> read_gltf_accessor(const GltfDocument& document, int64_t accessorIndex, size_t components)
+	{
+		GltfAccessorView view = view_gltf_accessor(document, accessorIndex);
+		std::vector<float> values(view.count * components, 0.0f);
+		if (!view.data)
+			return values;
+
+		size_t copied = std::min(components, view.components);
+		for (size_t i = 0; i < view.count; i++)
+		{
+			const char* element = view.data + i * view.stride;
+			for (size_t c = 0; c < copied; c++)
+				values[i * components + c] = read_gltf_component(element + c * view.componentSize, view.componentType, view.normalized);
+		}
+		return values;
+	}
+
+	//Indices are read as integers, a float only holds them exactly up to 2^24
+	std::vector<uint32_t> read_gltf_indices(const GltfDocument& document, int64_t accessorIndex)
+	{
+		GltfAccessorView view = view_gltf_accessor(document, accessorIndex);
+		std::vector<uint32_t> indices(view.count, 0);
+		if (!view.data)
+			return indices;
+
+		for (size_t i = 0; i < view.count; i++)
+		{
+			const char* element = view.data + i * view.stride;
+			switch (view.componentType)
+			{
+			case 5121: //UNSIGNED_BYTE
+			{
+				uint8_t value;
+				memcpy(&value, element, sizeof(value));
+				indices[i] = value;
+				break;
+			}
+			case 5123: //UNSIGNED_SHORT
+			{
+				uint16_t value;
+				memcpy(&value, element, sizeof(value));
+				indices[i] = value;
+				break;
+			}
+			case 5125: //UNSIGNED_INT
+				memcpy(&indices[i], element, sizeof(uint32_t));
+				break;
+			default:
+				//Not a valid index type, an empty list drops the primitive like any other bad index
+				indices.clear();
+				return indices;
+			}
+		}
+		return indices;
+	}
+
+	//Per vertex tangents from the texture coordinate gradients, orthogonalized against the normal
+	void generate_tangents(MeshData& data)
+	{
+		std::vector<glm::vec3> bitangents(data.vertices.size(), glm::vec3(0.0f));
+		for (size_t i = 0; i < data.indices.size(); i += 3)
+		{
+			Vertex& a = data.vertices[data.indices[i + 0]];
+			Vertex& b = data.vertices[data.indices[i + 1]];
+			Vertex& c = data.vertices[data.indices[i + 2]];
+
+			glm::vec3 edge1 = b.position - a.position;
+			glm::vec3 edge2 = c.position - a.position;
+			glm::vec2 delta1 = b.texcoord - a.texcoord;
+			glm::vec2 delta2 = c.texcoord - a.texcoord;
+			float determinant = delta1.x * delta2.y - delta2.x * delta1.y;
+			if (std::abs(determinant) < 1e-12f)
+				continue;
+
+			float inverse = 1.0f / determinant;
+			glm::vec3 tangent = (edge1 * delta2.y - edge2 * delta1.y) * inverse;
+			glm::vec3 bitangent = (edge2 * delta1.x - edge1 * delta2.x) * inverse;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				data.vertices[data.indices[i + corner]].tangent += glm::vec4(tangent, 0.0f);
+				bitangents[data.indices[i + corner]] += bitangent;
+			}
+		}
+
+		for (size_t i = 0; i < data.vertices.size(); i++)
+		{
+			Vertex& vertex = data.vertices[i];
+			glm::vec3 tangent = glm::vec3(vertex.tangent) - vertex.normal * glm::dot(vertex.normal, glm::vec3(vertex.tangent));
+
+			//No usable texture coordinates, any direction perpendicular to the normal will do
+			if (glm::length(tangent) < 1e-6f)
+				tangent = glm::cross(vertex.normal, std::abs(vertex.normal.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f));
+
+			tangent = glm::normalize(tangent);
+			float handedness = glm::dot(glm::cross(vertex.normal, tangent), bitangents[i]) < 0.0f ? -1.0f : 1.0f;
+			vertex.tangent = glm::vec4(tangent, handedness);
+		}
+	}
+
+	uint32_t gltf_material_features(const vkUtil::JsonValue& json, int materialIndex)
+	{
+		uint32_t features = defaultMaterialFeatures;
+		if (materialIndex < 0)
+			return features;
+
+		const vkUtil::JsonValue& material = json["materials"][static_cast<size_t>(materialIndex)];
+		if (material["extensions"].find("KHR_materials_unlit"))
+			features &= ~eFeatureLighting;
+		return features;
+	}
+
+	GltfPrimitive build_gltf_primitive(const GltfDocument& document, const vkUtil::JsonValue& mesh, size_t primitiveIndex)
+	{
+		const vkUtil::JsonValue& primitive = mesh["primitives"][primitiveIndex];
+		const vkUtil::JsonValue& attributes = primitive["attributes"];
+
+		GltfPrimitive result;
+		MeshData& data = result.mesh;
+		data.name = mesh["name"].as_string() + "/" + std::to_string(primitiveIndex);
+		data.materialIndex = static_cast<int>(primitive["material"].as_int());
+		data.features = gltf_material_features(document.json, data.materialIndex);
+
+		std::vector<float> positions = read_gltf_accessor(document, attributes["POSITION"].as_int(), 3);
+		size_t vertexCount = positions.size() / 3;
+		if (vertexCount == 0)
+			return result;
+
+		std::vector<float> normals;
+		if (attributes.find("NORMAL"))
+			normals = read_gltf_accessor(document, attributes["NORMAL"].as_int(), 3);
+		std::vector<float> texcoords;
+		if (attributes.find("TEXCOORD_0"))
+			texcoords = read_gltf_accessor(document, attributes["TEXCOORD_0"].as_int(), 2);
+		std::vector<float> tangents;
+		if (attributes.find("TANGENT"))
+			tangents = read_gltf_accessor(document, attributes["TANGENT"].as_int(), 4);
+
+		data.vertices.resize(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			Vertex& vertex = data.vertices[i];
+			vertex.position = glm::vec3(positions[i * 3 + 0], positions[i * 3 + 1], positions[i * 3 + 2]);
+			vertex.normal = normals.size() == positions.size()
+				? glm::vec3(normals[i * 3 + 0], normals[i * 3 + 1], normals[i * 3 + 2])
+				: glm::vec3(0.0f);
+			vertex.texcoord = texcoords.size() == vertexCount * 2
+				? glm::vec2(texcoords[i * 2 + 0], texcoords[i * 2 + 1])
+				: glm::vec2(0.0f);
+			vertex.tangent = tangents.size() == vertexCount * 4
+				? glm::vec4(tangents[i * 4 + 0], tangents[i * 4 + 1], tangents[i * 4 + 2], tangents[i * 4 + 3])
+				: glm::vec4(0.0f);
+		}
+
+		if (primitive.find("indices"))
+			data.indices = read_gltf_indices(document, primitive["indices"].as_int());
+		else
+		{
+			data.indices.resize(vertexCount);
+			for (uint32_t i = 0; i < vertexCount; i++)
+				data.indices[i] = i;
+		}
+
+		//Drop anything that isn't a complete, in range triangle
+		data.indices.resize(data.indices.size() - data.indices.size() % 3);
+		for (uint32_t index : data.indices)
+		{
+			if (index >= vertexCount)
+			{
+				data.indices.clear();
+				return result;
+			}
+		}
+
+		//Smooth normals from the faces when the asset doesn't have any
+		if (normals.size() != positions.size())
+		{
+			for (size_t i = 0; i < data.indices.size(); i += 3)
+			{
+				Vertex& a = data.vertices[data.indices[i + 0]];
+				Vertex& b = data.vertices[data.indices[i + 1]];
+				Vertex& c = data.vertices[data.indices[i + 2]];
+				glm::vec3 faceNormal = glm::cross(b.position - a.position, c.position - a.position);
+				a.normal += faceNormal;
+				b.normal += faceNormal;
+				c.normal += faceNormal;
+			}
+			for (Vertex& vertex : data.vertices)
+			{
+				float length = glm::length(vertex.normal);
+				vertex.normal = length > 0.0f ? vertex.normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+			}
+		}
+
+		if (tangents.size() != vertexCount * 4)
+			generate_tangents(data);
+
+		//Index order for the post-transform cache, then cluster order for overdraw, then vertex order for fetch
+		result.acmrBefore = average_cache_miss_ratio(data.indices, data.vertices.size());
+		optimize_vertex_cache(data.indices, data.vertices.size());
+		optimize_overdraw(data.indices, &data.vertices[0].position.x, data.vertices.size(), sizeof(Vertex));
+		optimize_vertex_fetch(data.vertices, data.indices);
+		result.acmrAfter = average_cache_miss_ratio(data.indices, data.vertices.size());
+
+		data.boundsMin = data.vertices[0].position;
+		data.boundsMax = data.vertices[0].position;
+		for (const Vertex& vertex : data.vertices)
+		{
+			data.boundsMin = glm::min(data.boundsMin, vertex.position);
+			data.boundsMax = glm::max(data.boundsMax, vertex.position);
+		}
+
+		return result;
+	}
+
+	glm::mat4 gltf_node_transform(const vkUtil::JsonValue& node)
+	{
+		const vkUtil::JsonValue& matrix = node["matrix"];
+		if (matrix.size() == 16)
+		{
+			glm::mat4 transform;
+			for (int i = 0; i < 16; i++)
+				transform[i / 4][i % 4] = static_cast<float>(matrix[i].as_number());
+			return transform;
+		}
+
+		const vkUtil::JsonValue& translation = node["translation"];
+		const vkUtil::JsonValue& rotation = node["rotation"];
+		const vkUtil::JsonValue& scale = node["scale"];
+
+		glm::mat4 transform(1.0f);
+		if (translation.size() == 3)
+			transform = glm::translate(transform, glm::vec3(translation[0].as_number(), translation[1].as_number(), translation[2].as_number()));
+		if (rotation.size() == 4)
+		{
+			//glTF stores quaternions as xyzw
+			glm::quat orientation(static_cast<float>(rotation[3].as_number()), static_cast<float>(rotation[0].as_number()),
+				static_cast<float>(rotation[1].as_number()), static_cast<float>(rotation[2].as_number()));
+			transform = transform * glm::mat4_cast(orientation);
+		}
+		if (scale.size() == 3)
+			transform = glm::scale(transform, glm::vec3(scale[0].as_number(1.0), scale[1].as_number(1.0), scale[2].as_number(1.0)));
+		return transform;
+	}
+
+	//Walk the node hierarchy and place every primitive of every referenced mesh
+	void collect_gltf_instances(const vkUtil::JsonValue& nodes, size_t nodeIndex, const glm::mat4& parentTransform, bool parentAnimated,
+		const std::vector<bool>& animatedNodes, const std::vector<std::vector<uint32_t>>& meshPrimitives, std::vector<bool>& visited,
+		std::vector<MeshInstance>& instances)
+	{
+		if (nodeIndex >= nodes.size() || visited[nodeIndex])
+			return;
+		visited[nodeIndex] = true;
+
+		const vkUtil::JsonValue& node = nodes[nodeIndex];
+		glm::mat4 transform = parentTransform * gltf_node_transform(node);
+		bool animated = parentAnimated || animatedNodes[nodeIndex];
+
+		int64_t meshIndex = node["mesh"].as_int();
+		if (meshIndex >= 0 && size_t(meshIndex) < meshPrimitives.size())
+		{
+			for (uint32_t primitive : meshPrimitives[meshIndex])
+				instances.push_back({ primitive, transform, !animated });
+		}
+
+		const vkUtil::JsonValue& children = node["children"];
+		for (size_t i = 0; i < children.size(); i++)
+			collect_gltf_instances(nodes, static_cast<size_t>(children[i].as_int()), transform, animated, animatedNodes, meshPrimitives, visited, instances);
+	}
+
+	//Instances of the default scene, or of every root node if the file has no scenes, or one per mesh if it has no nodes
+	std::vector<MeshInstance> load_gltf_instances(const vkUtil::JsonValue& json, const std::vector<std::vector<uint32_t>>& meshPrimitives)
+	{
+		std::vector<MeshInstance> instances;
+		const vkUtil::JsonValue& nodes = json["nodes"];
+		if (nodes.size() == 0)
+		{
+			for (const std::vector<uint32_t>& primitives : meshPrimitives)
+			{
+				for (uint32_t primitive : primitives)
+					instances.push_back({ primitive, glm::mat4(1.0f), true });
+			}
+			return instances;
+		}
+
+		//Nodes driven by an animation channel, and everything below them, can't be baked into a static batch
+		std::vector<bool> animatedNodes(nodes.size(), false);
+		const vkUtil::JsonValue& animations = json["animations"];
+		for (size_t i = 0; i < animations.size(); i++)
+		{
+			const vkUtil::JsonValue& channels = animations[i]["channels"];
+			for (size_t c = 0; c < channels.size(); c++)
+			{
+				int64_t target = channels[c]["target"]["node"].as_int();
+				if (target >= 0 && size_t(target) < nodes.size())
+					animatedNodes[target] = true;
+			}
+		}
+
+		std::vector<size_t> roots;
+		const vkUtil::JsonValue& scenes = json["scenes"];
+		if (scenes.size() > 0)
+		{
+			const vkUtil::JsonValue& sceneNodes = scenes[static_cast<size_t>(std::max<int64_t>(json["scene"].as_int(0), 0))]["nodes"];
+			for (size_t i = 0; i < sceneNodes.size(); i++)
+				roots.push_back(static_cast<size_t>(sceneNodes[i].as_int()));
+		}
+		else
+		{
+			std::vector<bool> isChild(nodes.size(), false);
+			for (size_t i = 0; i < nodes.size(); i++)
+			{
+				const vkUtil::JsonValue& children = nodes[i]["children"];
+				for (size_t c = 0; c < children.size(); c++)
+				{
+					int64_t child = children[c].as_int();
+					if (child >= 0 && size_t(child) < nodes.size())
+						isChild[child] = true;
+				}
+			}
+			for (size_t i = 0; i < nodes.size(); i++)
+			{
+				if (!isChild[i])
+					roots.push_back(i);
+			}
+		}
+
+		std::vector<bool> visited(nodes.size(), false);
+		for (size_t root : roots)
+			collect_gltf_instances(nodes, root, glm::mat4(1.0f), false, animatedNodes, meshPrimitives, visited, instances);
+		return instances;
+	}
+
+	//Load every triangle primitive of a .gltf or .glb file and the node transforms that place them, buffers and meshes are processed in parallel
+	ModelData load_gltf(const std::string& filename, bool debug)
+	{
+		ModelData model;
+		std::vector<MeshData>& meshes = model.meshes;
+
+		std::vector<char> file = read_binary_file(filename);
+		if (file.empty())
+		{
+			if (debug)
+				std::cout << "Failed to load \"" << filename << "\"" << std::endl;
+			return model;
+		}
+
+		std::string directory;
+		size_t slash = filename.find_last_of("/\\");
+		if (slash != std::string::npos)
+			directory = filename.substr(0, slash + 1);
+
+		GltfDocument document;
+		std::vector<char> glbChunk;
+		try
+		{
+			const char* jsonBegin = file.data();
+			const char* jsonEnd = file.data() + file.size();
+
+			//Binary glTF: 12 byte header, then a JSON chunk and an optional BIN chunk
+			uint32_t magic = 0;
+			memcpy(&magic, file.data(), std::min<size_t>(file.size(), sizeof(magic)));
+			if (magic == 0x46546C67)
+			{
+				uint32_t jsonLength = 0;
+				if (file.size() < 20)
+					throw std::runtime_error("Truncated glb header");
+				memcpy(&jsonLength, file.data() + 12, sizeof(jsonLength));
+				if (20 + size_t(jsonLength) > file.size())
+					throw std::runtime_error("Truncated glb JSON chunk");
+				jsonBegin = file.data() + 20;
+				jsonEnd = jsonBegin + jsonLength;
+
+				size_t binOffset = 20 + size_t(jsonLength);
+				if (binOffset + 8 <= file.size())
+				{
+					uint32_t binLength = 0;
+					memcpy(&binLength, file.data() + binOffset, sizeof(binLength));
+					binLength = static_cast<uint32_t>(std::min<size_t>(binLength, file.size() - binOffset - 8));
+					glbChunk.assign(file.data() + binOffset + 8, file.data() + binOffset + 8 + binLength);
+				}
+			}
+
+			document.json = vkUtil::JsonParser::parse(jsonBegin, jsonEnd);
+		}
+		catch (std::runtime_error& err)
+		{
+			if (debug)
+				std::cout << "Failed to parse \"" << filename << "\": " << err.what() << std::endl;
+			return model;
+		}
+
+		//Buffers are independent, so read and decode them concurrently
+		const vkUtil::JsonValue& buffers = document.json["buffers"];
+		std::vector<std::future<std::vector<char>>> bufferLoads;
+		for (size_t i = 0; i < buffers.size(); i++)
+		{
+			std::vector<char>* chunk = i == 0 ? &glbChunk : nullptr;
+			bufferLoads.push_back(std::async(std::launch::async, load_gltf_buffer, std::cref(buffers[i]), std::cref(directory), chunk));
+		}
+		for (std::future<std::vector<char>>& load : bufferLoads)
+			document.buffers.push_back(load.get());
+
+		//One task per mesh, each decodes and optimises all of its primitives
+		const vkUtil::JsonValue& gltfMeshes = document.json["meshes"];
+		std::vector<std::future<std::vector<GltfPrimitive>>> meshBuilds;
+		for (size_t i = 0; i < gltfMeshes.size(); i++)
+		{
+			meshBuilds.push_back(std::async(std::launch::async, [&document, &gltfMeshes, i]()
+				{
+					std::vector<GltfPrimitive> primitives;
+					const vkUtil::JsonValue& mesh = gltfMeshes[i];
+					for (size_t p = 0; p < mesh["primitives"].size(); p++)
+					{
+						//Only triangle lists (mode 4, the default) are supported
+						if (mesh["primitives"][p]["mode"].as_int(4) != 4)
+							continue;
+						primitives.push_back(build_gltf_primitive(document, mesh, p));
+					}
+					return primitives;
+				}));
+		}
+
+		std::vector<std::vector<uint32_t>> meshPrimitives(meshBuilds.size());
+		for (size_t i = 0; i < meshBuilds.size(); i++)
+		{
+			for (GltfPrimitive& primitive : meshBuilds[i].get())
+			{
+				if (primitive.mesh.indices.empty())
+					continue;
+
+				if (debug)
+				{
+					std::cout << "Loaded mesh \"" << primitive.mesh.name << "\": " << primitive.mesh.vertices.size() << " vertices, "
+						<< primitive.mesh.indices.size() / 3 << " triangles, ACMR " << primitive.acmrBefore << " -> " << primitive.acmrAfter << std::endl;
+				}
+				meshPrimitives[i].push_back(static_cast<uint32_t>(meshes.size()));
+				meshes.push_back(std::move(primitive.mesh));
+			}
+		}
+
+		model.instances = load_gltf_instances(document.json, meshPrimitives);
+
+		return model;
+	}
+}
@@ -0,0 +1,277 @@
+#pragma once
+#include <Engine/config.h>
+#include <Engine/range_allocator.h>
+
+namespace vkMesh
+{
+	struct Vertex
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 texcoord;
+
+		//xyz is the tangent direction, w the handedness of the bitangent
+		glm::vec4 tangent;
+
+		static vk::VertexInputBindingDescription binding_description()
+		{
+			vk::VertexInputBindingDescription bindingDescription;
+			bindingDescription.binding = 0;
+			bindingDescription.stride = sizeof(Vertex);
+			bindingDescription.inputRate = vk::VertexInputRate::eVertex;
+			return bindingDescription;
+		}
+
+		static std::vector<vk::VertexInputAttributeDescription> attribute_descriptions()
+		{
+			std::vector<vk::VertexInputAttributeDescription> attributes(4);
+
+			//Position
+			attributes[0].binding = 0;
+			attributes[0].location = 0;
+			attributes[0].format = vk::Format::eR32G32B32Sfloat;
+			attributes[0].offset = offsetof(Vertex, position);
+
+			//Normal
+			attributes[1].binding = 0;
+			attributes[1].location = 1;
+			attributes[1].format = vk::Format::eR32G32B32Sfloat;
+			attributes[1].offset = offsetof(Vertex, normal);
+
+			//Texture coordinate
+			attributes[2].binding = 0;
+			attributes[2].location = 2;
+			attributes[2].format = vk::Format::eR32G32Sfloat;
+			attributes[2].offset = offsetof(Vertex, texcoord);
+
+			//Tangent
+			attributes[3].binding = 0;
+			attributes[3].location = 3;
+			attributes[3].format = vk::Format::eR32G32B32A32Sfloat;
+			attributes[3].offset = offsetof(Vertex, tangent);
+
+			return attributes;
+		}
+	};
+
+	enum class VertexFormat
+	{
+		//Vertex, full precision floats
+		eFloat,
+		//QuantizedVertex, decoded in mesh_quantized.vert
+		eQuantized
+	};
+
+	/*
+	* Material features the mesh pipelines are specialized for, see vkInit::PipelineVariants.
+	* Bit i is the bool specialization constant with constant_id i in the mesh vertex shaders.
+	*/
+	enum MaterialFeatures : uint32_t
+	{
+		//Diffuse sun lighting, off for KHR_materials_unlit materials
+		eFeatureLighting = 1 << 0,
+	};
+	constexpr uint32_t materialFeatureCount = 1;
+	constexpr uint32_t defaultMaterialFeatures = eFeatureLighting;
+
+	/*
+	* Per instance data, read by the mesh vertex shaders from binding 1 at instance rate. The
+	* transform is passed as four columns so every location has an attribute of its own.
+	* The mesh bounds and draw index are filled in by InstanceBatcher::build. Quantized positions are
+	* unorm inside the bounds, so mesh_quantized.vert decodes with them, and cull_instances.comp tests
+	* them against the frustum and counts survivors into the indirect command at drawIndex.
+	* materialIndex travels with the instance for the material table, the shaders don't read it yet.
+	* Keep in step with the InstanceData struct of culling.glsl.
+	*/
+	struct InstanceData
+	{
+		glm::mat4 transform{ 1.0f };
+		glm::vec4 color{ 1.0f };
+		glm::vec4 boundsMin{ 0.0f };
+		glm::vec4 boundsExtent{ 1.0f };
+		uint32_t materialIndex{ 0 };
+		uint32_t drawIndex{ 0 };
+		uint32_t padding[2]{ 0, 0 };
+
+		static vk::VertexInputBindingDescription binding_description()
+		{
+			vk::VertexInputBindingDescription bindingDescription;
+			bindingDescription.binding = 1;
+			bindingDescription.stride = sizeof(InstanceData);
+			bindingDescription.inputRate = vk::VertexInputRate::eInstance;
+			return bindingDescription;
+		}
+
+		static std::vector<vk::VertexInputAttributeDescription> attribute_descriptions(VertexFormat format = VertexFormat::eFloat)
+		{
+			std::vector<vk::VertexInputAttributeDescription> attributes(5);
+
+			//Transform columns
+			for (uint32_t column = 0; column < 4; column++)
+			{
+				attributes[column].binding = 1;
+				attributes[column].location = 4 + column;
+				attributes[column].format = vk::Format::eR32G32B32A32Sfloat;
+				attributes[column].offset = offsetof(InstanceData, transform) + column * sizeof(glm::vec4);
+			}
+
+			//Color
+			attributes[4].binding = 1;
+			attributes[4].location = 8;
+			attributes[4].format = vk::Format::eR32G32B32A32Sfloat;
+			attributes[4].offset = offsetof(InstanceData, color);
+
+			//Mesh bounds, to decode quantized positions
+			if (format == VertexFormat::eQuantized)
+			{
+				attributes.resize(7);
+				for (uint32_t i = 0; i < 2; i++)
+				{
+					attributes[5 + i].binding = 1;
+					attributes[5 + i].location = 9 + i;
+					attributes[5 + i].format = vk::Format::eR32G32B32A32Sfloat;
+					attributes[5 + i].offset = offsetof(InstanceData, boundsMin) + i * sizeof(glm::vec4);
+				}
+			}
+
+			return attributes;
+		}
+	};
+
+	//Push constants of the mesh pipelines, the same for every draw of a frame
+	struct MeshConstants
+	{
+		glm::mat4 viewProjection;
+	};
+
+	/*
+	* A cluster of at most meshletMaxVertices vertices and meshletMaxTriangles triangles, a contiguous
+	* range of its mesh's indices so it draws with an ordinary drawIndexed. The bounding sphere and the
+	* normal cone are in mesh space, cull_clusters.comp culls with them. Triangles all face away from
+	* any viewer inside the cone: dot(center - eye, coneAxis) >= coneCutoff * |center - eye| + radius.
+	* A coneCutoff of 1 means the triangles face too many ways for that. Stored as is in the mesh cache
+	* and the meshlet buffer, keep in step with the Meshlet struct of cull_clusters.comp.
+	*/
+	struct Meshlet
+	{
+		glm::vec3 center;
+		float radius;
+		glm::vec3 coneAxis;
+		float coneCutoff;
+
+		//Relative to the mesh's first index
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		uint32_t padding[2]{ 0, 0 };
+	};
+
+	constexpr uint32_t meshletMaxVertices = 64;
+	constexpr uint32_t meshletMaxTriangles = 124;
+
+	//Meshes with at least this many meshlets are culled and drawn a meshlet at a time, see Render/clusters.h
+	constexpr uint32_t clusteredMeshletCount = 8;
+
+	//CPU side geometry for one glTF primitive, as produced by the importer
+	struct MeshData
+	{
+		std::string name;
+		int materialIndex{ -1 };
+		uint32_t features{ defaultMaterialFeatures };
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<Meshlet> meshlets;
+		glm::vec3 boundsMin{ 0.0f };
+		glm::vec3 boundsMax{ 0.0f };
+	};
+
+	//Non-owning view of mesh geometry, backed by a MeshData or a memory mapped mesh cache
+	struct MeshView
+	{
+		const Vertex* vertices{ nullptr };
+		size_t vertexCount{ 0 };
+		const uint32_t* indices{ nullptr };
+		size_t indexCount{ 0 };
+		const Meshlet* meshlets{ nullptr };
+		size_t meshletCount{ 0 };
+		int materialIndex{ -1 };
+		uint32_t features{ defaultMaterialFeatures };
+		glm::vec3 boundsMin{ 0.0f };
+		glm::vec3 boundsMax{ 0.0f };
+
+		MeshView() = default;
+
+		MeshView(const MeshData& data) :
+			vertices(data.vertices.data()), vertexCount(data.vertices.size()),
+			indices(data.indices.data()), indexCount(data.indices.size()),
+			meshlets(data.meshlets.data()), meshletCount(data.meshlets.size()),
+			materialIndex(data.materialIndex), features(data.features), boundsMin(data.boundsMin), boundsMax(data.boundsMax) {}
+	};
+
+	//Placement of a mesh by a scene node
+	struct MeshInstance
+	{
+		uint32_t meshIndex;
+		glm::mat4 transform;
+
+		//False when an animation drives the node or one of its parents
+		bool isStatic;
+	};
+
+	//Everything the importer produces: meshes in their own space and the node transforms that place them
+	struct ModelData
+	{
+		std::vector<MeshData> meshes;
+		std::vector<MeshInstance> instances;
+	};
+
+	//GPU side geometry, a range of the shared geometry pool drawn with drawIndexed(indexCount, 1, firstIndex, vertexOffset, 0)
+	struct Mesh
+	{
+		uint32_t firstIndex{ 0 };
+		uint32_t indexCount{ 0 };
+		int32_t vertexOffset{ 0 };
+		VertexFormat vertexFormat{ VertexFormat::eFloat };
+		int materialIndex{ -1 };
+		uint32_t features{ defaultMaterialFeatures };
+		glm::vec3 boundsMin{ 0.0f };
+		glm::vec3 boundsMax{ 0.0f };
+
+		//Range of the pool's meshlet buffer
+		uint32_t firstMeshlet{ 0 };
+		uint32_t meshletCount{ 0 };
+
+		//Byte ranges in the pool buffers, to give them back
+		vk::DeviceSize vertexByteOffset{ 0 };
+		vk::DeviceSize vertexByteSize{ 0 };
+		vk::DeviceSize indexByteOffset{ 0 };
+		vk::DeviceSize indexByteSize{ 0 };
+		vk::DeviceSize meshletByteOffset{ 0 };
+		vk::DeviceSize meshletByteSize{ 0 };
+
+		bool clustered() const
+		{
+			return meshletCount >= clusteredMeshletCount;
+		}
+	};
+
+	/*
+	* One large vertex buffer and one large index buffer that every mesh is sub-allocated from,
+	* so a frame binds them once. Both vertex formats share the vertex buffer, each range is
+	* aligned to its own stride so vertexOffset stays a whole number of vertices. Meshlets go to a
+	* storage buffer of their own, read by the cluster culling pass.
+	*/
+	struct GeometryPool
+	{
+		vk::Buffer vertexBuffer;
+		vk::DeviceMemory vertexBufferMemory;
+		vkUtil::RangeAllocator vertexAllocator;
+
+		vk::Buffer indexBuffer;
+		vk::DeviceMemory indexBufferMemory;
+		vkUtil::RangeAllocator indexAllocator;
+
+		vk::Buffer meshletBuffer;
+		vk::DeviceMemory meshletBufferMemory;
+		vkUtil::RangeAllocator meshletAllocator;
+	};
+}
@@ -0,0 +1,238 @@
+#pragma once
+#include <Engine/config.h>
+#include <Core/mapped_file.h>
+#include "mesh.h"
+#include <filesystem>
+
+namespace vkMesh
+{
+	/*
+	* Cooked mesh file: a header, a table of entries, then vertex, index and meshlet blobs aligned to
+	* meshCacheAlignment. The blobs are laid out exactly as the GPU buffers expect them, so
+	* loading is a memory map and a copy into the staging buffer.
+	*/
+	constexpr uint32_t meshCacheMagic = 0x48534D42; //"BMSH"
+	constexpr uint32_t meshCacheVersion = 5;
+	constexpr size_t meshCacheAlignment = 64;
+
+	struct MeshCacheHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vertexStride;
+		uint32_t meshCount;
+
+		//Signature of the source asset, the cache is rebuilt when it changes
+		uint64_t sourceSize;
+		int64_t sourceTimestamp;
+	};
+
+	struct MeshCacheEntry
+	{
+		uint64_t vertexOffset;
+		uint64_t vertexCount;
+		uint64_t indexOffset;
+		uint64_t indexCount;
+		uint64_t meshletOffset;
+		uint64_t meshletCount;
+		int32_t materialIndex;
+		float boundsMin[3];
+		float boundsMax[3];
+		uint32_t features;
+	};
+
+	std::string mesh_cache_path(const std::string& sourcePath)
+	{
+		return sourcePath + ".bellmesh";
+	}
+
+	bool source_signature(const std::string& sourcePath, uint64_t& size, int64_t& timestamp)
+	{
+		std::error_code error;
+		size = std::filesystem::file_size(sourcePath, error);
+		if (error)
+			return false;
+
+		timestamp = static_cast<int64_t>(std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count());
+		return !error;
+	}
+
+	size_t align_cache_offset(size_t offset)
+	{
+		return (offset + meshCacheAlignment - 1) & ~(meshCacheAlignment - 1);
+	}
+
+	//Written to a temporary file first and renamed into place, so a crash never leaves a half written cache
+	bool write_mesh_cache(const std::string& cachePath, const std::string& sourcePath, const std::vector<MeshData>& meshes, bool debug)
+	{
+		//Nothing was imported, a cache would only hide the failure on the next run
+		if (meshes.empty())
+		{
+			if (debug)
+				std::cout << "No meshes to cache for \"" << sourcePath << "\"" << std::endl;
+			return false;
+		}
+
+		MeshCacheHeader header = {};
+		header.magic = meshCacheMagic;
+		header.version = meshCacheVersion;
+		header.vertexStride = sizeof(Vertex);
+		header.meshCount = static_cast<uint32_t>(meshes.size());
+		if (!source_signature(sourcePath, header.sourceSize, header.sourceTimestamp))
+			return false;
+
+		std::vector<MeshCacheEntry> entries(meshes.size());
+		size_t offset = align_cache_offset(sizeof(MeshCacheHeader) + entries.size() * sizeof(MeshCacheEntry));
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			MeshCacheEntry& entry = entries[i];
+			entry = {};
+			entry.vertexOffset = offset;
+			entry.vertexCount = meshes[i].vertices.size();
+			offset = align_cache_offset(offset + meshes[i].vertices.size() * sizeof(Vertex));
+			entry.indexOffset = offset;
+			entry.indexCount = meshes[i].indices.size();
+			offset = align_cache_offset(offset + meshes[i].indices.size() * sizeof(uint32_t));
+			entry.meshletOffset = offset;
+			entry.meshletCount = meshes[i].meshlets.size();
+			offset = align_cache_offset(offset + meshes[i].meshlets.size() * sizeof(Meshlet));
+			entry.materialIndex = meshes[i].materialIndex;
+			entry.features = meshes[i].features;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				entry.boundsMin[axis] = meshes[i].boundsMin[axis];
+				entry.boundsMax[axis] = meshes[i].boundsMax[axis];
+			}
+		}
+
+		std::vector<char> blob(offset, 0);
+		memcpy(blob.data(), &header, sizeof(header));
+		memcpy(blob.data() + sizeof(header), entries.data(), entries.size() * sizeof(MeshCacheEntry));
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			memcpy(blob.data() + entries[i].vertexOffset, meshes[i].vertices.data(), meshes[i].vertices.size() * sizeof(Vertex));
+			memcpy(blob.data() + entries[i].indexOffset, meshes[i].indices.data(), meshes[i].indices.size() * sizeof(uint32_t));
+			if (!meshes[i].meshlets.empty())
+				memcpy(blob.data() + entries[i].meshletOffset, meshes[i].meshlets.data(), meshes[i].meshlets.size() * sizeof(Meshlet));
+		}
+
+		std::string temporaryPath = cachePath + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open() || !file.write(blob.data(), blob.size()))
+			{
+				if (debug)
+					std::cout << "Failed to write mesh cache \"" << temporaryPath << "\"" << std::endl;
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, cachePath, error);
+		if (error)
+		{
+			if (debug)
+				std::cout << "Failed to move mesh cache into place: " << error.message() << std::endl;
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+
+		if (debug)
+			std::cout << "Wrote mesh cache \"" << cachePath << "\" (" << blob.size() << " bytes)" << std::endl;
+		return true;
+	}
+
+	//Every index names a vertex of its mesh and every meshlet lies inside the index range, a stale or corrupt
+	//cache would otherwise reach the GPU as out of range fetches
+	bool mesh_cache_entry_in_range(const MeshView& view)
+	{
+		for (size_t i = 0; i < view.indexCount; i++)
+		{
+			if (view.indices[i] >= view.vertexCount)
+				return false;
+		}
+		for (size_t i = 0; i < view.meshletCount; i++)
+		{
+			const Meshlet& meshlet = view.meshlets[i];
+			if (meshlet.indexCount == 0 || uint64_t(meshlet.firstIndex) + meshlet.indexCount > view.indexCount)
+				return false;
+		}
+		return true;
+	}
+
+	//A validated, memory mapped cache file, its views stay valid for as long as it is open
+	class MeshCache
+	{
+	public:
+
+		bool open(const std::string& cachePath, const std::string& sourcePath)
+		{
+			views.clear();
+			if (!file.open(cachePath) || file.size() < sizeof(MeshCacheHeader))
+				return false;
+
+			MeshCacheHeader header;
+			memcpy(&header, file.data(), sizeof(header));
+
+			uint64_t sourceSize = 0;
+			int64_t sourceTimestamp = 0;
+			bool sourceKnown = source_signature(sourcePath, sourceSize, sourceTimestamp);
+
+			//A missing source is fine, the cache can be shipped on its own
+			if (header.magic != meshCacheMagic || header.version != meshCacheVersion || header.vertexStride != sizeof(Vertex)
+				|| (sourceKnown && (header.sourceSize != sourceSize || header.sourceTimestamp != sourceTimestamp))
+				|| header.meshCount == 0 || sizeof(MeshCacheHeader) + size_t(header.meshCount) * sizeof(MeshCacheEntry) > file.size())
+			{
+				file.close();
+				return false;
+			}
+
+			const MeshCacheEntry* entries = reinterpret_cast<const MeshCacheEntry*>(file.data() + sizeof(MeshCacheHeader));
+			for (uint32_t i = 0; i < header.meshCount; i++)
+			{
+				const MeshCacheEntry& entry = entries[i];
+				if (entry.vertexCount > file.size() || entry.indexCount > file.size() || entry.meshletCount > file.size()
+					|| entry.vertexOffset + entry.vertexCount * sizeof(Vertex) > file.size()
+					|| entry.indexOffset + entry.indexCount * sizeof(uint32_t) > file.size()
+					|| entry.meshletOffset + entry.meshletCount * sizeof(Meshlet) > file.size()
+					|| entry.vertexOffset % meshCacheAlignment != 0 || entry.indexOffset % meshCacheAlignment != 0
+					|| entry.meshletOffset % meshCacheAlignment != 0)
+				{
+					views.clear();
+					file.close();
+					return false;
+				}
+
+				MeshView view;
+				view.vertices = reinterpret_cast<const Vertex*>(file.data() + entry.vertexOffset);
+				view.vertexCount = static_cast<size_t>(entry.vertexCount);
+				view.indices = reinterpret_cast<const uint32_t*>(file.data() + entry.indexOffset);
+				view.indexCount = static_cast<size_t>(entry.indexCount);
+				view.meshlets = reinterpret_cast<const Meshlet*>(file.data() + entry.meshletOffset);
+				view.meshletCount = static_cast<size_t>(entry.meshletCount);
+				view.materialIndex = entry.materialIndex;
+				view.features = entry.features;
+				view.boundsMin = glm::vec3(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]);
+				view.boundsMax = glm::vec3(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2]);
+				if (!mesh_cache_entry_in_range(view))
+				{
+					views.clear();
+					file.close();
+					return false;
+				}
+				views.push_back(view);
+			}
+			return true;
+		}
+
+		const std::vector<MeshView>& meshes() const
+		{
+			return views;
+		}
+
+	private:
+
+		vkUtil::MappedFile file;
+		std::vector<MeshView> views;
+	};
+}
@@ -0,0 +1,308 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+namespace vkMesh
+{
+	//Average number of post-transform cache misses per triangle for a FIFO cache, 0.5 is ideal and 3.0 is worst case
+	inline float average_cache_miss_ratio(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = 16)
+	{
+		if (indices.empty())
+			return 0.0f;
+
+		//Timestamp of when each vertex entered the cache, a vertex is still cached if fewer than cacheSize misses happened since
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t timestamp = cacheSize + 1;
+		uint32_t misses = 0;
+
+		for (uint32_t index : indices)
+		{
+			if (timestamp - cacheTimestamps[index] > cacheSize)
+			{
+				cacheTimestamps[index] = timestamp++;
+				misses++;
+			}
+		}
+
+		return float(misses) / float(indices.size() / 3);
+	}
+
+	/*
+	* Reorder triangles so vertices are reused while still in the post-transform cache,
+	* using Tom Forsyth's linear-speed vertex cache optimisation.
+	*/
+	inline void optimize_vertex_cache(std::vector<uint32_t>& indices, size_t vertexCount)
+	{
+		constexpr int cacheSize = 32;
+		constexpr float cacheDecayPower = 1.5f;
+		constexpr float lastTriangleScore = 0.75f;
+		constexpr float valenceBoostScale = 2.0f;
+		constexpr float valenceBoostPower = 0.5f;
+
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+			return;
+
+		auto vertex_score = [&](int cachePosition, uint32_t remainingTriangles) -> float
+		{
+			//Vertices with nothing left to draw shouldn't attract any triangles
+			if (remainingTriangles == 0)
+				return -1.0f;
+
+			float score = 0.0f;
+			if (cachePosition >= 0)
+			{
+				//The three most recent vertices belong to the last triangle, a fixed score stops them being too attractive
+				if (cachePosition < 3)
+					score = lastTriangleScore;
+				else
+					score = std::pow(1.0f - float(cachePosition - 3) / float(cacheSize - 3), cacheDecayPower);
+			}
+
+			//Favour vertices with few triangles left, so lone triangles aren't left behind
+			score += valenceBoostScale * std::pow(float(remainingTriangles), -valenceBoostPower);
+			return score;
+		};
+
+		//Vertex -> triangle adjacency, each vertex's live triangles are kept at the front of its range
+		std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+		for (uint32_t index : indices)
+			remainingTriangles[index]++;
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t i = 0; i < vertexCount; i++)
+			adjacencyOffsets[i + 1] = adjacencyOffsets[i] + remainingTriangles[i];
+
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> fillCursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+			adjacency[fillCursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+		std::vector<float> vertexScores(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+			vertexScores[i] = vertex_score(-1, remainingTriangles[i]);
+
+		std::vector<float> triangleScores(triangleCount);
+		std::vector<bool> emitted(triangleCount, false);
+		size_t bestTriangle = 0;
+		for (size_t i = 0; i < triangleCount; i++)
+		{
+			triangleScores[i] = vertexScores[indices[i * 3 + 0]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+			if (triangleScores[i] > triangleScores[bestTriangle])
+				bestTriangle = i;
+		}
+
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+		std::vector<uint32_t> cache, nextCache;
+		cache.reserve(cacheSize + 3);
+		nextCache.reserve(cacheSize + 3);
+		size_t scanCursor = 0;
+		bool haveBest = true;
+
+		for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+		{
+			//Nothing in the cache has triangles left, so fall back to the next unused triangle in input order
+			if (!haveBest)
+			{
+				while (emitted[scanCursor])
+					scanCursor++;
+				bestTriangle = scanCursor;
+			}
+
+			const uint32_t* triangle = &indices[bestTriangle * 3];
+			emitted[bestTriangle] = true;
+			output.insert(output.end(), triangle, triangle + 3);
+
+			//Remove the triangle from its vertices' live lists
+			for (int corner = 0; corner < 3; corner++)
+			{
+				uint32_t vertex = triangle[corner];
+				uint32_t* begin = &adjacency[adjacencyOffsets[vertex]];
+				uint32_t* end = begin + remainingTriangles[vertex];
+				uint32_t* found = std::find(begin, end, static_cast<uint32_t>(bestTriangle));
+				if (found != end)
+				{
+					std::swap(*found, *(end - 1));
+					remainingTriangles[vertex]--;
+				}
+			}
+
+			//LRU update: the triangle's vertices move to the front, anything pushed past the end is evicted
+			nextCache.clear();
+			nextCache.insert(nextCache.end(), triangle, triangle + 3);
+			for (uint32_t vertex : cache)
+			{
+				if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+					nextCache.push_back(vertex);
+			}
+
+			for (size_t i = 0; i < nextCache.size(); i++)
+			{
+				int position = i < static_cast<size_t>(cacheSize) ? static_cast<int>(i) : -1;
+				vertexScores[nextCache[i]] = vertex_score(position, remainingTriangles[nextCache[i]]);
+			}
+
+			//Only triangles touching the cache changed score, so the best candidate is among them
+			haveBest = false;
+			float bestScore = -1.0f;
+			for (uint32_t vertex : nextCache)
+			{
+				for (uint32_t i = 0; i < remainingTriangles[vertex]; i++)
+				{
+					uint32_t candidate = adjacency[adjacencyOffsets[vertex] + i];
+					const uint32_t* corners = &indices[candidate * 3];
+					triangleScores[candidate] = vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+					if (triangleScores[candidate] > bestScore)
+					{
+						bestScore = triangleScores[candidate];
+						bestTriangle = candidate;
+						haveBest = true;
+					}
+				}
+			}
+
+			nextCache.resize(std::min<size_t>(nextCache.size(), cacheSize));
+			std::swap(cache, nextCache);
+		}
+
+		indices.swap(output);
+	}
+
+	/*
+	* Reorder clusters of cache-optimised triangles so outward facing geometry is drawn first and
+	* occludes what's behind it (Sander et al. 2007). Cluster boundaries are placed where the cache
+	* goes cold, so vertex cache efficiency is kept. positions points at the first vertex position
+	* (3 floats), stride is the size of a vertex in bytes.
+	*/
+	inline void optimize_overdraw(std::vector<uint32_t>& indices, const float* positions, size_t vertexCount, size_t stride, uint32_t cacheSize = 16)
+	{
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+			return;
+
+		auto position = [&](uint32_t index) -> const float*
+		{
+			return reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + index * stride);
+		};
+
+		//Split wherever a triangle misses the cache on all three vertices, ie. the cache was effectively flushed
+		std::vector<size_t> clusterStarts;
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t timestamp = cacheSize + 1;
+		for (size_t i = 0; i < triangleCount; i++)
+		{
+			int misses = 0;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				uint32_t index = indices[i * 3 + corner];
+				if (timestamp - cacheTimestamps[index] > cacheSize)
+				{
+					cacheTimestamps[index] = timestamp++;
+					misses++;
+				}
+			}
+			if (i == 0 || misses == 3)
+				clusterStarts.push_back(i);
+		}
+		clusterStarts.push_back(triangleCount);
+
+		//Mesh centroid, used as the reference point for "outward"
+		float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+				meshCentroid[axis] += position(static_cast<uint32_t>(i))[axis];
+		}
+		for (int axis = 0; axis < 3; axis++)
+			meshCentroid[axis] /= float(std::max<size_t>(vertexCount, 1));
+
+		const size_t clusterCount = clusterStarts.size() - 1;
+		std::vector<float> sortKeys(clusterCount);
+		for (size_t cluster = 0; cluster < clusterCount; cluster++)
+		{
+			//Area weighted centroid and normal of the cluster
+			float centroid[3] = { 0.0f, 0.0f, 0.0f };
+			float normal[3] = { 0.0f, 0.0f, 0.0f };
+			float totalArea = 0.0f;
+
+			for (size_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; triangle++)
+			{
+				const float* a = position(indices[triangle * 3 + 0]);
+				const float* b = position(indices[triangle * 3 + 1]);
+				const float* c = position(indices[triangle * 3 + 2]);
+
+				float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+				float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+				float cross[3] = {
+					ab[1] * ac[2] - ab[2] * ac[1],
+					ab[2] * ac[0] - ab[0] * ac[2],
+					ab[0] * ac[1] - ab[1] * ac[0]
+				};
+				float area = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+
+				for (int axis = 0; axis < 3; axis++)
+				{
+					centroid[axis] += (a[axis] + b[axis] + c[axis]) / 3.0f * area;
+					normal[axis] += cross[axis];
+				}
+				totalArea += area;
+			}
+
+			float normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			float key = 0.0f;
+			if (totalArea > 0.0f && normalLength > 0.0f)
+			{
+				for (int axis = 0; axis < 3; axis++)
+					key += (centroid[axis] / totalArea - meshCentroid[axis]) * normal[axis] / normalLength;
+			}
+			sortKeys[cluster] = key;
+		}
+
+		std::vector<size_t> clusterOrder(clusterCount);
+		std::iota(clusterOrder.begin(), clusterOrder.end(), size_t(0));
+		std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+			[&](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+		for (size_t cluster : clusterOrder)
+		{
+			output.insert(output.end(),
+				indices.begin() + clusterStarts[cluster] * 3,
+				indices.begin() + clusterStarts[cluster + 1] * 3);
+		}
+		indices.swap(output);
+	}
+
+	/*
+	* Renumber vertices in the order the index buffer first uses them, so vertex fetch walks
+	* memory linearly. Unreferenced vertices are dropped.
+	*/
+	template<typename VertexType>
+	void optimize_vertex_fetch(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices)
+	{
+		constexpr uint32_t unused = ~0u;
+		std::vector<uint32_t> remap(vertices.size(), unused);
+		uint32_t nextVertex = 0;
+
+		for (uint32_t& index : indices)
+		{
+			if (remap[index] == unused)
+				remap[index] = nextVertex++;
+			index = remap[index];
+		}
+
+		std::vector<VertexType> reordered(nextVertex);
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			if (remap[i] != unused)
+				reordered[remap[i]] = vertices[i];
+		}
+		vertices.swap(reordered);
+	}
+}
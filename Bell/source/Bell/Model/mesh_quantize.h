@@ -0,0 +1,126 @@
+#pragma once
+#include <Engine/config.h>
+#include <gtc/packing.hpp>
+#include <algorithm>
+#include <cmath>
+#include "mesh.h"
+
+namespace vkMesh
+{
+	/*
+	* 20 byte vertex, against 48 for Vertex:
+	* position	16 bit unorm inside the mesh bounds, w holds the tangent handedness (0 or 1)
+	* normal	octahedral, 16 bit snorm
+	* tangent	octahedral, 16 bit snorm
+	* texcoord	half floats
+	*/
+	struct QuantizedVertex
+	{
+		uint16_t position[4];
+		int16_t normal[2];
+		int16_t tangent[2];
+		uint16_t texcoord[2];
+
+		static vk::VertexInputBindingDescription binding_description()
+		{
+			vk::VertexInputBindingDescription bindingDescription;
+			bindingDescription.binding = 0;
+			bindingDescription.stride = sizeof(QuantizedVertex);
+			bindingDescription.inputRate = vk::VertexInputRate::eVertex;
+			return bindingDescription;
+		}
+
+		static std::vector<vk::VertexInputAttributeDescription> attribute_descriptions()
+		{
+			std::vector<vk::VertexInputAttributeDescription> attributes(4);
+
+			//Position
+			attributes[0].binding = 0;
+			attributes[0].location = 0;
+			attributes[0].format = vk::Format::eR16G16B16A16Unorm;
+			attributes[0].offset = offsetof(QuantizedVertex, position);
+
+			//Normal
+			attributes[1].binding = 0;
+			attributes[1].location = 1;
+			attributes[1].format = vk::Format::eR16G16Snorm;
+			attributes[1].offset = offsetof(QuantizedVertex, normal);
+
+			//Texture coordinate
+			attributes[2].binding = 0;
+			attributes[2].location = 2;
+			attributes[2].format = vk::Format::eR16G16Sfloat;
+			attributes[2].offset = offsetof(QuantizedVertex, texcoord);
+
+			//Tangent
+			attributes[3].binding = 0;
+			attributes[3].location = 3;
+			attributes[3].format = vk::Format::eR16G16Snorm;
+			attributes[3].offset = offsetof(QuantizedVertex, tangent);
+
+			return attributes;
+		}
+	};
+
+	int16_t quantize_snorm16(float value)
+	{
+		return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	uint16_t quantize_unorm16(float value)
+	{
+		return static_cast<uint16_t>(std::round(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+	}
+
+	//Project a unit vector onto the octahedron and fold the lower half over the upper one, decoded by octahedral_decode in mesh_quantized.vert
+	glm::vec2 encode_octahedral(glm::vec3 direction)
+	{
+		float sum = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+		if (sum == 0.0f)
+			return glm::vec2(0.0f);
+
+		glm::vec2 encoded = glm::vec2(direction.x, direction.y) / sum;
+		if (direction.z < 0.0f)
+		{
+			glm::vec2 folded = 1.0f - glm::abs(glm::vec2(encoded.y, encoded.x));
+			encoded.x = encoded.x >= 0.0f ? folded.x : -folded.x;
+			encoded.y = encoded.y >= 0.0f ? folded.y : -folded.y;
+		}
+		return encoded;
+	}
+
+	//Positions are stored relative to the mesh bounds, each instance carries the offset and scale back to the shader
+	std::vector<QuantizedVertex> quantize_vertices(const MeshView& mesh)
+	{
+		glm::vec3 extent = mesh.boundsMax - mesh.boundsMin;
+		glm::vec3 inverseExtent(
+			extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+			extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+			extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+
+		std::vector<QuantizedVertex> quantized(mesh.vertexCount);
+		for (size_t i = 0; i < mesh.vertexCount; i++)
+		{
+			const Vertex& vertex = mesh.vertices[i];
+			QuantizedVertex& result = quantized[i];
+
+			glm::vec3 position = (vertex.position - mesh.boundsMin) * inverseExtent;
+			result.position[0] = quantize_unorm16(position.x);
+			result.position[1] = quantize_unorm16(position.y);
+			result.position[2] = quantize_unorm16(position.z);
+			result.position[3] = vertex.tangent.w < 0.0f ? 0 : 65535;
+
+			glm::vec2 normal = encode_octahedral(vertex.normal);
+			result.normal[0] = quantize_snorm16(normal.x);
+			result.normal[1] = quantize_snorm16(normal.y);
+
+			glm::vec2 tangent = encode_octahedral(glm::vec3(vertex.tangent));
+			result.tangent[0] = quantize_snorm16(tangent.x);
+			result.tangent[1] = quantize_snorm16(tangent.y);
+
+			result.texcoord[0] = glm::packHalf1x16(vertex.texcoord.x);
+			result.texcoord[1] = glm::packHalf1x16(vertex.texcoord.y);
+		}
+		return quantized;
+	}
+}
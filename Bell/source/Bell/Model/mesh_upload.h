@@ -0,0 +1,210 @@
+#pragma once
+#include <Engine/config.h>
+#include <Engine/memory.h>
+#include "mesh.h"
+#include "mesh_quantize.h"
+#include <functional>
+
+namespace vkMesh
+{
+	struct MeshUploadChunk
+	{
+		vk::Device logicalDevice;
+		vk::PhysicalDevice physicalDevice;
+		vk::Queue queue;
+		vk::CommandBuffer commandBuffer;
+		vkUtil::MemoryStatistics* statistics;
+
+		//Pool buffers replaced by a grow may still be read by a frame in flight
+		std::function<void(std::function<void()>&&)> deferDestroy;
+	};
+
+	vkUtil::BufferInputChunk pool_buffer_input(const MeshUploadChunk& input, vk::DeviceSize size, vk::BufferUsageFlags usage)
+	{
+		vkUtil::BufferInputChunk inputChunk = {};
+		inputChunk.logicalDevice = input.logicalDevice;
+		inputChunk.physicalDevice = input.physicalDevice;
+		inputChunk.size = size;
+		inputChunk.usage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst | usage;
+		inputChunk.memoryProperties = vk::MemoryPropertyFlagBits::eDeviceLocal;
+		inputChunk.category = vkUtil::MemoryCategory::eBuffer;
+		inputChunk.statistics = input.statistics;
+		return inputChunk;
+	}
+
+	//Copy data through a host visible staging buffer into a range of a device local buffer
+	void upload_to_buffer(const MeshUploadChunk& input, const void* data, size_t size, vk::Buffer destination, vk::DeviceSize offset)
+	{
+		vkUtil::BufferInputChunk inputChunk = {};
+		inputChunk.logicalDevice = input.logicalDevice;
+		inputChunk.physicalDevice = input.physicalDevice;
+		inputChunk.size = size;
+		inputChunk.usage = vk::BufferUsageFlagBits::eTransferSrc;
+		inputChunk.memoryProperties = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+		inputChunk.category = vkUtil::MemoryCategory::eStaging;
+		inputChunk.statistics = input.statistics;
+		vkUtil::Buffer stagingBuffer = vkUtil::createBuffer(inputChunk);
+
+		void* memoryLocation = input.logicalDevice.mapMemory(stagingBuffer.bufferMemory, 0, size);
+		memcpy(memoryLocation, data, size);
+		input.logicalDevice.unmapMemory(stagingBuffer.bufferMemory);
+
+		vkUtil::Buffer destinationBuffer = { destination, nullptr, 0 };
+		vkUtil::copyBuffer(stagingBuffer, destinationBuffer, size, input.queue, input.commandBuffer, offset);
+
+		vkUtil::destroyBuffer(input.logicalDevice, stagingBuffer, input.statistics);
+	}
+
+	GeometryPool make_geometry_pool(const MeshUploadChunk& input, vk::DeviceSize vertexCapacity, vk::DeviceSize indexCapacity,
+		vk::DeviceSize meshletCapacity)
+	{
+		GeometryPool pool;
+
+		vkUtil::Buffer vertexBuffer = vkUtil::createBuffer(pool_buffer_input(input, vertexCapacity, vk::BufferUsageFlagBits::eVertexBuffer));
+		pool.vertexBuffer = vertexBuffer.buffer;
+		pool.vertexBufferMemory = vertexBuffer.bufferMemory;
+		pool.vertexAllocator.reset(vertexCapacity);
+
+		vkUtil::Buffer indexBuffer = vkUtil::createBuffer(pool_buffer_input(input, indexCapacity, vk::BufferUsageFlagBits::eIndexBuffer));
+		pool.indexBuffer = indexBuffer.buffer;
+		pool.indexBufferMemory = indexBuffer.bufferMemory;
+		pool.indexAllocator.reset(indexCapacity);
+
+		vkUtil::Buffer meshletBuffer = vkUtil::createBuffer(pool_buffer_input(input, meshletCapacity, vk::BufferUsageFlagBits::eStorageBuffer));
+		pool.meshletBuffer = meshletBuffer.buffer;
+		pool.meshletBufferMemory = meshletBuffer.bufferMemory;
+		pool.meshletAllocator.reset(meshletCapacity);
+
+		//Report what the meshes occupy rather than the whole reservation, so the statistics show the slack
+		if (input.statistics)
+		{
+			input.statistics->set_used(pool.vertexBufferMemory, 0);
+			input.statistics->set_used(pool.indexBufferMemory, 0);
+			input.statistics->set_used(pool.meshletBufferMemory, 0);
+		}
+
+		return pool;
+	}
+
+	//Reallocate a pool buffer with room for at least extraBytes more, existing ranges keep their offsets
+	void grow_pool_buffer(const MeshUploadChunk& input, vk::Buffer& buffer, vk::DeviceMemory& memory, vkUtil::RangeAllocator& allocator,
+		vk::DeviceSize extraBytes, vk::BufferUsageFlags usage)
+	{
+		vk::DeviceSize capacity = std::max(allocator.capacity() * 2, allocator.capacity() + extraBytes);
+		vkUtil::Buffer grown = vkUtil::createBuffer(pool_buffer_input(input, capacity, usage));
+
+		vkUtil::Buffer previous = { buffer, memory, allocator.capacity() };
+		if (allocator.capacity() > 0)
+			vkUtil::copyBuffer(previous, grown, allocator.capacity(), input.queue, input.commandBuffer);
+
+		vk::Device device = input.logicalDevice;
+		vkUtil::MemoryStatistics* statistics = input.statistics;
+		input.deferDestroy([device, previous, statistics]() mutable
+			{
+				vkUtil::destroyBuffer(device, previous, statistics);
+			});
+
+		buffer = grown.buffer;
+		memory = grown.bufferMemory;
+		allocator.grow(capacity);
+	}
+
+	//Sub-allocate a range, growing the buffer when no free range is big enough
+	vk::DeviceSize allocate_pool_range(const MeshUploadChunk& input, vk::Buffer& buffer, vk::DeviceMemory& memory, vkUtil::RangeAllocator& allocator,
+		vk::DeviceSize size, vk::DeviceSize alignment, vk::BufferUsageFlags usage)
+	{
+		vk::DeviceSize offset = 0;
+		if (!allocator.allocate(size, alignment, offset))
+		{
+			grow_pool_buffer(input, buffer, memory, allocator, size + alignment, usage);
+			allocator.allocate(size, alignment, offset);
+		}
+
+		if (input.statistics)
+			input.statistics->set_used(memory, allocator.used());
+
+		return offset;
+	}
+
+	Mesh upload_mesh(const MeshView& data, GeometryPool& pool, const MeshUploadChunk& input, VertexFormat format)
+	{
+		Mesh mesh;
+		mesh.vertexFormat = format;
+
+		std::vector<QuantizedVertex> quantized;
+		const void* vertices = data.vertices;
+		vk::DeviceSize stride = sizeof(Vertex);
+		if (format == VertexFormat::eQuantized)
+		{
+			quantized = quantize_vertices(data);
+			vertices = quantized.data();
+			stride = sizeof(QuantizedVertex);
+		}
+
+		mesh.vertexByteSize = data.vertexCount * stride;
+		mesh.vertexByteOffset = allocate_pool_range(input, pool.vertexBuffer, pool.vertexBufferMemory, pool.vertexAllocator,
+			mesh.vertexByteSize, stride, vk::BufferUsageFlagBits::eVertexBuffer);
+		upload_to_buffer(input, vertices, mesh.vertexByteSize, pool.vertexBuffer, mesh.vertexByteOffset);
+
+		mesh.indexByteSize = data.indexCount * sizeof(uint32_t);
+		mesh.indexByteOffset = allocate_pool_range(input, pool.indexBuffer, pool.indexBufferMemory, pool.indexAllocator,
+			mesh.indexByteSize, sizeof(uint32_t), vk::BufferUsageFlagBits::eIndexBuffer);
+		upload_to_buffer(input, data.indices, mesh.indexByteSize, pool.indexBuffer, mesh.indexByteOffset);
+
+		if (data.meshletCount > 0)
+		{
+			mesh.meshletByteSize = data.meshletCount * sizeof(Meshlet);
+			mesh.meshletByteOffset = allocate_pool_range(input, pool.meshletBuffer, pool.meshletBufferMemory, pool.meshletAllocator,
+				mesh.meshletByteSize, sizeof(Meshlet), vk::BufferUsageFlagBits::eStorageBuffer);
+			upload_to_buffer(input, data.meshlets, mesh.meshletByteSize, pool.meshletBuffer, mesh.meshletByteOffset);
+			mesh.firstMeshlet = static_cast<uint32_t>(mesh.meshletByteOffset / sizeof(Meshlet));
+			mesh.meshletCount = static_cast<uint32_t>(data.meshletCount);
+		}
+
+		mesh.firstIndex = static_cast<uint32_t>(mesh.indexByteOffset / sizeof(uint32_t));
+		mesh.indexCount = static_cast<uint32_t>(data.indexCount);
+		mesh.vertexOffset = static_cast<int32_t>(mesh.vertexByteOffset / stride);
+		mesh.materialIndex = data.materialIndex;
+		mesh.features = data.features;
+		mesh.boundsMin = data.boundsMin;
+		mesh.boundsMax = data.boundsMax;
+
+		return mesh;
+	}
+
+	//Give a mesh's ranges back to the pool, the caller makes sure no frame in flight still draws it
+	void free_mesh(GeometryPool& pool, Mesh& mesh, vkUtil::MemoryStatistics* statistics)
+	{
+		pool.vertexAllocator.free(mesh.vertexByteOffset, mesh.vertexByteSize);
+		pool.indexAllocator.free(mesh.indexByteOffset, mesh.indexByteSize);
+		if (mesh.meshletByteSize > 0)
+			pool.meshletAllocator.free(mesh.meshletByteOffset, mesh.meshletByteSize);
+		mesh.vertexByteSize = 0;
+		mesh.indexByteSize = 0;
+		mesh.meshletByteSize = 0;
+		mesh.meshletCount = 0;
+
+		if (statistics)
+		{
+			statistics->set_used(pool.vertexBufferMemory, pool.vertexAllocator.used());
+			statistics->set_used(pool.indexBufferMemory, pool.indexAllocator.used());
+			statistics->set_used(pool.meshletBufferMemory, pool.meshletAllocator.used());
+		}
+	}
+
+	void destroy_geometry_pool(vk::Device device, GeometryPool& pool, vkUtil::MemoryStatistics* statistics)
+	{
+		vkUtil::Buffer vertexBuffer = { pool.vertexBuffer, pool.vertexBufferMemory, 0 };
+		vkUtil::destroyBuffer(device, vertexBuffer, statistics);
+
+		vkUtil::Buffer indexBuffer = { pool.indexBuffer, pool.indexBufferMemory, 0 };
+		vkUtil::destroyBuffer(device, indexBuffer, statistics);
+
+		vkUtil::Buffer meshletBuffer = { pool.meshletBuffer, pool.meshletBufferMemory, 0 };
+		vkUtil::destroyBuffer(device, meshletBuffer, statistics);
+
+		pool.vertexBuffer = nullptr;
+		pool.indexBuffer = nullptr;
+		pool.meshletBuffer = nullptr;
+	}
+}
@@ -0,0 +1,235 @@
+#pragma once
+#include <Engine/config.h>
+#include "mesh.h"
+#include "mesh_optimizer.h"
+
+namespace vkMesh
+{
+	//Bounding sphere and normal cone of the triangles indices[first, first + count)
+	Meshlet make_meshlet(const MeshData& mesh, uint32_t firstIndex, uint32_t indexCount)
+	{
+		Meshlet meshlet = {};
+		meshlet.firstIndex = firstIndex;
+		meshlet.indexCount = indexCount;
+
+		//Centered on the box, a little looser than the smallest sphere but cheap and never too small
+		glm::vec3 boundsMin = mesh.vertices[mesh.indices[firstIndex]].position;
+		glm::vec3 boundsMax = boundsMin;
+		for (uint32_t i = firstIndex; i < firstIndex + indexCount; i++)
+		{
+			boundsMin = glm::min(boundsMin, mesh.vertices[mesh.indices[i]].position);
+			boundsMax = glm::max(boundsMax, mesh.vertices[mesh.indices[i]].position);
+		}
+		meshlet.center = 0.5f * (boundsMin + boundsMax);
+		meshlet.radius = 0.0f;
+		for (uint32_t i = firstIndex; i < firstIndex + indexCount; i++)
+			meshlet.radius = std::max(meshlet.radius, glm::length(mesh.vertices[mesh.indices[i]].position - meshlet.center));
+
+		//Face normals from the winding, which is what the rasterizer culls by, not the shading normals
+		std::vector<glm::vec3> normals;
+		normals.reserve(indexCount / 3);
+		glm::vec3 normalSum(0.0f);
+		for (uint32_t i = firstIndex; i + 2 < firstIndex + indexCount; i += 3)
+		{
+			const glm::vec3& a = mesh.vertices[mesh.indices[i + 0]].position;
+			const glm::vec3& b = mesh.vertices[mesh.indices[i + 1]].position;
+			const glm::vec3& c = mesh.vertices[mesh.indices[i + 2]].position;
+			glm::vec3 normal = glm::cross(b - a, c - a);
+			float length = glm::length(normal);
+			if (length <= 0.0f)
+				continue;
+			normals.push_back(normal / length);
+			normalSum += normal / length;
+		}
+
+		//The cone is the average normal widened to the normal furthest from it. Past a hemisphere some
+		//triangle faces every viewer, so the meshlet is never backfacing
+		meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+		meshlet.coneCutoff = 1.0f;
+		float sumLength = glm::length(normalSum);
+		if (sumLength <= 0.0f)
+			return meshlet;
+		meshlet.coneAxis = normalSum / sumLength;
+
+		float minimumDot = 1.0f;
+		for (const glm::vec3& normal : normals)
+			minimumDot = std::min(minimumDot, glm::dot(normal, meshlet.coneAxis));
+		if (minimumDot > 0.0f)
+			meshlet.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+
+		return meshlet;
+	}
+
+	/*
+	* Split a mesh into meshlets by greedy growth. Each meshlet starts from the first triangle left in
+	* index order, then keeps taking the neighbouring triangle that brings in the fewest new vertices,
+	* the one nearest the meshlet's middle on a tie, until either limit would be passed. Triangles with
+	* no neighbour left continue from index order, so scattered pieces still fill meshlets. The indices
+	* are reordered so every meshlet is a contiguous range.
+	*/
+	void build_meshlets(MeshData& mesh, uint32_t maxVertices = meshletMaxVertices, uint32_t maxTriangles = meshletMaxTriangles)
+	{
+		mesh.meshlets.clear();
+		const size_t triangleCount = mesh.indices.size() / 3;
+		const size_t vertexCount = mesh.vertices.size();
+		if (triangleCount == 0)
+			return;
+
+		//Vertex -> triangle adjacency
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+			adjacencyOffsets[mesh.indices[i] + 1]++;
+		for (size_t i = 0; i < vertexCount; i++)
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+
+		std::vector<uint32_t> adjacency(triangleCount * 3);
+		std::vector<uint32_t> fillCursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+			adjacency[fillCursor[mesh.indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+		std::vector<bool> emitted(triangleCount, false);
+
+		//Which meshlet last took each vertex, so membership tests are a lookup
+		constexpr uint32_t none = ~0u;
+		std::vector<uint32_t> vertexMeshlet(vertexCount, none);
+		uint32_t meshletIndex = 0;
+
+		std::vector<uint32_t> output;
+		output.reserve(triangleCount * 3);
+		std::vector<uint32_t> meshletVertices;
+		meshletVertices.reserve(maxVertices);
+		uint32_t meshletTriangles = 0;
+		uint32_t meshletFirstIndex = 0;
+		glm::vec3 positionSum(0.0f);
+		size_t scanCursor = 0;
+
+		auto new_vertices = [&](uint32_t triangle)
+			{
+				uint32_t count = 0;
+				for (int corner = 0; corner < 3; corner++)
+				{
+					if (vertexMeshlet[mesh.indices[triangle * 3 + corner]] != meshletIndex)
+						count++;
+				}
+				return count;
+			};
+
+		auto finish_meshlet = [&]()
+			{
+				uint32_t indexCount = static_cast<uint32_t>(output.size()) - meshletFirstIndex;
+				if (indexCount > 0)
+				{
+					Meshlet meshlet = {};
+					meshlet.firstIndex = meshletFirstIndex;
+					meshlet.indexCount = indexCount;
+					mesh.meshlets.push_back(meshlet);
+					meshletIndex++;
+				}
+				meshletFirstIndex = static_cast<uint32_t>(output.size());
+				meshletVertices.clear();
+				meshletTriangles = 0;
+				positionSum = glm::vec3(0.0f);
+			};
+
+		for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+		{
+			//Neighbours of the meshlet, fewest new vertices first, then nearest to its middle
+			uint32_t bestTriangle = none;
+			uint32_t bestNew = 4;
+			float bestDistance = 0.0f;
+			glm::vec3 middle = meshletVertices.empty() ? glm::vec3(0.0f) : positionSum / float(meshletVertices.size());
+			for (uint32_t vertex : meshletVertices)
+			{
+				for (uint32_t i = adjacencyOffsets[vertex]; i < adjacencyOffsets[vertex + 1]; i++)
+				{
+					uint32_t triangle = adjacency[i];
+					if (emitted[triangle])
+						continue;
+
+					uint32_t newCount = new_vertices(triangle);
+					if (newCount > bestNew)
+						continue;
+
+					const uint32_t* corners = &mesh.indices[triangle * 3];
+					glm::vec3 centroid = (mesh.vertices[corners[0]].position + mesh.vertices[corners[1]].position + mesh.vertices[corners[2]].position) / 3.0f;
+					float distance = glm::dot(centroid - middle, centroid - middle);
+					if (newCount < bestNew || distance < bestDistance)
+					{
+						bestTriangle = triangle;
+						bestNew = newCount;
+						bestDistance = distance;
+					}
+				}
+			}
+
+			if (bestTriangle == none)
+			{
+				while (emitted[scanCursor])
+					scanCursor++;
+				bestTriangle = static_cast<uint32_t>(scanCursor);
+				bestNew = new_vertices(bestTriangle);
+			}
+
+			if (meshletVertices.size() + bestNew > maxVertices || meshletTriangles + 1 > maxTriangles)
+			{
+				finish_meshlet();
+				bestNew = 3;
+			}
+
+			const uint32_t* corners = &mesh.indices[bestTriangle * 3];
+			for (int corner = 0; corner < 3; corner++)
+			{
+				uint32_t vertex = corners[corner];
+				if (vertexMeshlet[vertex] != meshletIndex)
+				{
+					vertexMeshlet[vertex] = meshletIndex;
+					meshletVertices.push_back(vertex);
+					positionSum += mesh.vertices[vertex].position;
+				}
+			}
+			output.insert(output.end(), corners, corners + 3);
+			emitted[bestTriangle] = true;
+			meshletTriangles++;
+		}
+		finish_meshlet();
+
+		mesh.indices.swap(output);
+		for (Meshlet& meshlet : mesh.meshlets)
+			meshlet = make_meshlet(mesh, meshlet.firstIndex, meshlet.indexCount);
+
+		//Growth order isn't first use order, renumbering only changes index values so the ranges hold
+		optimize_vertex_fetch(mesh.vertices, mesh.indices);
+	}
+
+	/*
+	* The import step, after static batching has made the meshes as large as they get. Meshes too
+	* small to be clustered are drawn whole, so they get back the vertex cache and overdraw order
+	* the importer gave them and keep no meshlets.
+	*/
+	void build_meshlets(std::vector<MeshData>& meshes, bool debug)
+	{
+		size_t meshletCount = 0;
+		size_t clusteredCount = 0;
+		for (MeshData& mesh : meshes)
+		{
+			std::vector<Vertex> vertices = mesh.vertices;
+			std::vector<uint32_t> indices = mesh.indices;
+			build_meshlets(mesh);
+			if (mesh.meshlets.size() < clusteredMeshletCount)
+			{
+				mesh.vertices.swap(vertices);
+				mesh.indices.swap(indices);
+				mesh.meshlets.clear();
+				continue;
+			}
+			meshletCount += mesh.meshlets.size();
+			clusteredCount++;
+		}
+
+		if (debug)
+		{
+			std::cout << "Split " << clusteredCount << " of " << meshes.size() << " mesh(es) into " << meshletCount
+				<< " meshlet(s) to be culled per meshlet" << std::endl;
+		}
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <Engine/config.h>
+#include "mesh.h"
+#include <map>
+
+namespace vkMesh
+{
+	//Append a mesh moved into world space, mirrored transforms flip the winding back so culling still works
+	void append_transformed(MeshData& batch, const MeshData& mesh, const glm::mat4& transform)
+	{
+		glm::mat3 linear(transform);
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(linear));
+		bool mirrored = glm::determinant(linear) < 0.0f;
+
+		uint32_t baseVertex = static_cast<uint32_t>(batch.vertices.size());
+		for (const Vertex& vertex : mesh.vertices)
+		{
+			Vertex placed = vertex;
+			placed.position = glm::vec3(transform * glm::vec4(vertex.position, 1.0f));
+
+			glm::vec3 normal = normalMatrix * vertex.normal;
+			float normalLength = glm::length(normal);
+			placed.normal = normalLength > 0.0f ? normal / normalLength : vertex.normal;
+
+			glm::vec3 tangent = linear * glm::vec3(vertex.tangent);
+			float tangentLength = glm::length(tangent);
+			placed.tangent = glm::vec4(tangentLength > 0.0f ? tangent / tangentLength : glm::vec3(vertex.tangent),
+				mirrored ? -vertex.tangent.w : vertex.tangent.w);
+
+			batch.vertices.push_back(placed);
+		}
+
+		for (size_t i = 0; i < mesh.indices.size(); i += 3)
+		{
+			batch.indices.push_back(baseVertex + mesh.indices[i]);
+			batch.indices.push_back(baseVertex + mesh.indices[i + (mirrored ? 2 : 1)]);
+			batch.indices.push_back(baseVertex + mesh.indices[i + (mirrored ? 1 : 2)]);
+		}
+	}
+
+	void compute_bounds(MeshData& mesh)
+	{
+		if (mesh.vertices.empty())
+			return;
+
+		mesh.boundsMin = mesh.vertices[0].position;
+		mesh.boundsMax = mesh.vertices[0].position;
+		for (const Vertex& vertex : mesh.vertices)
+		{
+			mesh.boundsMin = glm::min(mesh.boundsMin, vertex.position);
+			mesh.boundsMax = glm::max(mesh.boundsMax, vertex.position);
+		}
+	}
+
+	/*
+	* Bake every static instance into world space and merge the ones sharing a material into
+	* a single mesh, so a material costs one draw no matter how many nodes use it. Animated
+	* instances are kept apart, placed at their rest pose.
+	*/
+	std::vector<MeshData> build_static_batches(const ModelData& model, bool debug)
+	{
+		std::vector<MeshData> batches;
+		std::map<int, size_t> materialBatches;
+
+		for (const MeshInstance& instance : model.instances)
+		{
+			if (instance.meshIndex >= model.meshes.size())
+				continue;
+			const MeshData& mesh = model.meshes[instance.meshIndex];
+
+			if (!instance.isStatic)
+			{
+				MeshData placed;
+				placed.name = mesh.name;
+				placed.materialIndex = mesh.materialIndex;
+				placed.features = mesh.features;
+				append_transformed(placed, mesh, instance.transform);
+				batches.push_back(std::move(placed));
+				continue;
+			}
+
+			auto found = materialBatches.find(mesh.materialIndex);
+			if (found == materialBatches.end())
+			{
+				found = materialBatches.emplace(mesh.materialIndex, batches.size()).first;
+				MeshData batch;
+				batch.name = "static/material " + std::to_string(mesh.materialIndex);
+				batch.materialIndex = mesh.materialIndex;
+				batch.features = mesh.features;
+				batches.push_back(std::move(batch));
+			}
+			append_transformed(batches[found->second], mesh, instance.transform);
+		}
+
+		for (MeshData& batch : batches)
+			compute_bounds(batch);
+
+		if (debug)
+		{
+			std::cout << "Static batching: " << model.instances.size() << " instance(s) of " << model.meshes.size()
+				<< " mesh(es) into " << batches.size() << " draw(s)" << std::endl;
+		}
+
+		return batches;
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <Engine/config.h>
+#include <Model/mesh.h>
+#include "instancing.h"
+#include "indirect.h"
+
+namespace vkUtil
+{
+	/*
+	* Meshlet culling, for meshes too large for culling them whole to help, see vkMesh::Meshlet.
+	* Every instance of a clustered mesh is a job, and every meshlet of a job owns an indirect command
+	* that cull_clusters.comp rewrites each frame, drawing it once or not at all. The CPU writes only
+	* the jobs. The commands of a pipeline are contiguous, so they draw as buckets like the batches do.
+	*/
+
+	//Keep in step with the ClusterJob struct of cull_clusters.comp
+	struct ClusterJob
+	{
+		//Index into the sorted instances, also the firstInstance of the job's draws
+		uint32_t instanceIndex;
+		uint32_t firstMeshlet;
+		uint32_t meshletCount;
+		uint32_t firstCommand;
+
+		//The mesh's place in the geometry pool, meshlets are relative to it
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		uint32_t padding[2];
+	};
+
+	//Push constants of cull_clusters.comp, no tail padding like CullConstants
+	struct ClusterCullConstants
+	{
+		glm::mat4 viewProjection;
+		glm::vec4 cameraPosition;
+		uint32_t jobCount;
+		uint32_t drawOffset;
+	};
+
+	ClusterCullConstants make_cluster_cull_constants(const glm::mat4& viewProjection, const glm::vec3& cameraPosition, uint32_t jobCount,
+		uint32_t drawOffset = 0)
+	{
+		ClusterCullConstants constants = {};
+		constants.viewProjection = viewProjection;
+		constants.cameraPosition = glm::vec4(cameraPosition, 1.0f);
+		constants.jobCount = jobCount;
+		constants.drawOffset = drawOffset;
+		return constants;
+	}
+
+	//Jobs for every instance of a clustered mesh, in batch order so the buckets come out by pipeline.
+	//Returns the number of commands, maxMeshletCount is the most any job has, the width of the dispatch
+	uint32_t build_cluster_jobs(const std::vector<InstanceBatch>& batches, const std::vector<vkMesh::Mesh>& meshes,
+		std::vector<ClusterJob>& jobs, std::vector<IndirectBucket>& buckets, uint32_t& maxMeshletCount)
+	{
+		jobs.clear();
+		buckets.clear();
+		maxMeshletCount = 0;
+
+		uint32_t commandCount = 0;
+		for (const InstanceBatch& batch : batches)
+		{
+			const vkMesh::Mesh& mesh = meshes[batch.meshIndex];
+			if (!mesh.clustered())
+				continue;
+
+			if (buckets.empty() || !same_pipeline(meshes[buckets.back().meshIndex], mesh))
+				buckets.push_back({ batch.meshIndex, commandCount, 0 });
+
+			for (uint32_t i = 0; i < batch.instanceCount; i++)
+			{
+				ClusterJob job = {};
+				job.instanceIndex = batch.firstInstance + i;
+				job.firstMeshlet = mesh.firstMeshlet;
+				job.meshletCount = mesh.meshletCount;
+				job.firstCommand = commandCount;
+				job.firstIndex = mesh.firstIndex;
+				job.vertexOffset = mesh.vertexOffset;
+				jobs.push_back(job);
+
+				commandCount += mesh.meshletCount;
+				buckets.back().commandCount += mesh.meshletCount;
+			}
+			maxMeshletCount = std::max(maxMeshletCount, mesh.meshletCount);
+		}
+		return commandCount;
+	}
+}
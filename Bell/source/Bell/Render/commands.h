@@ -31,7 +31,8 @@ namespace vkInit
 		}
 	}
 
-	vk::CommandBuffer make_command_buffers(commandBufferInputChunk inputChunk, bool debug)
+	//One per swapchain image, made again when the swapchain is
+	void make_frame_command_buffers(commandBufferInputChunk inputChunk, bool debug)
 	{
 		vk::CommandBufferAllocateInfo allocInfo = {};
 		allocInfo.commandPool = inputChunk.commandPool;
@@ -55,6 +56,16 @@ namespace vkInit
 					std::cout << "Failed to allocate command buffer for frame " << i << std::endl;
 			}
 		}
+	}
+
+	//The main command buffer, for work outside the frame loop such as uploads
+	vk::CommandBuffer make_command_buffer(commandBufferInputChunk inputChunk, bool debug)
+	{
+		vk::CommandBufferAllocateInfo allocInfo = {};
+		allocInfo.commandPool = inputChunk.commandPool;
+		allocInfo.level = vk::CommandBufferLevel::ePrimary;
+		allocInfo.commandBufferCount = 1;
+
 		try
 		{
 			vk::CommandBuffer commandBuffer = inputChunk.device.allocateCommandBuffers(allocInfo)[0];
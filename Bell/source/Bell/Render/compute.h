@@ -0,0 +1,143 @@
+#pragma once
+#include <Engine/config.h>
+
+namespace vkUtil
+{
+	/*
+	* Everything a dispatch binds. Compute work is recorded into the frame's graphics command
+	* buffer, so it shares the graphics queue and is ordered against draws with the barriers below.
+	*/
+	struct ComputeDispatch
+	{
+		vk::Pipeline pipeline;
+		vk::PipelineLayout layout;
+		std::vector<vk::DescriptorSet> descriptorSets;
+
+		//Pushed to the compute stage at offset 0, nothing is pushed when size is 0
+		const void* pushConstants = nullptr;
+		uint32_t pushConstantSize = 0;
+
+		//The shader's local_size, see ShaderReflection::workgroupSize
+		glm::uvec3 workgroupSize{ 1, 1, 1 };
+	};
+
+	//Workgroups needed to cover count items, the shader skips the ones past the end
+	uint32_t group_count(uint32_t count, uint32_t groupSize)
+	{
+		return (count + groupSize - 1) / groupSize;
+	}
+
+	void bind_compute(vk::CommandBuffer commandBuffer, const ComputeDispatch& dispatch)
+	{
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, dispatch.pipeline);
+		if (!dispatch.descriptorSets.empty())
+		{
+			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, dispatch.layout, 0,
+				static_cast<uint32_t>(dispatch.descriptorSets.size()), dispatch.descriptorSets.data(), 0, nullptr);
+		}
+		if (dispatch.pushConstantSize > 0)
+			commandBuffer.pushConstants(dispatch.layout, vk::ShaderStageFlagBits::eCompute, 0, dispatch.pushConstantSize, dispatch.pushConstants);
+	}
+
+	void dispatch(vk::CommandBuffer commandBuffer, const ComputeDispatch& dispatch, uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1)
+	{
+		bind_compute(commandBuffer, dispatch);
+		commandBuffer.dispatch(groupsX, groupsY, groupsZ);
+	}
+
+	//One invocation per item along x, rounded up to whole workgroups
+	void dispatch_items(vk::CommandBuffer commandBuffer, const ComputeDispatch& dispatch, uint32_t itemCount)
+	{
+		if (itemCount == 0)
+			return;
+		vkUtil::dispatch(commandBuffer, dispatch, group_count(itemCount, dispatch.workgroupSize.x));
+	}
+
+	//Group counts read from a VkDispatchIndirectCommand in buffer, eg. written by an earlier pass
+	void dispatch_indirect(vk::CommandBuffer commandBuffer, const ComputeDispatch& dispatch, vk::Buffer buffer, vk::DeviceSize offset = 0)
+	{
+		bind_compute(commandBuffer, dispatch);
+		commandBuffer.dispatchIndirect(buffer, offset);
+	}
+
+	/*
+	* Execution and memory dependency between two passes. Buffers written by one pass and read by
+	* the next only need a global memory barrier, images also change layout and go through
+	* image_barrier instead.
+	*/
+	struct PassDependency
+	{
+		vk::PipelineStageFlags srcStage;
+		vk::AccessFlags srcAccess;
+		vk::PipelineStageFlags dstStage;
+		vk::AccessFlags dstAccess;
+	};
+
+	//Storage buffers written by a dispatch, read back as draw commands, vertices, indices or shader data
+	PassDependency compute_to_graphics()
+	{
+		return { vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderWrite,
+			vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader,
+			vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eShaderRead };
+	}
+
+	//One dispatch feeding the next, indirect dispatches included
+	PassDependency compute_to_compute()
+	{
+		return { vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderWrite,
+			vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eDrawIndirect,
+			vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eIndirectCommandRead };
+	}
+
+	//Buffers the graphics pass read, or the depth it wrote, before a dispatch overwrites or reads them
+	PassDependency graphics_to_compute()
+	{
+		return { vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader
+			| vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
+			vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead
+			| vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+			vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite };
+	}
+
+	//A depth buffer sampled by a dispatch, then drawn to again
+	PassDependency compute_to_depth_attachment()
+	{
+		return { vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead,
+			vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
+			vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite };
+	}
+
+	//Buffers cleared or copied by transfer commands before a dispatch uses them
+	PassDependency transfer_to_compute()
+	{
+		return { vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite,
+			vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite };
+	}
+
+	void memory_barrier(vk::CommandBuffer commandBuffer, const PassDependency& dependency)
+	{
+		vk::MemoryBarrier barrier = {};
+		barrier.srcAccessMask = dependency.srcAccess;
+		barrier.dstAccessMask = dependency.dstAccess;
+		commandBuffer.pipelineBarrier(dependency.srcStage, dependency.dstStage, vk::DependencyFlags(), 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	void image_barrier(vk::CommandBuffer commandBuffer, const PassDependency& dependency, vk::Image image, vk::ImageAspectFlags aspect,
+		vk::ImageLayout oldLayout, vk::ImageLayout newLayout, uint32_t baseMipLevel = 0, uint32_t mipLevelCount = VK_REMAINING_MIP_LEVELS)
+	{
+		vk::ImageMemoryBarrier barrier = {};
+		barrier.srcAccessMask = dependency.srcAccess;
+		barrier.dstAccessMask = dependency.dstAccess;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = aspect;
+		barrier.subresourceRange.baseMipLevel = baseMipLevel;
+		barrier.subresourceRange.levelCount = mipLevelCount;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		commandBuffer.pipelineBarrier(dependency.srcStage, dependency.dstStage, vk::DependencyFlags(), 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <Engine/config.h>
+
+namespace vkUtil
+{
+	/*
+	* GPU culling. cull_instances.comp reads the frame's instances, drops the ones whose bounding
+	* sphere is outside the frustum and packs the rest into a second instance buffer, counting them
+	* into the instanceCount of their indirect command. The graphics pass then draws the same
+	* commands from the packed buffer, so the CPU does no work per object.
+	*
+	* Occlusion culling runs it twice around a depth pyramid, see Engine::record_draw_commands.
+	* The second run writes the second copy of the commands, drawOffset commands further on.
+	* Meshes with enough meshlets are culled a meshlet at a time instead, see clusters.h.
+	*/
+
+	//Push constants of cull_instances.comp, the frustum planes are taken from the matrix there.
+	//No tail padding, the pushed size has to fit the shader's block
+	struct CullConstants
+	{
+		glm::mat4 viewProjection;
+		uint32_t instanceCount;
+		uint32_t drawOffset;
+	};
+
+	CullConstants make_cull_constants(const glm::mat4& viewProjection, uint32_t instanceCount, uint32_t drawOffset = 0)
+	{
+		CullConstants constants = {};
+		constants.viewProjection = viewProjection;
+		constants.instanceCount = instanceCount;
+		constants.drawOffset = drawOffset;
+		return constants;
+	}
+}
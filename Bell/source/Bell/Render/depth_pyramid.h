@@ -0,0 +1,176 @@
+#pragma once
+#include <Engine/config.h>
+#include <Engine/image.h>
+#include <Engine/descriptors.h>
+#include "compute.h"
+
+namespace vkUtil
+{
+	struct DepthPyramidInput
+	{
+		vk::Device device;
+		vk::PhysicalDevice physicalDevice;
+		vk::Extent2D depthExtent;
+
+		//Set 0 of depth_pyramid.comp: the level read at binding 0, the level written at binding 1
+		vk::DescriptorSetLayout setLayout;
+		MemoryStatistics* statistics;
+	};
+
+	/*
+	* Max reduction of a depth buffer for occlusion culling. Level 0 is half the depth resolution and
+	* every texel of a level holds the farthest depth of the texels it covers one level up, so anything
+	* whose nearest depth is behind every texel its screen rectangle touches is hidden. Built by
+	* depth_pyramid.comp, one dispatch per level, and left in the general layout for sampling.
+	* Size dependent, it's made again with the swapchain.
+	*/
+	class DepthPyramid
+	{
+	public:
+
+		DepthPyramid(const DepthPyramidInput& input, bool debug)
+		{
+			device = input.device;
+			statistics = input.statistics;
+
+			//Halved until a single texel remains, odd sizes round down and the shader reads three texels
+			extent.width = std::max(input.depthExtent.width / 2, 1u);
+			extent.height = std::max(input.depthExtent.height / 2, 1u);
+			levelCount = 1;
+			while ((std::max(extent.width, extent.height) >> levelCount) > 0)
+				levelCount++;
+
+			vkImage::ImageInputChunk imageInfo = {};
+			imageInfo.logicalDevice = input.device;
+			imageInfo.physicalDevice = input.physicalDevice;
+			imageInfo.width = extent.width;
+			imageInfo.height = extent.height;
+			imageInfo.tiling = vk::ImageTiling::eOptimal;
+			imageInfo.usage = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled;
+			imageInfo.memoryProperties = vk::MemoryPropertyFlagBits::eDeviceLocal;
+			imageInfo.format = vk::Format::eR32Sfloat;
+			imageInfo.category = MemoryCategory::eRenderTarget;
+			imageInfo.statistics = input.statistics;
+			imageInfo.mipLevels = levelCount;
+			image = vkImage::make_image(imageInfo);
+			memory = vkImage::make_image_memory(imageInfo, image);
+			wholeView = vkImage::make_image_view(device, image, imageInfo.format, vk::ImageAspectFlagBits::eColor, 0, levelCount);
+			for (uint32_t level = 0; level < levelCount; level++)
+				levelViews.push_back(vkImage::make_image_view(device, image, imageInfo.format, vk::ImageAspectFlagBits::eColor, level, 1));
+
+			//Texels are read exactly, from any level
+			vk::SamplerCreateInfo samplerInfo = {};
+			samplerInfo.magFilter = vk::Filter::eNearest;
+			samplerInfo.minFilter = vk::Filter::eNearest;
+			samplerInfo.mipmapMode = vk::SamplerMipmapMode::eNearest;
+			samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+			samplerInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+			samplerInfo.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+			samplerInfo.minLod = 0.0f;
+			samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+			try
+			{
+				pointSampler = device.createSampler(samplerInfo);
+			}
+			catch (vk::SystemError err)
+			{
+				if (debug)
+					std::cout << "Failed to create depth pyramid sampler" << std::endl;
+			}
+
+			//Level i reads level i - 1 and writes level i, level 0 reads the depth buffer given to record
+			std::vector<vk::DescriptorPoolSize> poolSizes = {
+				vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, levelCount),
+				vk::DescriptorPoolSize(vk::DescriptorType::eStorageImage, levelCount) };
+			descriptorPool = vkInit::make_descriptor_pool(device, poolSizes, levelCount, debug);
+			for (uint32_t level = 0; level < levelCount; level++)
+			{
+				vk::DescriptorSet set = vkInit::allocate_descriptor_set(device, descriptorPool, input.setLayout, debug);
+				if (level > 0)
+				{
+					vkInit::write_image_descriptor(device, set, 0, vk::DescriptorType::eCombinedImageSampler,
+						levelViews[level - 1], vk::ImageLayout::eGeneral, pointSampler);
+				}
+				vkInit::write_image_descriptor(device, set, 1, vk::DescriptorType::eStorageImage, levelViews[level], vk::ImageLayout::eGeneral);
+				levelSets.push_back(set);
+			}
+
+			if (debug)
+				std::cout << "Made a " << extent.width << "x" << extent.height << " depth pyramid with " << levelCount << " level(s)" << std::endl;
+		}
+
+		~DepthPyramid()
+		{
+			device.destroyDescriptorPool(descriptorPool);
+			device.destroySampler(pointSampler);
+			for (vk::ImageView view : levelViews)
+				device.destroyImageView(view);
+			device.destroyImageView(wholeView);
+			device.destroyImage(image);
+			if (statistics)
+				statistics->untrack(memory);
+			device.freeMemory(memory);
+		}
+
+		//Reduce a depth buffer, in the depth stencil read only layout, into every level. The dispatch
+		//carries depth_pyramid.comp's pipeline, layout and workgroup size
+		void record(vk::CommandBuffer commandBuffer, const ComputeDispatch& dispatch, vk::ImageView depthView)
+		{
+			//Each swapchain image has its own depth buffer, the set isn't in use while recording
+			if (depthView != sourceView)
+			{
+				vkInit::write_image_descriptor(device, levelSets[0], 0, vk::DescriptorType::eCombinedImageSampler,
+					depthView, vk::ImageLayout::eDepthStencilReadOnlyOptimal, pointSampler);
+				sourceView = depthView;
+			}
+
+			//Last frame's contents are never read again, so every level starts out undefined
+			image_barrier(commandBuffer, graphics_to_compute(), image, vk::ImageAspectFlagBits::eColor,
+				vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral);
+
+			ComputeDispatch levelDispatch = dispatch;
+			for (uint32_t level = 0; level < levelCount; level++)
+			{
+				uint32_t width = std::max(extent.width >> level, 1u);
+				uint32_t height = std::max(extent.height >> level, 1u);
+				levelDispatch.descriptorSets = { levelSets[level] };
+				vkUtil::dispatch(commandBuffer, levelDispatch,
+					group_count(width, dispatch.workgroupSize.x), group_count(height, dispatch.workgroupSize.y));
+				memory_barrier(commandBuffer, compute_to_compute());
+			}
+		}
+
+		//Every level, for the occlusion test
+		vk::ImageView view() const
+		{
+			return wholeView;
+		}
+
+		vk::Sampler sampler() const
+		{
+			return pointSampler;
+		}
+
+		uint32_t level_count() const
+		{
+			return levelCount;
+		}
+
+	private:
+
+		vk::Device device;
+		MemoryStatistics* statistics;
+		vk::Extent2D extent;
+		uint32_t levelCount;
+
+		vk::Image image;
+		vk::DeviceMemory memory;
+		vk::ImageView wholeView;
+		std::vector<vk::ImageView> levelViews;
+		vk::Sampler pointSampler;
+
+		vk::DescriptorPool descriptorPool;
+		std::vector<vk::DescriptorSet> levelSets;
+		vk::ImageView sourceView;
+	};
+}
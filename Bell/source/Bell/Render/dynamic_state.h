@@ -0,0 +1,44 @@
+#pragma once
+#include <Engine/config.h>
+
+namespace vkUtil
+{
+	//Rasterizer and depth state a pass sets on pipelines made with extendedDynamicState
+	struct RasterState
+	{
+		vk::CullModeFlags cullMode = vk::CullModeFlagBits::eBack;
+		vk::FrontFace frontFace = vk::FrontFace::eClockwise;
+		bool depthTest = true;
+		bool depthWrite = true;
+		vk::CompareOp depthCompareOp = vk::CompareOp::eLess;
+	};
+
+	//Pipelines leave the viewport and scissor dynamic, so every pass sets them for its target
+	void set_viewport(vk::CommandBuffer commandBuffer, vk::Extent2D extent)
+	{
+		vk::Viewport viewport = {};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		commandBuffer.setViewport(0, 1, &viewport);
+
+		vk::Rect2D scissor = {};
+		scissor.offset.x = 0;
+		scissor.offset.y = 0;
+		scissor.extent = extent;
+		commandBuffer.setScissor(0, 1, &scissor);
+	}
+
+	//The EXT entry points aren't exported by the loader library, they come through the device dispatcher
+	void set_raster_state(vk::CommandBuffer commandBuffer, const RasterState& state, const vk::DispatchLoaderDynamic& dispatch)
+	{
+		commandBuffer.setCullModeEXT(state.cullMode, dispatch);
+		commandBuffer.setFrontFaceEXT(state.frontFace, dispatch);
+		commandBuffer.setDepthTestEnableEXT(state.depthTest, dispatch);
+		commandBuffer.setDepthWriteEnableEXT(state.depthWrite, dispatch);
+		commandBuffer.setDepthCompareOpEXT(state.depthCompareOp, dispatch);
+	}
+}
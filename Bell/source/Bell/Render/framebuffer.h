@@ -1,6 +1,7 @@
 #pragma once
 #include <Engine/config.h>
 #include <Engine/frame.h>
+#include <Engine/image.h>
 
 namespace vkInit
 {
@@ -16,7 +17,8 @@ namespace vkInit
 		for (int i = 0; i < frames.size(); i++)
 		{
 			std::vector<vk::ImageView> attachments = {
-				frames[i].imageView
+				frames[i].imageView,
+				frames[i].depthBufferView
 			};
 			
 			vk::FramebufferCreateInfo framebufferInfo = {};
@@ -42,4 +44,45 @@ namespace vkInit
 			}
 		}
 	}
-}
\ No newline at end of file
+
+	struct depthResourcesInput
+	{
+		vk::Device device;
+		vk::PhysicalDevice physicalDevice;
+		vk::Format depthFormat;
+		vk::Extent2D swapchainExtent;
+		vkUtil::MemoryStatistics* statistics;
+
+		//Also read by shaders, eg. to build the depth pyramid
+		bool sampled{ false };
+	};
+
+	void make_depth_resources(depthResourcesInput inputChunk, std::vector<vkUtil::SwapChainFrame>& frames, bool debug)
+	{
+		vkImage::ImageInputChunk imageInfo = {};
+		imageInfo.logicalDevice = inputChunk.device;
+		imageInfo.physicalDevice = inputChunk.physicalDevice;
+		imageInfo.width = inputChunk.swapchainExtent.width;
+		imageInfo.height = inputChunk.swapchainExtent.height;
+		imageInfo.tiling = vk::ImageTiling::eOptimal;
+		imageInfo.usage = vk::ImageUsageFlagBits::eDepthStencilAttachment;
+		if (inputChunk.sampled)
+			imageInfo.usage |= vk::ImageUsageFlagBits::eSampled;
+		imageInfo.memoryProperties = vk::MemoryPropertyFlagBits::eDeviceLocal;
+		imageInfo.format = inputChunk.depthFormat;
+		imageInfo.category = vkUtil::MemoryCategory::eRenderTarget;
+		imageInfo.statistics = inputChunk.statistics;
+
+		for (int i = 0; i < frames.size(); i++)
+		{
+			frames[i].depthBuffer = vkImage::make_image(imageInfo);
+			frames[i].depthBufferMemory = vkImage::make_image_memory(imageInfo, frames[i].depthBuffer);
+			frames[i].depthBufferView = vkImage::make_image_view(
+				inputChunk.device, frames[i].depthBuffer, inputChunk.depthFormat, vk::ImageAspectFlagBits::eDepth
+			);
+
+			if (debug)
+				std::cout << "Created depth buffer for frame " << i << std::endl;
+		}
+	}
+}
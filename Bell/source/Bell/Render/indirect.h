@@ -0,0 +1,83 @@
+#pragma once
+#include <Engine/config.h>
+#include <Model/mesh.h>
+#include "instancing.h"
+
+namespace vkUtil
+{
+	/*
+	* Multi-draw indirect submission. Each instance batch becomes one VkDrawIndexedIndirectCommand,
+	* and a run of batches drawn with the same pipeline is a bucket, submitted with a single
+	* drawIndexedIndirect. Every mesh lives in the geometry pool and every instance in the
+	* instance buffer, so nothing needs rebinding between the draws of a bucket.
+	*/
+
+	//Commands [firstCommand, firstCommand + commandCount) of the indirect buffer, all drawn with the
+	//pipeline of meshIndex
+	struct IndirectBucket
+	{
+		uint32_t meshIndex;
+		uint32_t firstCommand;
+		uint32_t commandCount;
+	};
+
+	constexpr uint32_t indirectCommandStride = sizeof(vk::DrawIndexedIndirectCommand);
+
+	//Batches share a pipeline when their meshes share vertex format and material features
+	bool same_pipeline(const vkMesh::Mesh& a, const vkMesh::Mesh& b)
+	{
+		return a.vertexFormat == b.vertexFormat && a.features == b.features;
+	}
+
+	//InstanceBatcher::build orders batches by pipeline, so each bucket is a run of consecutive batches.
+	//With skipClustered, clustered meshes are left to build_cluster_jobs. Their batches keep a command,
+	//so drawIndex still finds the right one, but it draws nothing and belongs to no bucket
+	void build_indirect_commands(const std::vector<InstanceBatch>& batches, const std::vector<vkMesh::Mesh>& meshes,
+		std::vector<vk::DrawIndexedIndirectCommand>& commands, std::vector<IndirectBucket>& buckets, bool skipClustered = false)
+	{
+		commands.clear();
+		buckets.clear();
+
+		bool bucketOpen = false;
+		for (const InstanceBatch& batch : batches)
+		{
+			const vkMesh::Mesh& mesh = meshes[batch.meshIndex];
+			bool skipped = skipClustered && mesh.clustered();
+
+			vk::DrawIndexedIndirectCommand command;
+			command.indexCount = skipped ? 0 : mesh.indexCount;
+			command.instanceCount = batch.instanceCount;
+			command.firstIndex = mesh.firstIndex;
+			command.vertexOffset = mesh.vertexOffset;
+			command.firstInstance = batch.firstInstance;
+
+			if (skipped)
+			{
+				bucketOpen = false;
+			}
+			else
+			{
+				if (!bucketOpen || !same_pipeline(meshes[buckets.back().meshIndex], mesh))
+					buckets.push_back({ batch.meshIndex, static_cast<uint32_t>(commands.size()), 0 });
+				buckets.back().commandCount++;
+				bucketOpen = true;
+			}
+			commands.push_back(command);
+		}
+	}
+
+	//maxDrawCount is vkInit::max_indirect_draw_count, a bucket larger than it takes several calls.
+	//commandOffset moves to another copy of the commands in the same buffer
+	void draw_indirect_bucket(vk::CommandBuffer commandBuffer, vk::Buffer indirectBuffer, const IndirectBucket& bucket, uint32_t maxDrawCount,
+		uint32_t commandOffset = 0)
+	{
+		uint32_t drawn = 0;
+		while (drawn < bucket.commandCount)
+		{
+			uint32_t count = std::min(bucket.commandCount - drawn, maxDrawCount);
+			vk::DeviceSize offset = vk::DeviceSize(commandOffset + bucket.firstCommand + drawn) * indirectCommandStride;
+			commandBuffer.drawIndexedIndirect(indirectBuffer, offset, count, indirectCommandStride);
+			drawn += count;
+		}
+	}
+}
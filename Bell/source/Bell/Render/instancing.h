@@ -0,0 +1,117 @@
+#pragma once
+#include <Engine/config.h>
+#include <Model/mesh.h>
+#include <algorithm>
+
+namespace vkUtil
+{
+	//One instanced draw: instanceCount instances of a mesh, starting at firstInstance in the instance buffer
+	struct InstanceBatch
+	{
+		uint32_t meshIndex;
+		uint32_t firstInstance;
+		uint32_t instanceCount;
+	};
+
+	/*
+	* Collects a frame's mesh instances and merges the ones drawing the same mesh into a single
+	* instanced draw. A mesh has one material, so sharing a mesh means sharing the pipeline and
+	* everything bound for it. Batches come out ordered by pipeline so binds happen once per
+	* pipeline, and each batch's instances are contiguous in instances(). An instance's drawIndex
+	* is the index of its batch, and so of its indirect command, see build_indirect_commands.
+	*/
+	class InstanceBatcher
+	{
+	public:
+
+		void submit(uint32_t meshIndex, const vkMesh::InstanceData& instance)
+		{
+			submissions.push_back({ meshIndex, instance });
+		}
+
+		//Counting sort on the mesh index, linear in the number of instances
+		void build(const std::vector<vkMesh::Mesh>& meshes)
+		{
+			sortedInstances.clear();
+			meshBatches.clear();
+
+			std::vector<uint32_t> counts(meshes.size(), 0);
+			for (const Submission& submission : submissions)
+			{
+				if (submission.meshIndex < meshes.size())
+					counts[submission.meshIndex]++;
+			}
+
+			//Meshes that share a pipeline next to each other: vertex format, then material features
+			std::vector<uint32_t> order;
+			for (uint32_t i = 0; i < meshes.size(); i++)
+			{
+				if (counts[i] > 0)
+					order.push_back(i);
+			}
+			std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+				{
+					if (meshes[a].vertexFormat != meshes[b].vertexFormat)
+						return meshes[a].vertexFormat < meshes[b].vertexFormat;
+					return meshes[a].features < meshes[b].features;
+				});
+
+			std::vector<uint32_t> cursors(meshes.size(), 0);
+			std::vector<uint32_t> batchIndices(meshes.size(), 0);
+			uint32_t firstInstance = 0;
+			for (uint32_t meshIndex : order)
+			{
+				batchIndices[meshIndex] = static_cast<uint32_t>(meshBatches.size());
+				meshBatches.push_back({ meshIndex, firstInstance, counts[meshIndex] });
+				cursors[meshIndex] = firstInstance;
+				firstInstance += counts[meshIndex];
+			}
+
+			sortedInstances.resize(firstInstance);
+			for (const Submission& submission : submissions)
+			{
+				if (submission.meshIndex >= meshes.size())
+					continue;
+
+				const vkMesh::Mesh& mesh = meshes[submission.meshIndex];
+				vkMesh::InstanceData& instance = sortedInstances[cursors[submission.meshIndex]++];
+				instance = submission.instance;
+				instance.boundsMin = glm::vec4(mesh.boundsMin, 0.0f);
+				instance.boundsExtent = glm::vec4(mesh.boundsMax - mesh.boundsMin, 0.0f);
+				instance.drawIndex = batchIndices[submission.meshIndex];
+			}
+		}
+
+		void clear()
+		{
+			submissions.clear();
+		}
+
+		size_t submission_count() const
+		{
+			return submissions.size();
+		}
+
+		const std::vector<vkMesh::InstanceData>& instances() const
+		{
+			return sortedInstances;
+		}
+
+		const std::vector<InstanceBatch>& batches() const
+		{
+			return meshBatches;
+		}
+
+	private:
+
+		struct Submission
+		{
+			uint32_t meshIndex;
+			vkMesh::InstanceData instance;
+		};
+
+		std::vector<Submission> submissions;
+		std::vector<vkMesh::InstanceData> sortedInstances;
+		std::vector<InstanceBatch> meshBatches;
+	};
+}
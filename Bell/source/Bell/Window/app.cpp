@@ -14,7 +14,7 @@ void App::buid_glfw_window(int width, int height, bool debugMode)
 
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 
-	glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
 	if (window = glfwCreateWindow(width, height, "Bell Engine", nullptr, nullptr)) {
 		if (debugMode)
@@ -36,6 +36,21 @@ void App::run()
 	}
 }
 
+void App::load_model(const char* filename, vkMesh::VertexFormat format)
+{
+	graphicsEngine->load_model(filename, format);
+}
+
+void App::enable_shader_hot_reload()
+{
+	graphicsEngine->enable_shader_hot_reload();
+}
+
+void App::dump_pipeline_report(const char* filename)
+{
+	graphicsEngine->dump_pipeline_report(filename);
+}
+
 void App::calculateFrameRate()
 {
 	currentTime = glfwGetTime();
@@ -20,4 +20,7 @@ public:
 	App(int width, int height, bool debug);
 	~App();
 	void run();
+	void load_model(const char* filename, vkMesh::VertexFormat format);
+	void enable_shader_hot_reload();
+	void dump_pipeline_report(const char* filename);
 };
\ No newline at end of file
@@ -1,10 +1,35 @@
 #include "Window/app.h"
 
-int main()
+int main(int argc, char** argv)
 {
 	App* app = new App(640, 480, true);
 
+	//Optional glTF/glb file to display, --quantize stores it with the compact vertex format,
+	//--hot-reload rebuilds pipelines when their shaders are saved, --pipeline-report <file> writes
+	//how long every pipeline took to create when the window closes
+	vkMesh::VertexFormat format = vkMesh::VertexFormat::eFloat;
+	const char* filename = nullptr;
+	bool hotReload = false;
+	const char* pipelineReport = nullptr;
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--quantize")
+			format = vkMesh::VertexFormat::eQuantized;
+		else if (std::string(argv[i]) == "--hot-reload")
+			hotReload = true;
+		else if (std::string(argv[i]) == "--pipeline-report" && i + 1 < argc)
+			pipelineReport = argv[++i];
+		else
+			filename = argv[i];
+	}
+	if (filename)
+		app->load_model(filename, format);
+	if (hotReload)
+		app->enable_shader_hot_reload();
+
 	app->run();
+	if (pipelineReport)
+		app->dump_pipeline_report(pipelineReport);
 	delete app;
 
 	return 0;